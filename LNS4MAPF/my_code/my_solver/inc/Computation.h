@@ -11,6 +11,7 @@
 #include <memory>
 #include <random>
 #include <thread>
+#include <vector>
 
 #include "Instance.h"
 #include "LNS.h"
@@ -30,10 +31,49 @@ public:
    * @param shared_data_ The shared data object for communication between threads.
    * @param lns_settings_ The settings for the LNS solver.
    * @param seed The seed for the random number generator.
+   * @param portfolio_size_ The number of LNS solvers run in parallel with diversified settings, 1 runs a single solver.
    */
-  Computation(const Instance& instance_, SharedData* shared_data_, LNS_settings lns_settings_, int seed);
+  Computation(const Instance& instance_, SharedData* shared_data_, LNS_settings lns_settings_, int seed, int portfolio_size_ = 1);
 
-  void set_safety_params(bool safety_aware, int human_start, int door_loc);
+  /**
+   * @brief Sets the safety check of all solvers.
+   *
+   * @param safety_aware Whether the solutions have to keep the humans safe.
+   * @param human_starts The start locations of the humans.
+   * @param door_locs The locations of the exits.
+   */
+  void set_safety_params(bool safety_aware, const std::vector<int>& human_starts, const std::vector<int>& door_locs);
+
+  /**
+   * @brief Reports an observed position of a human to all solvers while they run. The path of the human is replanned from the position
+   * and the robots blocking its escape are repaired within the update budget of the LNS settings.
+   * @throws std::runtime_error if the human, the location or the time is invalid.
+   *
+   * @param human The index of the human.
+   * @param location The observed location of the human.
+   * @param time The step of the human path, at which the human was observed.
+   */
+  void update_human_position(int human, int location, int time);
+
+  /**
+   * @brief Retrieves the last solution verified to keep the humans safe, unlike get_solution it can be called while the solver runs.
+   *
+   * @return The safe solution, nullptr if the safety is not checked or no safe solution was found yet.
+   */
+  [[nodiscard]] auto get_safe_solution() const -> std::shared_ptr<const Solution>
+  {
+    return solver->get_safe_solution();
+  }
+
+  /**
+   * @brief Checks whether the safe solution was verified against the last applied human positions.
+   *
+   * @return True if the safe solution keeps the humans safe on their current paths, false if it is stale or there is none.
+   */
+  [[nodiscard]] auto is_safe_solution_current() const -> bool
+  {
+    return solver->is_safe_solution_current();
+  }
 
 
   /**
@@ -73,6 +113,22 @@ public:
     return solver->solution;
   }
 
+  /**
+   * @brief Retrieve the safety of each step of the human paths in the final solution, it is evaluated once when the solver finishes.
+   * @warning This function should only be called after the solver has finished.
+   * @throws std::runtime_error if the solver is still running.
+   *
+   * @return The safety of each step of each human, empty if the safety is not checked.
+   */
+  auto get_safety_timeline() -> const std::vector<std::vector<SafetyStep>>&
+  {
+    if (running.load(std::memory_order_acquire))
+    {
+      throw std::runtime_error("Trying to access the safety timeline before the solver finished.");
+    }
+    return safety_timeline;
+  }
+
   /**
    * @brief The main function that runs the computation, which is called in the thread.
    */
@@ -81,6 +137,15 @@ public:
   std::atomic<bool> running; /**< Indicates whether the computation is running. */
 
 private:
+  /**
+   * @brief Creates the settings of a portfolio member by varying the destroy strategy, the neighborhood size and the SIPP implementation.
+   *
+   * @param member The index of the member, the member 0 uses the given settings.
+   *
+   * @return The settings of the member.
+   */
+  [[nodiscard]] auto get_portfolio_settings(int member) const -> LNS_settings;
+
   std::unique_ptr<LNS> solver;      /**< Pointer to the LNS solver. */
   std::thread          comp_thread; /**< The computation thread. */
 
@@ -89,4 +154,12 @@ private:
   int             seed;          /**< The seed for the random number generator. */
   std::mt19937    rnd_generator; /**< Random number generator. */
   LNS_settings    lns_settings;  /**< The settings for the LNS solver. */
+
+  std::vector<std::vector<SafetyStep>> safety_timeline; /**< The safety of each step of the human paths in the final solution. */
+
+  int                               portfolio_size;       /**< The number of LNS solvers in the portfolio. */
+  SharedSolution                    shared_solution;      /**< The best solution shared by the portfolio. */
+  std::vector<LNS_settings>         portfolio_settings;   /**< The settings of the other portfolio members. */
+  std::vector<std::mt19937>         portfolio_generators; /**< The random generators of the other portfolio members. */
+  std::vector<std::unique_ptr<LNS>> portfolio;            /**< The other portfolio members, the solver is the first member. */
 };
@@ -8,9 +8,10 @@
 
 #pragma once
 
+#include <array>
 #include <climits>
 #include <iostream>
-#include <list>
+#include <limits>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -113,6 +114,189 @@ private:
   const Instance& instance;         /**< The instance of the problem. */
 };
 
+/**
+ * @brief A compact counter of agents visiting a single location. The entries (agent number, number of visits) are kept sorted by the
+ * agent number in a small inline buffer, most locations are visited only by a few agents. Only when more agents visit the location, the
+ * entries spill over to a heap allocated vector.
+ */
+class AgentCounts
+{
+public:
+  using value_type     = std::pair<int, int>; /**< The agent number along with the number of its visits. */
+  using const_iterator = const value_type*;   /**< Iterator over the entries sorted by the agent number. */
+
+  /**
+   * @brief Increases the number of visits of the given agent, the agent is added if it is not present yet.
+   *
+   * @param agent_num The number of the agent.
+   */
+  void increment(int agent_num);
+
+  /**
+   * @brief Decreases the number of visits of the given agent, the agent is removed when the count drops to zero.
+   *
+   * @param agent_num The number of the agent, it has to be present.
+   */
+  void decrement(int agent_num);
+
+  /**
+   * @brief Returns how many times the given agent visits the location.
+   *
+   * @param agent_num The number of the agent.
+   *
+   * @return The number of visits, 0 if the agent does not visit the location.
+   */
+  [[nodiscard]] auto count(int agent_num) const -> int;
+
+  /**
+   * @brief Returns the number of different agents visiting the location.
+   *
+   * @return The number of agents.
+   */
+  [[nodiscard]] auto size() const -> size_t
+  {
+    return static_cast<size_t>(num_entries);
+  }
+
+  /**
+   * @brief Checks whether no agent visits the location.
+   *
+   * @return True if there are no agents, false otherwise.
+   */
+  [[nodiscard]] auto empty() const -> bool
+  {
+    return num_entries == 0;
+  }
+
+  /**
+   * @brief Returns the iterator to the first entry.
+   *
+   * @return The iterator to the first entry.
+   */
+  [[nodiscard]] auto begin() const -> const_iterator
+  {
+    return data();
+  }
+
+  /**
+   * @brief Returns the iterator behind the last entry.
+   *
+   * @return The iterator behind the last entry.
+   */
+  [[nodiscard]] auto end() const -> const_iterator
+  {
+    return data() + num_entries;
+  }
+
+private:
+  static constexpr int INLINE_CAPACITY = 4; /**< The number of agents stored without a heap allocation. */
+
+  /**
+   * @brief Checks whether the entries spilled over to the heap.
+   *
+   * @return True if the entries are stored in the spilled_entries vector, false otherwise.
+   */
+  [[nodiscard]] auto is_spilled() const -> bool
+  {
+    return num_entries > INLINE_CAPACITY;
+  }
+
+  /**
+   * @brief Returns the pointer to the currently used storage.
+   *
+   * @return The pointer to the first entry.
+   */
+  [[nodiscard]] auto data() const -> const value_type*
+  {
+    return is_spilled() ? spilled_entries.data() : inline_entries.data();
+  }
+
+  int                                     num_entries = 0;  /**< The number of stored agents. */
+  std::array<value_type, INLINE_CAPACITY> inline_entries{}; /**< The inline storage of the entries. */
+  std::vector<value_type>                 spilled_entries;  /**< The storage used when there are more than INLINE_CAPACITY agents. */
+};
+
+/**
+ * @brief A vertex constraint stored with narrowed types, i.e. the time interval, in which a location is occupied, along with the number
+ * of the occupying agent. The infinite end of an interval (INT_MAX) is stored as the maximal value of time_type.
+ *
+ * @tparam time_type The type used to store the times.
+ * @tparam agent_type The type used to store the agent number.
+ */
+template <typename time_type, typename agent_type>
+class PackedConstraint
+{
+public:
+  /**
+   * @brief Constructs a packed constraint, the values have to fit into the narrowed types.
+   *
+   * @param interval_ The time interval of the constraint.
+   * @param agent_num_ The number of the agent, which causes the constraint.
+   */
+  PackedConstraint(const TimeInterval& interval_, int agent_num_) : interval(interval_), agent_num(static_cast<agent_type>(agent_num_))
+  {
+    assertm(fits(interval_, agent_num_), "The constraint does not fit into the narrowed types.");
+  }
+
+  /**
+   * @brief Checks whether a constraint can be stored with the narrowed types.
+   *
+   * @param interval_ The time interval of the constraint.
+   * @param agent_num_ The number of the agent, which causes the constraint.
+   *
+   * @return True if the constraint fits, false otherwise.
+   */
+  static auto fits(const TimeInterval& interval_, int agent_num_) -> bool
+  {
+    return PackedInterval<time_type>::fits(interval_) && agent_num_ >= 0 &&
+           static_cast<long long>(agent_num_) <= static_cast<long long>(std::numeric_limits<agent_type>::max());
+  }
+
+  /**
+   * @brief Returns the start of the occupied interval.
+   *
+   * @return The start of the occupied interval.
+   */
+  [[nodiscard]] auto get_t_min() const -> int
+  {
+    return interval.get_t_min();
+  }
+
+  /**
+   * @brief Returns the end of the occupied interval, INT_MAX if infinite.
+   *
+   * @return The end of the occupied interval, INT_MAX if infinite.
+   */
+  [[nodiscard]] auto get_t_max() const -> int
+  {
+    return interval.get_t_max();
+  }
+
+  /**
+   * @brief Returns the occupied interval.
+   *
+   * @return The occupied interval.
+   */
+  [[nodiscard]] auto get_interval() const -> TimeInterval
+  {
+    return interval.get_interval();
+  }
+
+  /**
+   * @brief Returns the number of the agent, which causes the constraint.
+   *
+   * @return The number of the agent, which causes the constraint.
+   */
+  [[nodiscard]] auto get_agent_num() const -> int
+  {
+    return static_cast<int>(agent_num);
+  }
+
+private:
+  PackedInterval<time_type> interval;  /**< The occupied interval. */
+  agent_type                agent_num; /**< The number of the agent, which causes the constraint. */
+};
+
 /**
  * @brief A class representing a constraint table, which stores all dynamic constraints.
  */
@@ -229,9 +413,9 @@ public:
    *
    * @param location The location to check for agents.
    *
-   * @return A map of integers representing the agents that enter the location and how many times they enter it.
+   * @return The agents sorted by their number that enter the location and how many times they enter it.
    */
-  [[nodiscard]] auto get_agents_counts(int location) const -> const std::unordered_map<int, int>&
+  [[nodiscard]] auto get_agents_counts(int location) const -> const AgentCounts&
   {
     assertm(instance.get_map_data().is_in(location), "Invalid location.");
     return agents_counts[instance.location_to_free_location(location)];
@@ -242,9 +426,9 @@ public:
    *
    * @param free_location The free location to check for agents.
    *
-   * @return A map of integers representing the agents that enter the free location and how many times they enter it.
+   * @return The agents sorted by their number that enter the free location and how many times they enter it.
    */
-  [[nodiscard]] auto get_agents_counts_free(int free_location) const -> const std::unordered_map<int, int>&
+  [[nodiscard]] auto get_agents_counts_free(int free_location) const -> const AgentCounts&
   {
     assertm(instance.get_map_data().is_in(instance.free_location_to_location(free_location)), "Invalid location.");
     return agents_counts[free_location];
@@ -259,13 +443,46 @@ public:
    */
   [[nodiscard]] auto get_last_constraint_start(int location) const -> int
   {
-    return constraints[instance.location_to_free_location(location)].back().first.t_min;
+    const int free_location = instance.location_to_free_location(location);
+    return narrow ? narrow_constraints[free_location].back().get_t_min() : wide_constraints[free_location].back().get_t_min();
+  }
+
+  /**
+   * @brief Checks whether the constraints are stored with 16-bit times and agent numbers.
+   *
+   * @return True if the narrowed storage is used, false otherwise.
+   */
+  [[nodiscard]] auto uses_narrow_storage() const -> bool
+  {
+    return narrow;
   }
 
 private:
-  std::vector<std::list<std::pair<TimeInterval, int>>> constraints;   /**< constraints for each location */
-  const Instance&                                      instance;      /**< The instance of the problem. */
-  std::vector<std::unordered_map<int, int>>            agents_counts; /**< unordered map of times the agents visit each location */
+  using NarrowConstraint = PackedConstraint<uint16_t, uint16_t>; /**< Constraint stored with 16-bit times and agent numbers. */
+  using WideConstraint   = PackedConstraint<int, int>;           /**< Constraint stored with 32-bit times and agent numbers. */
+
+  /**
+   * @brief Switches to the 32-bit storage if the given constraint does not fit into the narrowed one.
+   *
+   * @param interval The time interval of the constraint.
+   * @param agent_num The number of the agent, which causes the constraint.
+   */
+  void widen_if_needed(const TimeInterval& interval, int agent_num);
+
+  /**
+   * @brief Switches to the 32-bit storage if any constraint of the given path does not fit into the narrowed one. Used before the
+   * parallel updates, as the storage can not be switched while other threads access it.
+   *
+   * @param path The path to check.
+   * @param agent_num The number of the agent, which the path belongs to.
+   */
+  void widen_if_needed(const TimePointPath& path, int agent_num);
+
+  bool narrow; /**< Flag indicating if the 16-bit storage is used, selected when the instance is loaded. */
+  std::vector<std::vector<NarrowConstraint>> narrow_constraints; /**< 16-bit constraints for each location sorted by time */
+  std::vector<std::vector<WideConstraint>>   wide_constraints;   /**< 32-bit constraints for each location sorted by time */
+  const Instance&                            instance;           /**< The instance of the problem. */
+  std::vector<AgentCounts>                   agents_counts;      /**< times the agents visit each location */
 #ifdef CT_PARALLELIZATION
   omp_locks locks; /**< Locks for parallelization. */
 #endif
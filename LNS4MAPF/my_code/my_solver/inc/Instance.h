@@ -7,6 +7,8 @@
  */
 
 #pragma once
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -228,6 +230,26 @@ public:
     return heuristic_distance[agent_num][loc];
   };
 
+  /**
+   * @brief Returns the number of moves of a human from each location to an exit. The distance to a door is calculated on its first use
+   * and kept, the distances to other exits are calculated to the buffer.
+   *
+   * @param exit_location The location of the exit.
+   * @param buffer The vector used for the distances, if the exit is not a door.
+   *
+   * @return The distance from each location to the exit, -1 if the exit can not be reached.
+   */
+  [[nodiscard]] auto get_exit_distance(int exit_location, std::vector<int>& buffer) const -> const std::vector<int>&;
+
+  /**
+   * @brief Calculates the number of moves of a human from each location to an exit by a breadth first search. The human moves through
+   * the free cells, the doors other than the exit can only be left.
+   *
+   * @param exit_location The location of the exit.
+   * @param distance The distance from each location to the exit, -1 if the exit can not be reached.
+   */
+  void calculate_exit_distance(int exit_location, std::vector<int>& distance) const;
+
   /**
    * @brief Finds locations of the neighbors of a given location.
    *
@@ -402,6 +424,17 @@ private:
   std::vector<std::vector<double>> heuristic_euclidean; /**< Euclidean heuristic for each agent and location. */
 #endif
   std::vector<std::vector<int>> heuristic_distance; /**< Distance heuristic for each agent and location. */
+  std::vector<int>              location_to_door_array; /**< Array mapping locations to the doors, -1 if the location is not a door. */
+
+  /**
+   * @brief Distances of a human to the doors, each one is calculated once by the first thread using the door as an exit.
+   */
+  struct DoorDistances
+  {
+    std::vector<std::vector<int>>     distance;   /**< Distance of a human to each door for each location. */
+    std::unique_ptr<std::once_flag[]> calculated; /**< Flag of each door, whose distance is calculated. */
+  };
+  std::shared_ptr<DoorDistances> door_distances; /**< The distances to the doors, shared by the copies of the instance. */
 
   int sum_of_distances = 0; /**< Sum of distances for all agents. */
   int num_of_agents;        /**< Number of agents in the instance. */
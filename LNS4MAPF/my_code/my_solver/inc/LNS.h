@@ -7,12 +7,20 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <set>
+#include <unordered_set>
 #include <utility>
 
 #include "ConstraintTable.h"
 #include "SIPP.h"
+#include "SafetyChecker.h"
 #include "SharedData.h"
 #include "Solver.h"
 
@@ -26,7 +34,8 @@ enum class DESTROY_TYPE
   INTERSECTION,
   ADAPTIVE,
   RANDOM_CHOOSE,
-  BLOCKED
+  BLOCKED,
+  SAFETY
 };
 
 /**
@@ -76,11 +85,28 @@ public:
   Destroy_settings destroy_settings; /**< Settings for the destroy operator. */
   SIPP_settings    sipp_settings;    /**< Settings for the SIPP algorithm. */
   bool             restarts;         /**< Whether to use restarts. */
+  int              threads = 1;      /**< The number of workers repairing disjoint neighborhoods in parallel, 1 runs the sequential LNS. */
+  int initial_planners = 1; /**< The number of Prioritized Planning orderings racing for the initial solution in parallel. */
+  bool bounded_repair   = true; /**< Whether the repair is aborted as soon as the neighborhood can not improve the solution. */
+  bool adaptive_neighborhood = false; /**< Whether the neighborhood size is adapted online, starting from destroy_settings.size. */
+  int  min_neighborhood_size = 2;     /**< The lower bound of the adapted neighborhood size. */
+  int  max_neighborhood_size = 64;    /**< The upper bound of the adapted neighborhood size. */
+  double max_repair_time = 0.1; /**< The average wall time of destroy and repair in seconds, above which the neighborhood shrinks. */
+  bool pipelined_destroy = false; /**< Whether the next neighborhood is computed on a helper thread while the current one is repaired. */
+  int repair_orderings = 1; /**< The number of random orderings of each neighborhood repaired in parallel, the best one is kept. */
+  bool safety_corridor = false; /**< Whether the cells around the human path are reserved before the robots are planned (safety mode only). */
+  int  safety_corridor_margin = 1; /**< The Manhattan distance from the human, up to which the cells are reserved. */
+  double human_update_budget = 0.05; /**< The wall time in seconds, for which the robots are repaired after the human positions change. */
+  int safety_threads = 1; /**< The maximal number of threads evaluating the human safety of the steps in parallel. */
 };
 
 /**
  * @brief Class representing a generic operator for the LNS algorithm.
+ *
+ * @tparam Target The type modified by the operator, the solution for the destroy operators and the solution overlay for the repair
+ * operators.
  */
+template <typename Target>
 class Operator
 {
 public:
@@ -89,22 +115,53 @@ public:
    *
    * @param func_ Function to be executed by the operator.
    */
-  explicit Operator(std::function<void(Solution& sol)> func_) : func(std::move(func_))
+  explicit Operator(std::function<void(Target& target)> func_) : func(std::move(func_))
   {
   }
 
   /**
-   * @brief Applies the operator to a given solution.
+   * @brief Applies the operator to a given target.
    *
-   * @param solution The solution to be modified.
+   * @param target The solution (or the solution overlay) to be modified.
    */
-  void apply(Solution& solution)
+  void apply(Target& target)
   {
-    func(solution);
+    func(target);
   }
 
 private:
-  const std::function<void(Solution& sol)> func; /**< Function to be executed by the operator. */
+  const std::function<void(Target& target)> func; /**< Function to be executed by the operator. */
+};
+
+/**
+ * @brief Statistics of one destroy operator, the adaptive destroy uses them to prefer the operators improving the most per second.
+ */
+struct OperatorStats
+{
+  int    calls             = 0;   /**< The number of iterations, which used the operator. */
+  int    improvements      = 0;   /**< The number of iterations, which improved the solution. */
+  long   total_improvement = 0;   /**< The sum of the improvements of the sum of delays. */
+  double total_time        = 0.0; /**< The wall time spent in the destroy and repair phases, in seconds. */
+
+  /**
+   * @brief Gets the average wall time of one iteration of the operator.
+   *
+   * @return The average time in seconds, 0 if the operator was not used.
+   */
+  [[nodiscard]] auto get_average_time() const -> double
+  {
+    return calls == 0 ? 0.0 : total_time / calls;
+  }
+
+  /**
+   * @brief Gets the improvement of the sum of delays per second spent in the operator.
+   *
+   * @return The improvement per second, 0 if the operator was not used.
+   */
+  [[nodiscard]] auto get_improvement_per_second() const -> double
+  {
+    return total_time <= 0.0 ? 0.0 : static_cast<double>(total_improvement) / total_time;
+  }
 };
 
 /**
@@ -133,6 +190,76 @@ struct Logger
   std::vector<int>          bsf_makespan;        /**< Vector of best makespan values. */
   std::vector<double>       iteration_time_cpu;  /**< Vector of CPU times for each iteration. */
   std::vector<double>       iteration_time_wall; /**< Vector of wall times for each iteration. */
+  std::vector<int>          neighborhood_size;   /**< Vector of neighborhood sizes used in each iteration. */
+  std::array<OperatorStats, magic_enum::enum_count<DESTROY_TYPE>()> operator_stats{}; /**< Statistics of the operators indexed by DESTROY_TYPE. */
+};
+
+/**
+ * @brief The result of repairing a neighborhood in one ordering of the parallel repair.
+ */
+struct OrderingResult
+{
+  std::vector<int>           order;                  /**< The order, in which the agents were planned. */
+  std::vector<TimePointPath> new_paths;              /**< The new paths in the order of the agents, empty if not planned. */
+  std::unordered_set<int>    planned;                /**< The planned agents of the ordering's planner. */
+  bool                       feasible       = false; /**< Whether all agents were planned. */
+  bool                       bound_exceeded = false; /**< Whether the repair was aborted, because it could not improve. */
+  int                        cost           = 0;     /**< The sum of costs of the new paths. */
+};
+
+/**
+ * @brief A neighborhood committed by a worker of the parallel LNS. The other workers replay it on their reservation snapshots.
+ */
+struct NeighborhoodUpdate
+{
+  std::vector<int>           agents;    /**< The agents, whose paths were replaced. */
+  std::vector<TimePointPath> old_paths; /**< The replaced paths. */
+  std::vector<TimePointPath> new_paths; /**< The committed paths. */
+};
+
+/**
+ * @brief An observed position of a human, which replaces its predicted path from the given step on.
+ */
+struct HumanUpdate
+{
+  int human;    /**< The index of the human. */
+  int location; /**< The observed location of the human. */
+  int time;     /**< The step of the human path, at which it was observed. */
+};
+
+/**
+ * @brief The statistics of a parallel LNS run. The times are the CPU times of the worker threads, so they do not include waiting for the
+ * mutex or for a free core, and the scaling to more cores can be estimated from a run on fewer cores.
+ */
+struct ParallelLNSStats
+{
+  int    commits     = 0;   /**< The number of committed neighborhoods. */
+  int    conflicts   = 0;   /**< The number of improving neighborhoods rejected by the validation. */
+  double busy_time   = 0.0; /**< The CPU time of the workers spent in the iterations. */
+  double locked_time = 0.0; /**< The CPU time of the workers spent holding the mutex, this part of the iterations is serialized. */
+};
+
+/**
+ * @brief The state shared by the workers of the parallel LNS, all members are guarded by the mutex.
+ */
+struct ParallelLNSState
+{
+  /**
+   * @brief Constructs the shared state.
+   *
+   * @param num_agents The number of agents.
+   * @param num_workers The number of workers.
+   */
+  ParallelLNSState(int num_agents, int num_workers) : in_flight(num_agents, false), worker_versions(num_workers, 0)
+  {
+  }
+
+  std::mutex             mutex;                /**< The mutex guarding the state, the solution and the master tables of the LNS. */
+  std::vector<bool>      in_flight;            /**< Indicates, whether the agent is in a neighborhood being repaired. */
+  std::deque<NeighborhoodUpdate> updates;   /**< The committed updates, which were not yet replayed by all workers. */
+  int              first_update_version = 0; /**< The version of the first stored update. */
+  std::vector<int> worker_versions;          /**< The number of updates replayed by each worker. */
+  ParallelLNSStats stats;                    /**< The statistics of the run. */
 };
 
 /**
@@ -178,6 +305,43 @@ public:
    */
   auto PrioritizedPlanning() -> Solution;
 
+  /**
+   * @brief Runs several Prioritized Planning orderings in parallel, the first feasible one is used and the others are cancelled.
+   *
+   * @return The solution of the first feasible ordering, an infeasible solution if no ordering succeeded.
+   */
+  auto race_prioritized_planning() -> Solution;
+
+  /**
+   * @brief Getter for the number of performed LNS iterations.
+   *
+   * @return The number of iterations.
+   */
+  [[nodiscard]] auto get_iteration_num() const -> int
+  {
+    return iteration_num;
+  }
+
+  /**
+   * @brief Getter for the statistics of the last parallel LNS run.
+   *
+   * @return The statistics, all zero if the LNS did not run in parallel.
+   */
+  [[nodiscard]] auto get_parallel_stats() const -> const ParallelLNSStats&
+  {
+    return parallel_stats;
+  }
+
+  /**
+   * @brief Getter for the constraint table.
+   *
+   * @return The constraint table storing the paths of the current solution.
+   */
+  [[nodiscard]] auto get_constraint_table() const -> const ConstraintTable&
+  {
+    return constraint_table;
+  }
+
   /**
    * @brief Getter for the number of generated nodes.
    *
@@ -199,13 +363,35 @@ public:
   }
 
   /**
-   * @brief Discards the solution if it is not better than the previous one. Restores the SafeIntervalTable and ConstraintTable to its
-   * previous state.
+   * @brief Discards the new paths of the overlay if they are not better than the replaced ones. Restores the SafeIntervalTable and
+   * ConstraintTable to its previous state.
+   *
+   * @param sol_overlay The overlay to be discarded.
+   */
+  void discard_solution(const SolutionOverlay& sol_overlay) const;
+
+  /**
+   * @brief Checks whether the current solution was verified to keep the humans safe.
+   *
+   * @return True if the safety is not checked, or the safety checker holds the solution and found no unsafe step.
+   */
+  [[nodiscard]] auto is_verified_safe() const -> bool
+  {
+    return !safety_aware_mode || !has_humans() || (safety_checker != nullptr && solution_unsafe_steps.empty());
+  }
+
+  /**
+   * @brief Replaces the current solution by a solution found by another solver. Only the paths, which differ, are replaced in the
+   * SafeIntervalTable and ConstraintTable, so the tables are not rebuilt from scratch.
    *
-   * @param sol The solution to be discarded.
-   * @param prev_sol The previous solution.
+   * @param sol The feasible solution to be adopted.
    */
-  void discard_solution(const Solution& sol, const Solution& prev_sol) const;
+  void adopt_solution(const Solution& sol);
+
+  /**
+   * @brief Commits the accepted overlay to the solution and updates the constraint table by its paths.
+   */
+  void commit_overlay();
 
   /**
    * @brief Builds the constraint table for the given paths.
@@ -214,23 +400,125 @@ public:
    */
   void initialize_constraint_table(const std::vector<TimePointPath>& paths);
 
-  Operator                        destroy_operator;               /**< Operator for the destroy phase. */
+  Operator<Solution>              destroy_operator;               /**< Operator for the destroy phase. */
   mutable std::unordered_set<int> already_planned;                /**< Set of already planned agents. */
   Logger                          log;                            /**< Logger for the LNS algorithm. */
   LNS_settings&                   settings;                       /**< Settings for the LNS algorithm. */
   bool                            found_initial_solution = false; /**< Flag indicating if the initial solution was found. */
+  SharedSolution* portfolio = nullptr; /**< The best solution shared with the other solvers of a portfolio, nullptr if the solver runs alone. */
 
   bool safety_aware_mode = false;
-  std::vector<int> human_path_locations; // Cesta člověka (převedená na location ID)
-  int safety_exit_location = -1;         // Cíl (dveře)
+  std::vector<std::vector<int>> human_paths; // Cesty lidí (převedené na location ID)
+  std::vector<int> safety_exit_locations;    // Cíle (dveře)
+  std::unique_ptr<SafetyChecker> safety_checker; /**< The robot reservations of the safety check, built on the first check. */
+  std::vector<std::pair<int, int>> solution_unsafe_steps; /**< The (human, step) pairs, from which no exit can be reached in the current solution. */
+  std::vector<std::pair<int, int>> candidate_unsafe_steps; /**< The unsafe steps of the last checked candidate, if the current solution is unsafe. */
+  std::vector<std::vector<TimePointPath>> escape_routes; /**< The shortest escape route of each human from each step ignoring the robots, empty if the solution is safe. */
+
+  /**
+   * @brief Checks the safety of the repaired overlay, its paths are staged in the safety checker until sync_safety_checker is called. If
+   * the current solution is unsafe, the overlay passes the check when it has fewer unsafe steps.
+   *
+   * @param sol_overlay The feasible repaired overlay.
+   *
+   * @return True if the human can reach the exit from every step of its path or the unsafe steps are reduced, false otherwise.
+   */
+  bool validate_safety(const SolutionOverlay& sol_overlay);
+
+  /**
+   * @brief Builds the safety checker from the current solution and finds its unsafe steps, unless the checker exists already.
+   */
+  void initialize_safety_checker();
+
+  /**
+   * @brief Finds the escape routes of the human from all steps, if the current solution is unsafe, they are dropped once it is safe.
+   */
+  void update_escape_routes();
+
+  /**
+   * @brief Commits or rolls back the overlay staged in the safety checker, it has to be called after the acceptance decision.
+   *
+   * @param accepted Whether the overlay was committed to the solution.
+   */
+  void sync_safety_checker(bool accepted);
+
+  /**
+   * @brief Computes the reservations of the escape corridor from the human path. Each free cell within the margin from the human is
+   * reserved from the time the human gets close until it moves away plus one timestep, so the robots can not swap cells with the human.
+   * The start cells of the robots are reserved from time 1 at the earliest, the door cells are not reserved at all.
+   */
+  void build_safety_reservations();
+
+  /**
+   * @brief Adds the reservations of the escape corridor to a safe interval table, the table must not hold any overlapping path.
+   *
+   * @param table The safe interval table of a planner.
+   */
+  void add_safety_reservations(SafeIntervalTable& table) const;
 
-  bool validate_safety(const Solution& sol);
+  std::vector<TimePoint> safety_reservations; /**< The reservations of the escape corridor, empty if it is not used. */
 
   void solve() override;
-  void print_safety_report(); 
-  int human_start_location = -1;
+
+  /**
+   * @brief Prints the steps of the human paths, from which no exit can be reached.
+   *
+   * @param timeline The safety of each step of each human, nothing is printed if it is empty.
+   */
+  static void print_safety_report(const std::vector<std::vector<SafetyStep>>& timeline);
+
+  /**
+   * @brief Evaluates the safety of each step of the human paths in the current solution. The reservations are built from the solution, so
+   * it can be called after the solution was replaced by another solver.
+   *
+   * @return The safety of each step of each human up to the end of the solution or the longest human path, empty if the safety is not
+   * checked.
+   */
+  [[nodiscard]] auto get_safety_timeline() const -> std::vector<std::vector<SafetyStep>>;
+  std::vector<int> human_start_locations; /**< The start locations of the humans, each human escapes to the nearest exit. */
+
+  /**
+   * @brief Reports an observed position of a human, it can be called from another thread while the LNS runs. The pending positions are
+   * applied at the start of the next iteration.
+   * @throws std::runtime_error if the human, the location or the time is invalid.
+   *
+   * @param human The index of the human.
+   * @param location The observed location, it has to be a free cell or a door.
+   * @param time The step of the human path, at which the human was observed.
+   */
+  void push_human_update(int human, int location, int time);
+
+  /**
+   * @brief Applies the pending human positions. The path of each updated human is replanned from the observed position, the escape
+   * analysis is rerun and the robots blocking the new escape routes are repaired until the solution is safe or the update budget runs out.
+   *
+   * @return True if some position was applied.
+   */
+  auto process_human_updates() -> bool;
+
+  /**
+   * @brief Returns the last solution, which was verified to keep the humans safe, it can be called from another thread while the LNS runs.
+   * The solution may be costlier than the current one. It is kept when the human positions change, is_safe_solution_current tells whether
+   * it was verified against the new human paths.
+   *
+   * @return The safe solution, nullptr if the safety is not checked or no safe solution was found yet.
+   */
+  [[nodiscard]] auto get_safe_solution() const -> std::shared_ptr<const Solution>
+  {
+    return std::atomic_load(&safe_solution);
+  }
+
+  /**
+   * @brief Checks whether the safe solution was verified against the current human paths, it can be called from another thread while the
+   * LNS runs. The positions, which were reported but not applied yet, are not taken into account.
+   *
+   * @return True if the safe solution keeps the humans safe on their current paths, false if it is stale or there is none.
+   */
+  [[nodiscard]] auto is_safe_solution_current() const -> bool
+  {
+    return safe_solution_current.load(std::memory_order_acquire);
+  }
   std::vector<int> find_shortest_path(int start_loc, int goal_loc);
-  bool check_reachability(int start_loc, int goal_loc, int start_time);
 
 private:
   /**
@@ -276,6 +564,119 @@ private:
    */
   void destroy_blocked(Solution& sol) const;
 
+  /**
+   * @brief The safety destroy operator function, which destroys the robots blocking the escape of the human from the unsafe steps of the
+   * solution. It uses the randomwalk, if the solution is safe.
+   *
+   * @param sol The solution to be modified.
+   */
+  void destroy_safety(Solution& sol) const;
+
+  /**
+   * @brief Finds the robots, which occupy an escape route of the human at the time the human would use it or one timestep later.
+   *
+   * @param route The escape route of the human.
+   * @param table The constraint table holding the paths of the robots.
+   *
+   * @return The blocking robots ordered along the route, a robot may be repeated.
+   */
+  [[nodiscard]] static auto get_blocking_robots(const TimePointPath& route, const ConstraintTable& table) -> std::vector<int>;
+
+  /**
+   * @brief Reserves the free parts of the escape routes, so the replanned robots keep them free.
+   *
+   * @param table The safe interval table of the planner, the destroyed paths have to be removed from it.
+   * @param reservations The added reservations, they have to be removed after the repair.
+   */
+  void add_escape_reservations(SafeIntervalTable& table, std::vector<TimePoint>& reservations) const;
+
+  /**
+   * @brief Finds the shortest path of a human to the nearest exit, the robots are ignored.
+   *
+   * @param location The location of the human.
+   *
+   * @return The locations of the human at each step, empty if no exit can be reached.
+   */
+  [[nodiscard]] auto find_human_path(int location) const -> std::vector<int>;
+
+  /**
+   * @brief Replaces the path of a human from the observed step by the shortest path to the nearest exit. The earlier steps are kept, the
+   * human waits at the end of its path until the observation.
+   *
+   * @param update The observed position of the human.
+   */
+  void replan_human(const HumanUpdate& update);
+
+  /**
+   * @brief Rebuilds the reservations of the escape corridor from the current human paths. Only the parts, which are not occupied by the
+   * robots of the current solution, are reserved, the robots inside the corridor are moved away by the repair.
+   */
+  void update_safety_reservations();
+
+  /**
+   * @brief Stores a copy of the current solution as the safe solution, if the humans are safe in it.
+   */
+  void publish_safe_solution();
+
+  /**
+   * @brief Checks the safe solution against the current human paths, when the current solution is not safe for them. The safe solution is
+   * kept in both cases, it is only marked stale if a human can not escape in it.
+   */
+  void verify_safe_solution();
+
+  /**
+   * @brief Returns the location of a human at the given step, the human waits at the end of its path.
+   *
+   * @param human The index of the human.
+   * @param time The step of the human.
+   *
+   * @return The location of the human.
+   */
+  [[nodiscard]] auto get_human_location(int human, int time) const -> int
+  {
+    const std::vector<int>& human_path = human_paths[human];
+    return time < static_cast<int>(human_path.size()) ? human_path[time] : human_path.back();
+  }
+
+  /**
+   * @brief Checks whether there are humans and exits to check the safety for.
+   *
+   * @return True if the safety can be checked.
+   */
+  [[nodiscard]] auto has_humans() const -> bool
+  {
+    return !human_paths.empty() && !safety_exit_locations.empty();
+  }
+
+  /**
+   * @brief Checks whether a location is one of the exits.
+   *
+   * @param location The location to check.
+   *
+   * @return True if the location is an exit.
+   */
+  [[nodiscard]] auto is_safety_exit(int location) const -> bool
+  {
+    return std::find(safety_exit_locations.begin(), safety_exit_locations.end(), location) != safety_exit_locations.end();
+  }
+
+  /**
+   * @brief Returns the number of steps checked by the safety check, it covers the solution and the longest human path.
+   *
+   * @param makespan The makespan of the checked solution.
+   *
+   * @return The number of steps to check.
+   */
+  [[nodiscard]] auto get_safety_duration(int makespan) const -> int
+  {
+    int duration = makespan;
+    for (const auto& human_path : human_paths)
+    {
+      duration = std::max(duration, static_cast<int>(human_path.size()));
+    }
+    return duration;
+  }
+
   /**
    * @brief The adaptive destroy operator function.
    *
@@ -299,22 +700,151 @@ private:
   void get_intersection_agents(std::unordered_set<int>& neighborhood, int current) const;
 
   /**
-   * @brief The repair operator function, which repairs the solution.
+   * @brief The repair operator function, which replans the destroyed paths of the overlay.
+   *
+   * @param sol_overlay The overlay to be repaired.
+   */
+  void repair_default(SolutionOverlay& sol_overlay) const;
+
+  /**
+   * @brief Replans the destroyed agents one by one in the given order, their old paths have to be removed from the planner already.
+   *
+   * @param sipp The planner, whose safe interval table receives the new paths.
+   * @param planned The set of agents planned by the planner.
+   * @param order The order of the destroyed agents.
+   * @param new_paths The new paths in the order of the agents, the paths of the agents, which were not planned, are left empty.
+   * @param bound_exceeded Set to true if the repair was aborted, because the neighborhood could not improve.
+   *
+   * @return True if all agents were planned, false otherwise.
+   */
+  auto repair_ordering(SIPP& sipp, std::unordered_set<int>& planned, const std::vector<int>& order, std::vector<TimePointPath>& new_paths,
+                       bool& bound_exceeded) const -> bool;
+
+  /**
+   * @brief Repairs the neighborhood in several random orderings in parallel, each on its own planner. The planner of the LNS ends with the
+   * paths of the cheapest feasible ordering, which are stored in the overlay.
+   *
+   * @param sol_overlay The overlay to be repaired, its old paths have to be removed from the planner of the LNS already.
+   */
+  void repair_orderings(SolutionOverlay& sol_overlay) const;
+
+  /**
+   * @brief Adds the final paths of the last repaired neighborhood to the planners of the orderings, it has to be called after the overlay
+   * was committed or discarded.
+   */
+  void sync_ordering_planners();
+
+  /**
+   * @brief Plans the agents one by one in a random order, each agent avoids the paths of the agents planned before it.
+   *
+   * @param pp_planner The planner, whose safe interval table is filled with the planned paths.
+   * @param generator The random generator used to choose the order.
+   * @param planned The set of already planned agents, it has to be empty.
+   * @param cancel The flag, which stops the planning, when it is set, nullptr if the planning can not be cancelled.
+   *
+   * @return The planned solution, infeasible if some agent could not be planned or the planning was cancelled.
+   */
+  auto prioritized_planning(SIPP& pp_planner, std::mt19937& generator, std::unordered_set<int>& planned,
+                            const std::atomic<bool>* cancel) const -> Solution;
+
+  /**
+   * @brief Publishes the current solution to the portfolio, or adopts the solution of the portfolio, if it is better.
+   */
+  void exchange_with_portfolio();
+
+  /**
+   * @brief Adapts the neighborhood size after each window of iterations. The neighborhood shrinks if the repairs fail or run slowly and grows
+   * if the neighborhoods stop improving the solution.
+   *
+   * @param repaired Whether all destroyed agents were replanned.
+   * @param improved Whether the new paths were accepted.
+   * @param time The wall time of the destroy and repair phases, in seconds.
+   */
+  void update_neighborhood_size(bool repaired, bool improved, double time);
+
+  /**
+   * @brief Records the time of one iteration in the statistics of the destroy operator, it has to be called before the weights are updated.
+   *
+   * @param strategy The destroy strategy, which created the neighborhood.
+   * @param time The wall time of the destroy and repair phases, in seconds.
+   */
+  void record_operator_time(DESTROY_TYPE strategy, double time);
+
+  /**
+   * @brief Updates the weights of the adaptive destroy operator and the threshold of the blocked destroy operator after a feasible repair.
+   * The adaptive weights reward the improvement per unit of time, the time unit is the average iteration of all operators.
+   *
+   * @param strategy The destroy strategy, which created the neighborhood.
+   * @param improvement The improvement of the sum of delays, non positive values mean the solution was not accepted.
+   */
+  void update_destroy_weights(DESTROY_TYPE strategy, int improvement);
+
+  /**
+   * @brief Runs the LNS iterations by several workers in parallel. Each worker repairs a neighborhood disjoint with the neighborhoods of
+   * the other workers against its own snapshot of the reservations and commits an improvement after validating it against the master safe
+   * interval table.
+   *
+   * @param clock The clock measuring the whole run.
+   */
+  void solve_parallel(const Clock& clock);
+
+  /**
+   * @brief The main loop of one worker of the parallel LNS.
+   *
+   * @param state The state shared by the workers.
+   * @param clock The clock measuring the whole run.
+   * @param worker_generator The random generator of the worker used in the planning.
+   * @param worker The index of the worker.
+   */
+  void run_worker(ParallelLNSState& state, const Clock& clock, std::mt19937& worker_generator, int worker);
+
+  /**
+   * @brief Replaces the paths of the neighborhood in the solution, if they do not collide with the master safe interval table. Has to be
+   * called with the mutex of the shared state locked.
+   *
+   * @param state The state shared by the workers.
+   * @param neighborhood The agents of the neighborhood.
+   * @param old_paths The current paths of the neighborhood.
+   * @param new_paths The repaired paths of the neighborhood.
    *
-   * @param sol The solution to be repaired.
+   * @return True if the paths were committed, false if they collide with a path committed by another worker.
    */
-  void repair_default(Solution& sol) const;
+  auto commit_neighborhood(ParallelLNSState& state, const std::vector<int>& neighborhood, const std::vector<TimePointPath>& old_paths,
+                           const std::vector<TimePointPath>& new_paths) -> bool;
 
   SharedData*                 shared_data;                          /**< Pointer to shared data. */
   int                         iteration_num = 0;                    /**< Current iteration number. */
+  ParallelLNSStats            parallel_stats;                       /**< The statistics of the last parallel LNS run. */
   double                      initial_solution_time;                /**< Time taken to find the initial solution. */
   double                      curr_time;                            /**< Current time. */
-  Operator                    repair_operator;                      /**< The repair operator. */
+  Operator<SolutionOverlay>   repair_operator;                      /**< The repair operator. */
+  SolutionOverlay             overlay;                              /**< The paths replaced in the current iteration. */
   mutable ConstraintTable     constraint_table;                     /**< Constraint table used, which stores the dynamic constraints. */
   mutable bool                constraint_table_initialized = false; /**< Flag indicating if the constraint table is initialized. */
   mutable std::vector<double> destroy_weights;                      /**< Vector of weights for the adaptive destroy operator. */
   double                      reaction_factor = 0.01;               /**< Reaction factor for the adaptive destroy operator. */
+  int                         destroy_size;                         /**< The current number of agents destroyed by the destroy operators. */
+  int                         size_window_iterations   = 0;         /**< The number of iterations in the current size window. */
+  int                         size_window_failures     = 0;         /**< The number of failed repairs in the current size window. */
+  int                         size_window_improvements = 0;         /**< The number of accepted repairs in the current size window. */
+  double                      size_window_time         = 0.0;       /**< The wall time of the iterations in the current size window. */
+  std::mt19937                pipeline_generator;                   /**< The generator of the destroy operators in the pipelined mode. */
+  std::mt19937*               destroy_generator = &rnd_generator;   /**< The generator used by the destroy operators. */
+  std::vector<int>            candidate_neighborhood;               /**< The next neighborhood computed during the repair. */
+  DESTROY_TYPE                candidate_strategy = DESTROY_TYPE::RANDOM; /**< The destroy strategy of the candidate neighborhood. */
+  int                         candidate_cost     = -1;              /**< The sum of costs of the solution the candidate is valid for. */
+  int                         candidate_size     = -1;              /**< The neighborhood size the candidate was computed with. */
+  bool                        has_candidate      = false;           /**< Whether the candidate neighborhood can be used. */
+  mutable std::vector<std::mt19937>          ordering_generators;  /**< The generators of the repair orderings except the first one. */
+  mutable std::vector<std::unique_ptr<SIPP>> ordering_planners;    /**< The planners of the repair orderings except the first one. */
+  mutable std::vector<OrderingResult>        ordering_results;     /**< The results of the repair orderings. */
+  mutable bool                               orderings_pending = false; /**< Whether the planners of the orderings miss the last neighborhood. */
   double                      decay_factor    = 0.01;               /**< Decay factor for the adaptive destroy operator. */
   mutable DESTROY_TYPE        last_destroy_strategy;                /**< Last used destroy strategy. */
   float                       threshold_blocked = 1.0;              /**< Threshold for the blocked destroy operator. */
+  mutable std::unordered_set<int> tabu_list; /**< The agents recently chosen by the randomwalk destroy operator, owned by each solver of a portfolio. */
+  std::mutex                      human_update_mutex;    /**< The mutex guarding the pending human updates. */
+  std::vector<HumanUpdate>        pending_human_updates; /**< The observed human positions, which were not applied yet. */
+  std::shared_ptr<const Solution> safe_solution;         /**< The last solution verified to be safe, accessed atomically. */
+  std::atomic<bool> safe_solution_current = false; /**< Whether the safe solution was verified against the current human paths. */
 };
@@ -8,6 +8,7 @@
 #pragma once
 #include <utils.h>
 
+#include <climits>
 #include <random>
 
 // #include <boost/heap/pairing_heap.hpp>
@@ -203,7 +204,6 @@ private:
   int                   end = 0; /**< The end index of the pool. Nodes after end are empty. */
   std::vector<SIPPNode> pool;    /**< The pool of SIPP nodes. */
   std::list<SIPPNode>   extra;   /**< The list of extra SIPP nodes. */
-  bool check_reachability(int start_loc, int goal_loc, int start_time);
 };
 
 
@@ -250,8 +250,8 @@ public:
   int               expanded_this_iter  = 0; /**< The number of nodes expanded in the current iteration. */
   int               iteration_num       = 0; /**< The current iteration number. */
   SIPPInfo          iter_info;               /**< The iteration information. */
+  bool              bound_pruned        = false; /**< Whether the last search skipped a part of the search space because of the arrival bound. */
 
-  bool check_reachability(int start_loc, int goal_loc, int start_time);
   std::vector<int> find_shortest_path(int start_loc, int goal_loc);
 
   /**
@@ -273,38 +273,42 @@ public:
    *
    * @param agent_num The agent number to plan the path for.
    * @param already_planned A set of already planned agents.
+   * @param max_arrival The latest allowed arrival to the goal, the search fails if the goal can not be reached sooner.
    *
    * @return A TimePointPath representing the planned path for the agent.
    */
-  auto plan(int agent_num, const std::unordered_set<int>& already_planned) -> TimePointPath;
+  auto plan(int agent_num, const std::unordered_set<int>& already_planned, int max_arrival = INT_MAX) -> TimePointPath;
 
   /**
    * @brief Plans a path for the given agent number using the multi-heuristic version of the SIPP algorithm.
    *
    * @param agent_num The agent number to plan the path for.
+   * @param max_arrival The latest allowed arrival to the goal, the search fails if the goal can not be reached sooner.
    *
    * @return A TimePointPath representing the planned path for the agent.
    */
-  auto plan_sipp_mine(int agent_num) -> TimePointPath;
+  auto plan_sipp_mine(int agent_num, int max_arrival = INT_MAX) -> TimePointPath;
 
   /**
    * @brief Plans a path for the given agent number using the ap multi-heuristic version of the SIPP algorithm.
    *
    * @param agent_num The agent number to plan the path for.
    * @param already_planned A set of already planned agents.
+   * @param max_arrival The latest allowed arrival to the goal, the search fails if the goal can not be reached sooner.
    *
    * @return A TimePointPath representing the planned path for the agent.
    */
-  auto plan_sipp_mine_ap(int agent_num, const std::unordered_set<int>& already_planned) -> TimePointPath;
+  auto plan_sipp_mine_ap(int agent_num, const std::unordered_set<int>& already_planned, int max_arrival = INT_MAX) -> TimePointPath;
 
   /**
    * @brief Plans a path for the given agent number using the original single-heuristic version of the SIPP algorithm from MAPF-LNS.
    *
    * @param agent_num The agent number to plan the path for.
+   * @param max_arrival The latest allowed arrival to the goal, the search fails if the goal can not be reached sooner.
    *
    * @return A TimePointPath representing the planned path for the agent.
    */
-  auto plan_mapflns_heuristic(int agent_num) -> TimePointPath;
+  auto plan_mapflns_heuristic(int agent_num, int max_arrival = INT_MAX) -> TimePointPath;
 
   /**
    * @brief Plans a path for the given agent number using the original Bounded Suboptimal SIPP algorithm.
@@ -313,10 +317,12 @@ public:
    * @param already_planned A set of already planned agents.
    * @param w The suboptimality factor.
    * @param ap Whether to use the ap version.
+   * @param max_arrival The latest allowed arrival to the goal, the search fails if the goal can not be reached sooner.
    *
    * @return A TimePointPath representing the planned path for the agent.
    */
-  auto plan_suboptimal(int agent_num, const std::unordered_set<int>& already_planned, double w = 1.0, bool ap = false) -> TimePointPath;
+  auto plan_suboptimal(int agent_num, const std::unordered_set<int>& already_planned, double w = 1.0, bool ap = false,
+                       int max_arrival = INT_MAX) -> TimePointPath;
 
   /**
    * @brief Reset the SIPP algorithm.
@@ -327,6 +333,73 @@ public:
   }
 
 private:
+  /**
+   * @brief Checks before a search, whether the goal can be reached. The goal can not be reached if another agent rests there or if
+   * it becomes free too late. Sets bound_pruned, if the goal can not be reached within the arrival bound.
+   *
+   * @param goal The goal location.
+   * @param min_time The minimum time the goal can be reached.
+   * @param max_time The estimate of the maximum length of a path.
+   * @param max_arrival The latest allowed arrival to the goal.
+   *
+   * @return True if a search can reach the goal.
+   */
+  auto is_goal_reachable(int goal, int min_time, int max_time, int max_arrival) -> bool;
+
+  /**
+   * @brief The search of plan_sipp_mine, the safe intervals are read through the view of the storage chosen for the search.
+   *
+   * @param agent_num The agent number to plan the path for.
+   * @param max_arrival The latest allowed arrival to the goal.
+   * @param intervals The view of the safe intervals.
+   *
+   * @return A TimePointPath representing the planned path for the agent.
+   */
+  template <typename Intervals>
+  auto search_sipp_mine(int agent_num, int max_arrival, const Intervals& intervals) -> TimePointPath;
+
+  /**
+   * @brief The search of plan_sipp_mine_ap, the safe intervals are read through the view of the storage chosen for the search.
+   *
+   * @param agent_num The agent number to plan the path for.
+   * @param already_planned A set of already planned agents.
+   * @param max_arrival The latest allowed arrival to the goal.
+   * @param intervals The view of the safe intervals.
+   *
+   * @return A TimePointPath representing the planned path for the agent.
+   */
+  template <typename Intervals>
+  auto search_sipp_mine_ap(int agent_num, const std::unordered_set<int>& already_planned, int max_arrival, const Intervals& intervals)
+      -> TimePointPath;
+
+  /**
+   * @brief The search of plan_mapflns_heuristic, the safe intervals are read through the view of the storage chosen for the search.
+   *
+   * @param agent_num The agent number to plan the path for.
+   * @param max_arrival The latest allowed arrival to the goal.
+   * @param intervals The view of the safe intervals.
+   *
+   * @return A TimePointPath representing the planned path for the agent.
+   */
+  template <typename Intervals>
+  auto search_mapflns_heuristic(int agent_num, int max_arrival, const Intervals& intervals) -> TimePointPath;
+
+  /**
+   * @brief The search of plan_suboptimal, the safe intervals are read through the view of the storage chosen for the search.
+   *
+   * @param agent_num The agent number to plan the path for.
+   * @param already_planned A set of already planned agents.
+   * @param w The suboptimality factor.
+   * @param ap Whether to use the ap version.
+   * @param max_arrival The latest allowed arrival to the goal.
+   * @param intervals The view of the safe intervals.
+   *
+   * @return A TimePointPath representing the planned path for the agent.
+   */
+  template <typename Intervals>
+  auto search_suboptimal(int agent_num, const std::unordered_set<int>& already_planned, double w, bool ap, int max_arrival,
+                         const Intervals& intervals) -> TimePointPath;
+
   /**
    * @brief Initialize the information about the iteration. Reset the number of generated and expanded nodes and the iteration number.
    */
@@ -344,6 +417,7 @@ private:
   sipp::NodePool       node_pool;     /**< The pool of SIPP nodes. */
   std::vector<int>     known_max;     /**< The known maximum time for each node. */
   std::vector<int>     known_min;     /**< The known minimum time for each node. */
+  std::vector<int>     exit_distance_buffer; /**< The distances to the goal of the human searches, if it is not a door. */
   std::mt19937&        rnd_generator; /**< The random number generator. */
   const SIPP_settings& settings;      /**< The settings for the SIPP algorithm. */
 
@@ -8,8 +8,9 @@
 
 #pragma once
 #include <climits>
+#include <cstddef>
 #include <iostream>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <unordered_set>
 #include <vector>
@@ -136,7 +137,341 @@ private:
 };
 
 /**
- * @brief The SafeIntervalTable class stores the safe intervals for each location in the grid.
+ * @brief A constant iterator over the safe intervals of a location, which unpacks the intervals stored with 16-bit or 32-bit times.
+ */
+class SafeIntervalIterator
+{
+public:
+  using NarrowInterval    = PackedInterval<uint16_t>;  /**< Safe interval stored with 16-bit times. */
+  using WideInterval      = PackedInterval<int>;       /**< Safe interval stored with 32-bit times. */
+  using iterator_category = std::input_iterator_tag;   /**< The intervals are returned by value. */
+  using value_type        = TimeInterval;              /**< The type of the unpacked interval. */
+  using difference_type   = std::ptrdiff_t;            /**< The type of the distance between iterators. */
+  using pointer           = const TimeInterval*;       /**< The pointer type of the unpacked interval. */
+  using reference         = TimeInterval;              /**< The intervals are returned by value. */
+
+  /**
+   * @brief Holds the unpacked interval, so that its members can be accessed through the iterator.
+   */
+  class ArrowProxy
+  {
+  public:
+    /**
+     * @brief Constructs the proxy of an unpacked interval.
+     *
+     * @param interval_ The unpacked interval.
+     */
+    explicit ArrowProxy(const TimeInterval& interval_) : interval(interval_)
+    {
+    }
+
+    /**
+     * @brief Accesses the unpacked interval.
+     *
+     * @return A pointer to the unpacked interval.
+     */
+    auto operator->() const -> const TimeInterval*
+    {
+      return &interval;
+    }
+
+  private:
+    TimeInterval interval; /**< The unpacked interval. */
+  };
+
+  /**
+   * @brief Constructs an iterator, which does not point to any interval.
+   */
+  SafeIntervalIterator() = default;
+
+  /**
+   * @brief Constructs an iterator over the 16-bit intervals.
+   *
+   * @param narrow_entry_ The pointed interval.
+   */
+  explicit SafeIntervalIterator(const NarrowInterval* narrow_entry_) : narrow_entry(narrow_entry_)
+  {
+  }
+
+  /**
+   * @brief Constructs an iterator over the 32-bit intervals.
+   *
+   * @param wide_entry_ The pointed interval.
+   */
+  explicit SafeIntervalIterator(const WideInterval* wide_entry_) : wide_entry(wide_entry_)
+  {
+  }
+
+  /**
+   * @brief Unpacks the pointed interval.
+   *
+   * @return The pointed interval.
+   */
+  auto operator*() const -> TimeInterval
+  {
+    return narrow_entry != nullptr ? narrow_entry->get_interval() : wide_entry->get_interval();
+  }
+
+  /**
+   * @brief Accesses the members of the pointed interval.
+   *
+   * @return The proxy holding the unpacked interval.
+   */
+  auto operator->() const -> ArrowProxy
+  {
+    return ArrowProxy(**this);
+  }
+
+  /**
+   * @brief Moves to the next interval.
+   *
+   * @return The moved iterator.
+   */
+  auto operator++() -> SafeIntervalIterator&
+  {
+    if (narrow_entry != nullptr)
+    {
+      narrow_entry++;
+    }
+    else
+    {
+      wide_entry++;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Moves to the next interval.
+   *
+   * @return The iterator before the move.
+   */
+  auto operator++(int) -> SafeIntervalIterator
+  {
+    SafeIntervalIterator previous = *this;
+    ++(*this);
+    return previous;
+  }
+
+  /**
+   * @brief Checks whether two iterators point to the same interval.
+   *
+   * @param other The other iterator.
+   *
+   * @return True if the iterators are equal, false otherwise.
+   */
+  auto operator==(const SafeIntervalIterator& other) const -> bool
+  {
+    return narrow_entry == other.narrow_entry && wide_entry == other.wide_entry;
+  }
+
+  /**
+   * @brief Checks whether two iterators point to different intervals.
+   *
+   * @param other The other iterator.
+   *
+   * @return True if the iterators differ, false otherwise.
+   */
+  auto operator!=(const SafeIntervalIterator& other) const -> bool
+  {
+    return !(*this == other);
+  }
+
+private:
+  const NarrowInterval* narrow_entry = nullptr; /**< The pointed 16-bit interval, nullptr if the 32-bit intervals are iterated. */
+  const WideInterval*   wide_entry   = nullptr; /**< The pointed 32-bit interval, nullptr if the 16-bit intervals are iterated. */
+};
+
+/**
+ * @brief Read access to the safe intervals stored with a single time type. The searches get it once from SafeIntervalTable::visit, so
+ * their queries do not check the storage type again.
+ *
+ * @tparam Interval The type of the stored safe intervals.
+ */
+template <typename Interval>
+class SafeIntervalView
+{
+public:
+  /**
+   * @brief A constant iterator over the safe intervals of a location, which unpacks the intervals.
+   */
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::input_iterator_tag; /**< The intervals are returned by value. */
+    using value_type        = TimeInterval;            /**< The type of the unpacked interval. */
+    using difference_type   = std::ptrdiff_t;          /**< The type of the distance between iterators. */
+    using pointer           = const TimeInterval*;     /**< The pointer type of the unpacked interval. */
+    using reference         = TimeInterval;            /**< The intervals are returned by value. */
+
+    /**
+     * @brief Constructs an iterator, which does not point to any interval.
+     */
+    const_iterator() = default;
+
+    /**
+     * @brief Constructs an iterator over the stored intervals.
+     *
+     * @param entry_ The pointed interval.
+     */
+    explicit const_iterator(const Interval* entry_) : entry(entry_)
+    {
+    }
+
+    /**
+     * @brief Unpacks the pointed interval.
+     *
+     * @return The pointed interval.
+     */
+    auto operator*() const -> TimeInterval
+    {
+      return entry->get_interval();
+    }
+
+    /**
+     * @brief Accesses the members of the pointed interval.
+     *
+     * @return The proxy holding the unpacked interval.
+     */
+    auto operator->() const -> SafeIntervalIterator::ArrowProxy
+    {
+      return SafeIntervalIterator::ArrowProxy(**this);
+    }
+
+    /**
+     * @brief Moves to the next interval.
+     *
+     * @return The moved iterator.
+     */
+    auto operator++() -> const_iterator&
+    {
+      entry++;
+      return *this;
+    }
+
+    /**
+     * @brief Moves to the next interval.
+     *
+     * @return The iterator before the move.
+     */
+    auto operator++(int) -> const_iterator
+    {
+      const_iterator previous = *this;
+      entry++;
+      return previous;
+    }
+
+    /**
+     * @brief Checks whether two iterators point to the same interval.
+     *
+     * @param other The other iterator.
+     *
+     * @return True if the iterators are equal, false otherwise.
+     */
+    auto operator==(const const_iterator& other) const -> bool
+    {
+      return entry == other.entry;
+    }
+
+    /**
+     * @brief Checks whether two iterators point to different intervals.
+     *
+     * @param other The other iterator.
+     *
+     * @return True if the iterators differ, false otherwise.
+     */
+    auto operator!=(const const_iterator& other) const -> bool
+    {
+      return entry != other.entry;
+    }
+
+    /**
+     * @brief Returns the pointed stored interval.
+     *
+     * @return The pointed stored interval.
+     */
+    [[nodiscard]] auto base() const -> const Interval*
+    {
+      return entry;
+    }
+
+  private:
+    const Interval* entry = nullptr; /**< The pointed interval. */
+  };
+
+  /**
+   * @brief Constructs the view of the stored safe intervals.
+   *
+   * @param instance_ The instance of the problem.
+   * @param intervals_ The safe intervals of each free location sorted by time.
+   */
+  SafeIntervalView(const Instance& instance_, const std::vector<std::vector<Interval>>& intervals_)
+      : instance(instance_), intervals(intervals_)
+  {
+  }
+
+  /**
+   * @brief Gets the first safe interval for a given location.
+   *
+   * @param location The location to get the first safe interval for.
+   *
+   * @return An iterator to the first safe interval for the given location, it equals the end if there is no safe interval.
+   */
+  [[nodiscard]] auto get_first_safe_interval(int location) const -> const_iterator
+  {
+    assertm(instance.get_map_data().is_in(location), "Invalid location.");
+    return const_iterator(intervals[instance.location_to_free_location(location)].data());
+  }
+
+  /**
+   * @brief Gets the safe intervals for a given location and a time interval.
+   *
+   * @param location The location to get the safe intervals for.
+   * @param time_interval The time interal, the location can be entered. All returned intervals must have nonzero intersection with it.
+   *
+   * @return A pair of iterators representing the range of safe intervals for the given location and time interval.
+   * @warning The returned safe intervals must be checked for edge collisions.
+   */
+  [[nodiscard]] auto get_safe_intervals(int location, const TimeInterval& time_interval) const -> std::pair<const_iterator, const_iterator>
+  {
+    // this implementation does not check edge collisions, so they must be handled elsewhere.
+    assertm(instance.get_map_data().is_in(location), "Invalid location.");
+    const int free_location = instance.location_to_free_location(location);
+    assertm(free_location < instance.get_num_free_cells(), "Safe intervals not precomputed for this location.");
+
+    // iterate over the intervals to find the first and last safe interval
+    const std::vector<Interval>& location_intervals = intervals[free_location];
+    const Interval*              begin              = location_intervals.data();
+    const Interval*              end                = begin + location_intervals.size();
+    const Interval*              start              = end;
+    for (const Interval* it = begin; it != end; it++)
+    {
+      // check whether the interval is inside the given time range
+      if (it->get_t_max() >= time_interval.t_min && it->get_t_min() <= time_interval.t_max)
+      {
+        // remember the first interval in the range
+        if (start == end)
+        {
+          start = it;
+        }
+      }
+      // if the interval is not inside the time range, check whether already found some intervals
+      else if (start != end)
+      {
+        // if already found some intervals, return the found safe intervals
+        return {const_iterator(start), const_iterator(it)};
+      }
+    }
+    return {const_iterator(start), const_iterator(end)};
+  }
+
+private:
+  const Instance&                           instance;  /**< The instance of the problem. */
+  const std::vector<std::vector<Interval>>& intervals; /**< The safe intervals of each free location sorted by time. */
+};
+
+/**
+ * @brief The SafeIntervalTable class stores the safe intervals for each location in the grid. The intervals are stored with 16-bit times
+ * until a constraint does not fit, then the whole table switches to 32-bit times.
  */
 class SafeIntervalTable
 {
@@ -148,6 +483,8 @@ public:
    */
   explicit SafeIntervalTable(const Instance& instance_);
 
+  using const_iterator = SafeIntervalIterator; /**< The iterator over the safe intervals of a location. */
+
   EdgeConstraintTable edge_constraint_table; /**< The edge constraint table, which stores the edge collisions. */
 
 #ifdef SIT_PARALLELIZATION
@@ -206,7 +543,16 @@ public:
    * @warning The returned safe intervals must be checked for edge collisions.
    */
   [[nodiscard]] auto get_safe_intervals(int location, const TimeInterval& time_interval) const
-      -> std::pair<std::list<TimeInterval>::const_iterator, std::list<TimeInterval>::const_iterator>;
+      -> std::pair<const_iterator, const_iterator>;
+
+  /**
+   * @brief Checks whether a path can be added to the table without colliding with the stored constraints.
+   *
+   * @param path The path to check.
+   *
+   * @return True if each time point of the path lies in a safe interval and no edge is used in the opposite direction, false otherwise.
+   */
+  [[nodiscard]] auto is_path_free(const TimePointPath& path) const -> bool;
 
   /**
    * @brief Gets the first safe interval for a given location.
@@ -215,7 +561,7 @@ public:
    *
    * @return  An iterator to the first safe interval for the given location.
    */
-  [[nodiscard]] auto get_first_safe_interval(int location) const -> std::list<TimeInterval>::const_iterator;
+  [[nodiscard]] auto get_first_safe_interval(int location) const -> const_iterator;
 
   /**
    * @brief Calculates the estimate of the maximum path length.
@@ -246,7 +592,7 @@ public:
   [[nodiscard]] auto get_min_reach_time(int goal) const -> int
   {
     assertm(instance.get_map_data().is_in(goal), "Invalid goal location.");
-    return safe_intervals[instance.location_to_free_location(goal)].back().t_min;
+    return get_last_interval(instance.location_to_free_location(goal)).t_min;
   }
 
   /**
@@ -254,12 +600,68 @@ public:
    *
    * @param location The location to get the last safe interval for.
    *
-   * @return A reference to the last safe interval for the given location.
+   * @return The last safe interval for the given location.
+   */
+  [[nodiscard]] auto get_last_safe_interval(int location) const -> TimeInterval
+  {
+    assertm(instance.get_map_data().is_in(location), "Invalid location");
+    return get_last_interval(instance.location_to_free_location(location));
+  }
+
+  /**
+   * @brief Checks whether an agent rests at the location forever, i.e. its constraint there ends at INT_MAX.
+   *
+   * @param location The location to check.
+   *
+   * @return True if the location is never free again, false otherwise.
    */
-  [[nodiscard]] auto get_last_safe_interval(int location) const -> const TimeInterval&
+  [[nodiscard]] auto is_permanently_occupied(int location) const -> bool
   {
     assertm(instance.get_map_data().is_in(location), "Invalid location");
-    return safe_intervals[instance.location_to_free_location(location)].back();
+    return resting_start[instance.location_to_free_location(location)] != INT_MAX;
+  }
+
+  /**
+   * @brief Gets the time from which the location stays free forever.
+   *
+   * @param location The location to check.
+   *
+   * @return The start of the unlimited safe interval of the location, INT_MAX if the location is permanently occupied.
+   */
+  [[nodiscard]] auto get_first_free_time(int location) const -> int
+  {
+    assertm(instance.get_map_data().is_in(location), "Invalid location");
+    const int free_location = instance.location_to_free_location(location);
+    return resting_start[free_location] != INT_MAX ? INT_MAX : get_last_interval(free_location).t_min;
+  }
+
+  /**
+   * @brief Checks whether the safe intervals are stored with 16-bit times.
+   *
+   * @return True if the narrowed storage is used, false otherwise.
+   */
+  [[nodiscard]] auto uses_narrow_storage() const -> bool
+  {
+    return narrow;
+  }
+
+  /**
+   * @brief Calls a function with the view of the safe intervals. The storage type is chosen once, the searches run the queries in their
+   * loops through the view.
+   *
+   * @param function The function called with SafeIntervalView<PackedInterval<uint16_t>> or SafeIntervalView<PackedInterval<int>>.
+   *
+   * @return The value returned by the function.
+   * @warning The view is valid only until the constraints change, as a new constraint can switch the storage.
+   */
+  template <typename Function>
+  auto visit(Function&& function) const -> decltype(auto)
+  {
+    if (narrow)
+    {
+      return function(SafeIntervalView<NarrowInterval>(instance, narrow_intervals));
+    }
+    return function(SafeIntervalView<WideInterval>(instance, wide_intervals));
   }
 
   /**
@@ -267,9 +669,8 @@ public:
    */
   void reset()
   {
-    // reset safe intervals
-    int num_free_cells = static_cast<int>(safe_intervals.size());
-    safe_intervals     = std::vector<std::list<TimeInterval>>(num_free_cells, std::list<TimeInterval>(1, TimeInterval(0, INT_MAX)));
+    // reset safe intervals, the times fit into the narrowed storage again
+    init_safe_intervals();
 
     // reset latest constraint end
     latest_constraint_end         = 0;
@@ -277,6 +678,7 @@ public:
 
     // reset unlimited safe intervals
     unlimited_safe_intervals = instance.get_map_data().get_num_free_cells();
+    std::fill(resting_start.begin(), resting_start.end(), INT_MAX);
 
     // reset max path len estimate
     max_path_len_estimate = INT_MAX;
@@ -286,10 +688,48 @@ public:
   }
 
 private:
-  std::vector<std::list<TimeInterval>> safe_intervals;                  /**< safe intervals for each position */
-  const Instance&                      instance;                        /**< The instance of the problem. */
-  int                                  max_path_len_estimate = INT_MAX; /**< The estimate of the maximum path length. */
+  using NarrowInterval = SafeIntervalIterator::NarrowInterval; /**< Safe interval stored with 16-bit times. */
+  using WideInterval   = SafeIntervalIterator::WideInterval;   /**< Safe interval stored with 32-bit times. */
+
+  /**
+   * @brief Fills each free location with a single unlimited safe interval stored with 16-bit times.
+   */
+  void init_safe_intervals();
+
+  /**
+   * @brief Returns the last safe interval of a free location.
+   *
+   * @param free_location The free location.
+   *
+   * @return The last safe interval.
+   */
+  [[nodiscard]] auto get_last_interval(int free_location) const -> TimeInterval
+  {
+    return narrow ? narrow_intervals[free_location].back().get_interval() : wide_intervals[free_location].back().get_interval();
+  }
+
+  /**
+   * @brief Switches to the 32-bit storage if the safe intervals changed by the constraint do not fit into the narrowed one.
+   *
+   * @param interval The time interval of the constraint.
+   */
+  void widen_if_needed(const TimeInterval& interval);
+
+  /**
+   * @brief Switches to the 32-bit storage if any constraint of the given path does not fit into the narrowed one. Used before the
+   * parallel updates, as the storage can not be switched while other threads access it.
+   *
+   * @param path The path to check.
+   */
+  void widen_if_needed(const TimePointPath& path);
+
+  bool narrow = true; /**< Flag indicating if the 16-bit storage is used. */
+  std::vector<std::vector<NarrowInterval>> narrow_intervals;              /**< 16-bit safe intervals for each position sorted by time */
+  std::vector<std::vector<WideInterval>>   wide_intervals;                /**< 32-bit safe intervals for each position sorted by time */
+  const Instance&                          instance;                      /**< The instance of the problem. */
+  int                                      max_path_len_estimate = INT_MAX; /**< The estimate of the maximum path length. */
   int  unlimited_safe_intervals;             /**< The number of unlimited safe intervals used for the max_path_len_estimate calculation. */
+  std::vector<int> resting_start; /**< The start of the constraint of an agent resting at the location forever, INT_MAX if there is none. */
   int  latest_constraint_end         = 0;    /**< The end of the latest constraint. */
   bool latest_constraint_end_updated = true; /**< Indicates if the latest constraint end has been updated. */
 #ifdef SIT_PARALLELIZATION
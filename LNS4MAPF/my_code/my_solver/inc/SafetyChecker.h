@@ -0,0 +1,348 @@
+/**
+ * @file
+ * @brief Contains the safety checker, which keeps the robot reservations needed for the human safety check between the LNS iterations.
+ */
+
+#pragma once
+
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SafeIntervalTable.h"
+#include "Solver.h"
+
+/**
+ * @brief The safety of one step of a human path.
+ */
+struct SafetyStep
+{
+  int              location         = -1;    /**< The location of the human. */
+  bool             reachable        = false; /**< Whether an exit can be reached from the step. */
+  int              earliest_arrival = -1;    /**< The earliest time the human can enter an exit, -1 if no exit can be reached. */
+  std::vector<int> blocking_robots;          /**< The robots occupying the shortest escape route ignoring the robots, when the human uses it. */
+};
+
+/**
+ * @brief Checks whether the humans can reach an exit from every step of their paths, the robots are treated as dynamic obstacles. The
+ * reservations of the robots are kept between the checks, a candidate solution is applied as a delta of the replaced paths, which is
+ * either committed or rolled back after the acceptance decision.
+ *
+ * The human can wait in a safe interval and move to a free neighboring cell in one timestep, it can not swap cells with a robot. Instead of
+ * a search from every step of every human path and every exit, a single backward sweep started from all exits at once computes the
+ * latest time, at which a human can still leave each safe interval towards the nearest reachable exit. Each step of each human is then
+ * checked by a lookup of the safe interval it lies in.
+ *
+ * The result of each step is kept for the committed reservations. The safety of a step depends only on the reservations the human can reach
+ * from it, so a staged delta invalidates only the steps, from which the human can reach a changed cell before the change ends. If there
+ * are few of them, each is evaluated by its own search instead of the sweep.
+ */
+class SafetyChecker
+{
+public:
+  /**
+   * @brief Constructs the safety checker with empty reservations.
+   *
+   * @param instance_ The instance being solved.
+   * @param num_threads_ The maximal number of threads evaluating the steps in parallel, 1 evaluates them in the calling thread.
+   */
+  explicit SafetyChecker(const Instance& instance_, int num_threads_ = 1);
+
+  /**
+   * @brief Replaces all reservations by the given paths, the staged delta is dropped.
+   *
+   * @param paths The paths of all robots.
+   */
+  void build(const std::vector<TimePointPath>& paths);
+
+  /**
+   * @brief Applies the paths of the overlay to the reservations, the old paths of the destroyed agents are removed.
+   *
+   * @param overlay The repaired overlay, it has to be feasible and its base has to hold the current reservations.
+   */
+  void stage(const SolutionOverlay& overlay);
+
+  /**
+   * @brief Keeps the staged delta, it has to be called when the overlay was committed to its base.
+   */
+  void commit();
+
+  /**
+   * @brief Restores the reservations from before the staged delta.
+   *
+   * @param overlay The staged overlay, it has to be unchanged since stage was called.
+   */
+  void rollback(const SolutionOverlay& overlay);
+
+  /**
+   * @brief Finds the steps of the human paths, from which no exit can be reached, all humans are evaluated by a single sweep. The results of
+   * the committed reservations are reused for the steps, which the staged delta can not influence, if the humans and the exits are the
+   * same.
+   *
+   * @param human_paths The locations of each human at each step, a human waits at the last location of its path.
+   * @param exit_locations The locations of the exits.
+   * @param duration The number of steps to check.
+   * @param stop_at_first Whether to return after the first unsafe step of any human, the searches of the later steps are cancelled.
+   *
+   * @return The unsafe steps of each human in increasing order.
+   */
+  [[nodiscard]] auto get_unsafe_steps(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration,
+                                      bool stop_at_first) -> std::vector<std::vector<int>>;
+
+  /**
+   * @brief Checks whether all humans can reach an exit from every step of their paths.
+   *
+   * @param human_paths The locations of each human at each step, a human waits at the last location of its path.
+   * @param exit_locations The locations of the exits.
+   * @param duration The number of steps to check.
+   *
+   * @return True if an exit is reachable from every step of every human, false otherwise.
+   */
+  [[nodiscard]] auto is_safe(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration) -> bool;
+
+  /**
+   * @brief Evaluates the steps of the human paths, the blocking robots are left empty, as the checker does not know the robots. The steps
+   * are independent once the sweep is done, so they are evaluated by up to num_threads threads.
+   *
+   * @param human_paths The locations of each human at each step, a human waits at the last location of its path.
+   * @param exit_locations The locations of the exits.
+   * @param duration The number of steps to evaluate.
+   *
+   * @return The safety of each step of each human.
+   */
+  [[nodiscard]] auto get_timeline(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration)
+      -> std::vector<std::vector<SafetyStep>>;
+
+  /**
+   * @brief Finds the shortest route of the human to the nearest exit, which ignores the robots. The steps of an unsafe human are blocked
+   * by the robots, which occupy the route at the time the human would be there.
+   *
+   * @param location The location of the human.
+   * @param time The time the human is at the location.
+   * @param exit_locations The locations of the exits.
+   *
+   * @return The route starting at the location and ending in an exit with one time point per timestep, empty if no exit can be reached
+   * even without the robots.
+   * @note Only the first call with new exits computes the distances, the following calls can run in parallel.
+   */
+  [[nodiscard]] auto get_escape_route(int location, int time, const std::vector<int>& exit_locations) -> TimePointPath;
+
+  /**
+   * @brief Checks whether a delta is staged.
+   *
+   * @return True if the last staged delta was neither committed nor rolled back.
+   */
+  [[nodiscard]] auto has_staged() const -> bool
+  {
+    return staged;
+  }
+
+  /**
+   * @brief Returns the reservations of the robots.
+   *
+   * @return The safe interval table holding the paths of the robots.
+   */
+  [[nodiscard]] auto get_safe_interval_table() const -> const SafeIntervalTable&
+  {
+    return safe_interval_table;
+  }
+
+private:
+  static constexpr int UNREACHABLE = -1; /**< The escape time of the safe intervals, from which the exit can not be reached. */
+  static constexpr char STEP_UNSAFE  = 0;  /**< The result of a step, from which no exit can be reached. */
+  static constexpr char STEP_SAFE    = 1;  /**< The result of a step, from which an exit can be reached. */
+  static constexpr char STEP_UNKNOWN = 2;  /**< The result of a step, which was skipped after an earlier unsafe step. */
+  static constexpr int MAX_SEARCHED_STEPS = 64; /**< The number of influenced steps, above which the sweep is used instead of the searches. */
+
+  /**
+   * @brief The cells and times of the reservations changed by a staged path.
+   */
+  struct ChangedRegion
+  {
+    int t_max; /**< The last time of the change, INT_MAX if the paths end in different cells. */
+    int x_min; /**< The bounding box of the changed cells. */
+    int x_max;
+    int y_min;
+    int y_max;
+  };
+
+  /**
+   * @brief Sets the exits used by the next computations, the distances to the exits are dropped, if the exits change.
+   *
+   * @param exit_locations The locations of the exits.
+   */
+  void set_exits(const std::vector<int>& exit_locations);
+
+  /**
+   * @brief Computes the escape times of all safe intervals by a backward sweep from all exits. The intervals are processed from the latest
+   * escape time, so each interval is final when it is taken from the queue, as moving to a neighbor takes one timestep.
+   */
+  void compute_escape_times();
+
+  /**
+   * @brief Evaluates the safety of each step of the human paths, the steps not influenced by the staged delta are taken from the results of
+   * the committed reservations. The searches of the influenced steps run in parallel.
+   *
+   * @param human_paths The locations of each human at each step, a human waits at the last location of its path.
+   * @param exit_locations The locations of the exits.
+   * @param duration The number of steps to evaluate.
+   * @param stop_at_first Whether the steps after the first unsafe step of any human can be skipped.
+   *
+   * @return The result of each step of each human, no steps are evaluated for an empty path. Only the steps after the first unsafe step
+   * are STEP_UNKNOWN.
+   */
+  auto evaluate_steps(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration,
+                      bool stop_at_first) -> std::vector<std::vector<char>>;
+
+  /**
+   * @brief Adds the part of the reservations changed by replacing a path to the staged regions.
+   *
+   * @param old_path The replaced path.
+   * @param new_path The new path.
+   */
+  void add_changed_region(const TimePointPath& old_path, const TimePointPath& new_path);
+
+  /**
+   * @brief Checks whether the human can reach a region changed by the staged delta before the change ends, using the Manhattan distance.
+   *
+   * @param location The location of the human.
+   * @param time The time the human is at the location.
+   *
+   * @return True if the safety of the step may differ from the committed reservations.
+   */
+  [[nodiscard]] auto is_influenced(int location, int time) const -> bool;
+
+  /**
+   * @brief Checks whether the human can reach an exit from a step by an A* search over the safe intervals, the distances to the nearest
+   * exit ignoring the robots are the heuristic. They have to be computed already.
+   *
+   * @param intervals The view of the safe intervals, the storage is chosen once for all searches of the steps.
+   * @param location The location of the human.
+   * @param time The time the human is at the location.
+   *
+   * @return True if an exit can be reached.
+   */
+  template <typename Intervals>
+  [[nodiscard]] auto can_escape(const Intervals& intervals, int location, int time) const -> bool;
+
+  /**
+   * @brief Finds the safe interval of the last sweep, in which the human stands at the given time.
+   *
+   * @param location The location of the human.
+   * @param time The time.
+   *
+   * @return The index of the interval, -1 if the location is not a free cell or it is occupied by a robot at the time.
+   */
+  [[nodiscard]] auto find_interval(int location, int time) const -> int;
+
+  /**
+   * @brief Finds the earliest time the human can enter an exit by a search over the safe intervals of the last sweep. The intervals, from
+   * which no exit can be reached, are pruned by their escape times.
+   *
+   * @param location The location of the human, it must not be an exit.
+   * @param time The time the human is at the location.
+   * @param arrival_time The earliest arrival to each safe interval, the buffer of the calling thread.
+   *
+   * @return The earliest arrival to an exit, UNREACHABLE if there is none.
+   */
+  [[nodiscard]] auto get_earliest_arrival(int location, int time, std::vector<int>& arrival_time) const -> int;
+
+  /**
+   * @brief Checks whether the human can enter a location, these are the free cells and the exits.
+   *
+   * @param location The location to check.
+   *
+   * @return True if the human can enter the location.
+   */
+  [[nodiscard]] auto can_enter(int location) const -> bool
+  {
+    return is_exit[location] || instance.get_map_data().index(location) == 0;
+  }
+
+  /**
+   * @brief Finds the neighboring locations the human can enter, unlike the neighbors of the instance they include the exits.
+   *
+   * @param location The location of the human.
+   *
+   * @return The neighboring free cells and exits.
+   */
+  [[nodiscard]] auto get_adjacent_locations(int location) const -> std::vector<int>;
+
+  /**
+   * @brief Computes the distances to the nearest exit ignoring the robots from the distance fields of the instance, unless they are computed
+   * already.
+   */
+  void compute_exit_distance();
+
+  /**
+   * @brief Checks whether the human can move between two cells in the given time.
+   *
+   * @param from The location the human leaves.
+   * @param to The location the human enters.
+   * @param arrival The time of the arrival.
+   *
+   * @return True if no robot uses the edge in the opposite direction at the same time.
+   */
+  [[nodiscard]] auto is_edge_free(int from, int to, int arrival) const -> bool
+  {
+    return !safe_interval_table.edge_constraint_table.get(to, from, arrival);
+  }
+
+  /**
+   * @brief Finds the latest time in the range, at which the human can leave a cell towards a neighbor.
+   *
+   * @param from The location the human leaves.
+   * @param to The location the human enters.
+   * @param earliest The earliest departure.
+   * @param latest The latest departure, INT_MAX if unbounded.
+   *
+   * @return The latest departure without a swap with a robot, UNREACHABLE if there is none.
+   */
+  [[nodiscard]] auto get_latest_departure(int from, int to, int earliest, int latest) const -> int;
+
+  /**
+   * @brief Finds the earliest time in the range, at which the human can leave a cell towards a neighbor.
+   *
+   * @param from The location the human leaves.
+   * @param to The location the human enters.
+   * @param earliest The earliest departure.
+   * @param latest The latest departure, INT_MAX if unbounded.
+   *
+   * @return The earliest departure without a swap with a robot, UNREACHABLE if there is none.
+   */
+  [[nodiscard]] auto get_earliest_departure(int from, int to, int earliest, int latest) const -> int;
+
+  const Instance&   instance;            /**< The instance being solved. */
+  int               num_threads;         /**< The maximal number of threads evaluating the steps. */
+  SafeIntervalTable safe_interval_table; /**< The reservations of the robots. */
+  bool              staged = false;      /**< Whether a delta is staged. */
+
+  std::vector<int> interval_offset;   /**< The index of the first safe interval of each free location in the vectors below. */
+  std::vector<int> interval_location; /**< The location of each safe interval. */
+  std::vector<int> interval_start;    /**< The start of each safe interval. */
+  std::vector<int> interval_end;      /**< The end of each safe interval. */
+  std::vector<int> escape_time;       /**< The latest time the human can be in each safe interval and still reach the exit. */
+  std::priority_queue<std::pair<int, int>> sweep_queue; /**< The intervals to process by their escape times. */
+  std::vector<int>  exits;         /**< The locations of the exits. */
+  std::vector<bool> is_exit;       /**< Whether each location is an exit. */
+  std::vector<int>  exit_distance; /**< The number of moves from each location to the nearest exit ignoring the robots, INT_MAX if unreachable, empty until computed. */
+  std::vector<int>  distance_buffer; /**< The distances to an exit, which is not a door. */
+
+  std::vector<ChangedRegion>     staged_regions;     /**< The regions changed by the staged delta. */
+  std::vector<std::vector<int>>  cached_human_paths; /**< The human paths of the kept results. */
+  std::vector<int>               cached_exits;       /**< The exits of the kept results. */
+  std::vector<std::vector<char>> committed_safe;     /**< The result of each step in the committed reservations. */
+  std::vector<std::vector<char>> staged_safe;        /**< The result of each step in the staged reservations. */
+  bool has_committed_safe = false; /**< Whether the results of the committed reservations are kept. */
+  bool has_staged_safe    = false; /**< Whether the results of the staged reservations are kept. */
+};
+
+/**
+ * @brief Saves the safety timeline to a JSON file, the locations are stored as x and y coordinates.
+ *
+ * @param filename The name of the file.
+ * @param timeline The safety of each step of each human.
+ * @param instance The solved instance.
+ */
+void save_safety_timeline(const std::string& filename, const std::vector<std::vector<SafetyStep>>& timeline, const Instance& instance);
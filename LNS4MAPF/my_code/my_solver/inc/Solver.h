@@ -7,6 +7,8 @@
  */
 
 #pragma once
+#include <atomic>
+#include <climits>
 #include <memory>
 #include <random>
 #include <string>
@@ -28,6 +30,7 @@ public:
   std::vector<int>           delays;          /**< Delays of the agents. */
   std::vector<int>           destroyed_paths; /**< Destroyed paths */
   std::vector<int>           priorities;      /**< Priorities of the agents. */
+  std::vector<int>           end_time_count;  /**< The number of agents for each end time, used to update the makespan incrementally. */
 
   int cost;          /**< Cost of the solution. */
   int sum_of_delays; /**< Sum of delays calculated as sum of cost - distance of each path. */
@@ -66,12 +69,155 @@ public:
    */
   void calculate_cost(const Instance& instance);
 
+  /**
+   * @brief Replaces the path of an agent and updates the cost incrementally. The cost has to be calculated by calculate_cost before.
+   *
+   * @param agent The agent, whose path is replaced.
+   * @param path The new path of the agent, it is swapped with the old path.
+   * @param instance The instance the solution solves.
+   */
+  void replace_path(int agent, TimePointPath& path, const Instance& instance);
+
   /**
    * @brief Convert the trajectories of the agents to paths.
    */
   void convert_paths() const;
 };
 
+/**
+ * @brief The paths replaced in one LNS iteration, stored as an overlay over the base solution, so that the base solution does not have to be
+ * copied. Accepted paths are committed by swapping them into the base solution.
+ */
+class SolutionOverlay
+{
+public:
+  /**
+   * @brief Constructs an empty overlay.
+   *
+   * @param base_ The solution, whose paths are replaced.
+   */
+  explicit SolutionOverlay(const Solution& base_) : base(base_)
+  {
+  }
+
+  bool                       feasible       = false; /**< Indicates if all destroyed paths were replanned. */
+  bool                       bound_exceeded = false; /**< Indicates if the repair was aborted, because the neighborhood could not improve. */
+  std::vector<int>           destroyed_paths;        /**< The agents, whose paths are replaced. */
+  std::vector<TimePointPath> new_paths;              /**< The new paths of the destroyed agents in the order of destroyed_paths, empty if not planned. */
+
+  /**
+   * @brief Starts a new iteration with the given neighborhood, the buffers of the previous iteration are reused. The overlay is infeasible
+   * until it is repaired.
+   *
+   * @param destroyed The destroyed agents, they are moved to the overlay and the vector is left empty.
+   */
+  void reset(std::vector<int>& destroyed);
+
+  /**
+   * @brief Gets the base solution.
+   *
+   * @return The solution, whose paths are replaced.
+   */
+  [[nodiscard]] auto get_base() const -> const Solution&
+  {
+    return base;
+  }
+
+  /**
+   * @brief Gets the improvement of the sum of costs (and the sum of delays) achieved by the new paths.
+   *
+   * @return The sum of costs of the replaced paths minus the sum of costs of the new paths.
+   */
+  [[nodiscard]] auto get_improvement() const -> int;
+
+  /**
+   * @brief Gets the makespan of the base solution with the new paths, it uses the end time histogram of the base solution.
+   *
+   * @return The latest end time of all paths.
+   */
+  [[nodiscard]] auto get_makespan() const -> int;
+
+  /**
+   * @brief Swaps the new paths into the base solution and updates its cost incrementally. The overlay then holds the replaced paths.
+   *
+   * @param sol The base solution.
+   * @param instance The instance the solution solves.
+   */
+  void commit(Solution& sol, const Instance& instance);
+
+  /**
+   * @brief Creates a full copy of the base solution with the new paths, it is meant only for the visualization and validation.
+   *
+   * @param instance The instance the solution solves.
+   *
+   * @return The solution with the replaced paths.
+   */
+  [[nodiscard]] auto to_solution(const Instance& instance) const -> Solution;
+
+private:
+  const Solution& base; /**< The solution, whose paths are replaced. */
+};
+
+/**
+ * @brief The best solution shared by the solvers of a portfolio. The solution is exchanged by atomic operations on a shared pointer, so a
+ * published solution is never modified and the readers do not block the publishers.
+ */
+class SharedSolution
+{
+public:
+  /**
+   * @brief Publishes the solution, if it is better than the shared one.
+   *
+   * @param sol The feasible solution to be published, its cost has to be calculated.
+   *
+   * @return True if the solution became the shared best, false otherwise.
+   */
+  auto publish(const Solution& sol) -> bool;
+
+  /**
+   * @brief Gets the shared best solution.
+   *
+   * @return A pointer to the best solution, nullptr if no solution was published yet.
+   */
+  [[nodiscard]] auto get_best() const -> std::shared_ptr<const Solution>
+  {
+    return std::atomic_load(&best);
+  }
+
+  /**
+   * @brief Gets the sum of costs of the shared best solution, it is cheaper than loading the solution.
+   *
+   * @return The sum of costs, INT_MAX if no solution was published yet.
+   */
+  [[nodiscard]] auto get_best_cost() const -> int
+  {
+    return best_cost.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Signals the other solvers of the portfolio to stop.
+   */
+  void finish()
+  {
+    finished.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @brief Checks whether a solver of the portfolio already finished.
+   *
+   * @return True if the solvers should stop, false otherwise.
+   */
+  [[nodiscard]] auto is_finished() const -> bool
+  {
+    return finished.load(std::memory_order_acquire);
+  }
+
+private:
+  std::shared_ptr<const Solution> best;                /**< The best published solution. */
+  std::atomic<int>                best_cost{INT_MAX};  /**< The sum of costs of the best published solution. */
+  std::atomic<bool>               finished{false};     /**< Indicates whether a solver of the portfolio finished. */
+};
+
 /**
  * @brief A class that represents a solver for the MAPF problem.
  */
@@ -17,6 +17,7 @@
 #include <chrono>
 #include <climits>
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 /**
@@ -326,6 +327,119 @@ public:
  */
 auto overlap(const TimeInterval& i1, const TimeInterval& i2) -> bool;
 
+/**
+ * @brief A time interval stored with a narrowed time type. The infinite end of an interval (INT_MAX) is stored as the maximal value of
+ * time_type.
+ *
+ * @tparam time_type The type used to store the times.
+ */
+template <typename time_type>
+class PackedInterval
+{
+public:
+  /**
+   * @brief Constructs a packed interval, the times have to fit into the narrowed type.
+   *
+   * @param interval The time interval.
+   */
+  explicit PackedInterval(const TimeInterval& interval) : t_min(pack_time(interval.t_min)), t_max(pack_time(interval.t_max))
+  {
+    assertm(fits(interval), "The interval does not fit into the narrowed type.");
+  }
+
+  /**
+   * @brief Checks whether a time can be stored with the narrowed type.
+   *
+   * @param time The time to check.
+   *
+   * @return True if the time fits, false otherwise.
+   */
+  static auto fits_time(int time) -> bool
+  {
+    return time == INT_MAX || (time >= 0 && static_cast<long long>(time) < static_cast<long long>(INFINITE_TIME));
+  }
+
+  /**
+   * @brief Checks whether an interval can be stored with the narrowed type.
+   *
+   * @param interval The interval to check.
+   *
+   * @return True if both times fit, false otherwise.
+   */
+  static auto fits(const TimeInterval& interval) -> bool
+  {
+    return fits_time(interval.t_min) && fits_time(interval.t_max);
+  }
+
+  /**
+   * @brief Returns the start of the interval.
+   *
+   * @return The start of the interval.
+   */
+  [[nodiscard]] auto get_t_min() const -> int
+  {
+    return unpack_time(t_min);
+  }
+
+  /**
+   * @brief Returns the end of the interval, INT_MAX if infinite.
+   *
+   * @return The end of the interval, INT_MAX if infinite.
+   */
+  [[nodiscard]] auto get_t_max() const -> int
+  {
+    return unpack_time(t_max);
+  }
+
+  /**
+   * @brief Returns the unpacked interval.
+   *
+   * @return The interval.
+   */
+  [[nodiscard]] auto get_interval() const -> TimeInterval
+  {
+    return {get_t_min(), get_t_max()};
+  }
+
+  /**
+   * @brief Sets the start of the interval, the time has to fit into the narrowed type.
+   *
+   * @param time The new start of the interval.
+   */
+  void set_t_min(int time)
+  {
+    assertm(fits_time(time), "The time does not fit into the narrowed type.");
+    t_min = pack_time(time);
+  }
+
+  /**
+   * @brief Sets the end of the interval, the time has to fit into the narrowed type.
+   *
+   * @param time The new end of the interval, INT_MAX if infinite.
+   */
+  void set_t_max(int time)
+  {
+    assertm(fits_time(time), "The time does not fit into the narrowed type.");
+    t_max = pack_time(time);
+  }
+
+private:
+  static constexpr time_type INFINITE_TIME = std::numeric_limits<time_type>::max(); /**< The stored value of INT_MAX. */
+
+  static auto pack_time(int time) -> time_type
+  {
+    return time == INT_MAX ? INFINITE_TIME : static_cast<time_type>(time);
+  }
+
+  static auto unpack_time(time_type time) -> int
+  {
+    return time == INFINITE_TIME ? INT_MAX : static_cast<int>(time);
+  }
+
+  time_type t_min; /**< The start of the interval. */
+  time_type t_max; /**< The end of the interval. */
+};
+
 /**
  * @brief A class that represents a location along with its time interval.
  */
@@ -7,13 +7,16 @@
 
 #include "Computation.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <iostream>
 
 #include "LNS.h"
 
-Computation::Computation(const Instance& instance_, SharedData* shared_data_, LNS_settings lns_settings_, int seed_ = -1)
-  : instance(instance_), running(false), shared_data(shared_data_), seed(seed_), lns_settings(lns_settings_){
+Computation::Computation(const Instance& instance_, SharedData* shared_data_, LNS_settings lns_settings_, int seed_ = -1,
+                         int portfolio_size_)
+  : instance(instance_), running(false), shared_data(shared_data_), seed(seed_), lns_settings(lns_settings_), portfolio_size(portfolio_size_){
   // initialized the random generator
   if (seed < 0)
   {
@@ -26,8 +29,60 @@ Computation::Computation(const Instance& instance_, SharedData* shared_data_, LN
     rnd_generator = std::mt19937(seed);
   }
 
+  // the solvers of the portfolio run in parallel, so they share the threads of the safety evaluation
+  lns_settings.safety_threads = std::max(1, lns_settings.safety_threads / std::max(portfolio_size, 1));
+
   // initialize the solver
   solver = std::make_unique<LNS>(instance, rnd_generator, shared_data, lns_settings);
+
+  // initialize the other members of the portfolio, the settings and generators are referenced, so they must not be reallocated
+  if (portfolio_size > 1)
+  {
+    portfolio_settings.reserve(portfolio_size - 1);
+    portfolio_generators.reserve(portfolio_size - 1);
+    for (int member = 1; member < portfolio_size; member++)
+    {
+      portfolio_settings.push_back(get_portfolio_settings(member));
+      portfolio_generators.emplace_back(seed < 0 ? std::random_device()() : seed + member);
+      portfolio.push_back(std::make_unique<LNS>(instance, portfolio_generators.back(), shared_data, portfolio_settings.back()));
+      portfolio.back()->portfolio = &shared_solution;
+    }
+    solver->portfolio = &shared_solution;
+  }
+}
+
+auto Computation::get_portfolio_settings(int member) const -> LNS_settings
+{
+  LNS_settings member_settings = lns_settings;
+  if (member == 0)
+  {
+    return member_settings;
+  }
+
+  // only the first member provides the visualization and experiment info
+  member_settings.sipp_settings.info_type = INFO_type::no_info;
+
+  // vary the destroy strategy
+  constexpr std::array<DESTROY_TYPE, 4> destroy_types = {DESTROY_TYPE::ADAPTIVE, DESTROY_TYPE::RANDOMWALK, DESTROY_TYPE::INTERSECTION,
+                                                         DESTROY_TYPE::BLOCKED};
+  member_settings.destroy_settings.type = destroy_types[member % destroy_types.size()];
+
+  // vary the neighborhood size between a half and a double of the given size
+  constexpr std::array<double, 3> size_factors = {1.0, 0.5, 2.0};
+  const int size = static_cast<int>(lns_settings.destroy_settings.size * size_factors[(member / destroy_types.size()) % size_factors.size()]);
+  if (size >= 2 && size < instance.get_num_of_agents())
+  {
+    member_settings.destroy_settings.size = size;
+  }
+
+  // vary the optimal SIPP implementations
+  if (lns_settings.sipp_settings.w == 1.0 && member % 2 == 1)
+  {
+    member_settings.sipp_settings.implementation = lns_settings.sipp_settings.implementation == SIPP_implementation::SIPP_mine_ap
+                                                       ? SIPP_implementation::SIPP_mine
+                                                       : SIPP_implementation::SIPP_mine_ap;
+  }
+  return member_settings;
 }
 
 Computation::~Computation()
@@ -59,7 +114,27 @@ void Computation::join_thread()
 
 void Computation::run()
 {
+  // run the other members of the portfolio, the first one to finish stops the rest
+  std::vector<std::thread> portfolio_threads;
+  portfolio_threads.reserve(portfolio.size());
+  for (auto& member : portfolio)
+  {
+    portfolio_threads.emplace_back(&LNS::solve, member.get());
+  }
   solver->solve();
+  for (auto& thread : portfolio_threads)
+  {
+    thread.join();
+  }
+
+  // return the best solution of the portfolio, in the safety mode only the verified safe solutions are shared
+  auto best = shared_solution.get_best();
+  if (best != nullptr &&
+      (!solver->solution.feasible || !solver->is_verified_safe() || best->sum_of_costs < solver->solution.sum_of_costs))
+  {
+    solver->solution = *best;
+  }
+
   if (solver->solution.feasible)
   {
     std::cout << "Final solution has sum of costs: " << solver->solution.sum_of_costs << std::endl;
@@ -68,18 +143,39 @@ void Computation::run()
   {
     std::cout << "Unable to find feasible solution." << std::endl;
   }
+
+  // the report and the saved timeline describe the returned solution
+  safety_timeline = solver->get_safety_timeline();
+  LNS::print_safety_report(safety_timeline);
   running.store(false, std::memory_order_release);
 }
 
-void Computation::set_safety_params(bool safety_aware, int human_start, int door_loc)
+void Computation::set_safety_params(bool safety_aware, const std::vector<int>& human_starts, const std::vector<int>& door_locs)
 {
   if (solver) {
     solver->safety_aware_mode = safety_aware;
-    solver->human_start_location = human_start;
-    solver->safety_exit_location = door_loc;
+    solver->human_start_locations = human_starts;
+    solver->safety_exit_locations = door_locs;
+
+    // all members check the safety, they share only the solutions verified to be safe
+    for (auto& member : portfolio)
+    {
+      member->safety_aware_mode     = safety_aware;
+      member->human_start_locations = human_starts;
+      member->safety_exit_locations = door_locs;
+    }
     
     std::cout << "Safety params set. Mode: " << safety_aware 
-              << ", Human start loc: " << human_start 
-              << ", Door loc: " << door_loc << std::endl;
+              << ", Humans: " << human_starts.size() 
+              << ", Doors: " << door_locs.size() << std::endl;
+  }
+}
+
+void Computation::update_human_position(int human, int location, int time)
+{
+  solver->push_human_update(human, location, time);
+  for (auto& member : portfolio)
+  {
+    member->push_human_update(human, location, time);
   }
 }
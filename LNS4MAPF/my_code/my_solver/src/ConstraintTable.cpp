@@ -8,12 +8,79 @@
 #include "ConstraintTable.h"
 
 #include <omp.h>
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <climits>
 #include <iostream>
 
 constexpr int NUM_DIRECTIONS = magic_enum::enum_count<Direction>() - 1;  // dont consider NONE direction
-                                                                         //
+
+// helper functions working on the sorted constraint vectors of a single location, they are shared by both widths of the storage
+template <typename Constraint>
+static void insert_constraint(std::vector<Constraint>& cur_TI_list, const TimeInterval& interval, int agent_num)
+{
+  // insert before the first interval that starts later
+  auto it = std::upper_bound(cur_TI_list.begin(), cur_TI_list.end(), interval.t_min,
+                             [](int time, const Constraint& constraint) { return time < constraint.get_t_min(); });
+
+  // check that the intervals do not have any overlap, the neighboring intervals are sufficient as the intervals are sorted
+  assertm(it == cur_TI_list.end() || !overlap(it->get_interval(), interval), "Cannot add overlapping constraints.");
+  assertm(it == cur_TI_list.begin() || !overlap(std::prev(it)->get_interval(), interval), "Cannot add overlapping constraints.");
+  cur_TI_list.insert(it, Constraint(interval, agent_num));
+}
+
+template <typename Constraint>
+static auto erase_constraint(std::vector<Constraint>& cur_TI_list, const TimeInterval& interval) -> bool
+{
+  // the interval is the only one starting at its t_min
+  auto it = std::lower_bound(cur_TI_list.begin(), cur_TI_list.end(), interval.t_min,
+                             [](const Constraint& constraint, int time) { return constraint.get_t_min() < time; });
+  if (it != cur_TI_list.end() && it->get_interval() == interval)
+  {
+    cur_TI_list.erase(it);
+    return true;
+  }
+  return false;
+}
+
+template <typename Constraint>
+static auto find_blocking_agent(const std::vector<Constraint>& cur_TI_list, int time) -> int
+{
+  // only the last interval starting before or at the time can contain it
+  auto it = std::upper_bound(cur_TI_list.begin(), cur_TI_list.end(), time,
+                             [](int t, const Constraint& constraint) { return t < constraint.get_t_min(); });
+  if (it != cur_TI_list.begin() && std::prev(it)->get_t_max() >= time)
+  {
+    return std::prev(it)->get_agent_num();
+  }
+  return -1;
+}
+
+template <typename Constraint>
+static auto find_blocking_agents(const std::vector<Constraint>& cur_TI_list, int time_min) -> std::vector<int>
+{
+  assertm(!cur_TI_list.empty(), "Trying to get blocking agents from an empty list.");
+  assertm(cur_TI_list.back().get_t_max() == INT_MAX, "Last interval should be infinite.");
+
+  // the intervals do not overlap, so they are sorted by t_max as well, find the first one that ends at time_min or later
+  auto first_blocking = std::lower_bound(cur_TI_list.begin(), std::prev(cur_TI_list.end()), time_min,
+                                         [](const Constraint& constraint, int time) { return constraint.get_t_max() < time; });
+
+  // iterate over the constraints from end to beginning (skip the last interval, as agent can not block itself)
+  std::vector<int> blocking_agents_vec = {};
+  for (auto it = std::prev(cur_TI_list.end()); it != first_blocking;)
+  {
+    it--;
+    // check whether the agent was not already added, there are only a few agents in the suffix
+    const int agent_num = it->get_agent_num();
+    if (std::find(blocking_agents_vec.begin(), blocking_agents_vec.end(), agent_num) == blocking_agents_vec.end())
+    {
+      blocking_agents_vec.push_back(agent_num);
+    }
+  }
+  return blocking_agents_vec;
+}
+
 ConstraintTable::ConstraintTable(const Instance& instance_)
     : edge_constraint_table(instance_),
       instance(instance_)
@@ -24,54 +91,69 @@ ConstraintTable::ConstraintTable(const Instance& instance_)
 {
   // initialize the constraint vectors, static obstacles dont need constraint vectors
   const int num_free_cells = instance.get_num_free_cells();
-  constraints   = std::vector<std::list<std::pair<TimeInterval, int>>>(num_free_cells, std::list<std::pair<TimeInterval, int>>());
-  agents_counts = std::vector<std::unordered_map<int, int>>(num_free_cells, std::unordered_map<int, int>());
+  agents_counts            = std::vector<AgentCounts>(num_free_cells);
+
+  // use the 16-bit storage if all agent numbers fit, times that do not fit switch to the 32-bit storage later
+  narrow = NarrowConstraint::fits(TimeInterval(0, INT_MAX), instance.get_num_of_agents() - 1);
+  if (narrow)
+  {
+    narrow_constraints = std::vector<std::vector<NarrowConstraint>>(num_free_cells);
+  }
+  else
+  {
+    wide_constraints = std::vector<std::vector<WideConstraint>>(num_free_cells);
+  }
 }
 
-void ConstraintTable::add_constraint(const TimePoint& timepoint, int agent_num)
+void ConstraintTable::widen_if_needed(const TimeInterval& interval, int agent_num)
 {
-  // check the location is valid
-  assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
-  assertm(agent_num >= 0 && agent_num < instance.get_num_of_agents(), "Invalid agent number.");
-  int                                      free_location = instance.location_to_free_location(timepoint.location);
-  std::list<std::pair<TimeInterval, int>>& cur_TI_list   = constraints[free_location];
-
-  bool inserted = false;
-  // find where to insert the interval
-  for (auto it = cur_TI_list.cbegin(); it != cur_TI_list.cend(); it++)
+  if (!narrow || NarrowConstraint::fits(interval, agent_num))
   {
-    // check that the intervals do not have any overlap
-
-    assertm(!overlap((*it).first, timepoint.interval), "Cannot add overlapping constraints.");
+    return;
+  }
 
-    // insert before the first interval that starts later
-    if (it->first.t_min > timepoint.interval.t_min)
+  // move all constraints to the 32-bit storage
+  wide_constraints = std::vector<std::vector<WideConstraint>>(narrow_constraints.size());
+  for (int i = 0; i < static_cast<int>(narrow_constraints.size()); i++)
+  {
+    wide_constraints[i].reserve(narrow_constraints[i].size());
+    for (const auto& constraint : narrow_constraints[i])
     {
-      // check that there is no overlap
-      // assertm(timepoint.interval.t_max < it->t_min, "Cannot add overlapping constraints.");
-      cur_TI_list.insert(it, {timepoint.interval, agent_num});
-      inserted = true;
-      break;
+      wide_constraints[i].emplace_back(constraint.get_interval(), constraint.get_agent_num());
     }
   }
+  narrow_constraints.clear();
+  narrow_constraints.shrink_to_fit();
+  narrow = false;
+}
 
-  // if no interval starts later, insert to the back of the list
-  if (!inserted)
+void ConstraintTable::widen_if_needed(const TimePointPath& path, int agent_num)
+{
+  for (const auto& timepoint : path)
   {
-    cur_TI_list.emplace_back(timepoint.interval, agent_num);
+    widen_if_needed(timepoint.interval, agent_num);
   }
+}
 
-  // add to the set of visiting agents
-  // if the agent is not yet in the set, add it with count 1
-  if (agents_counts[free_location].find(agent_num) == agents_counts[free_location].end())
+void ConstraintTable::add_constraint(const TimePoint& timepoint, int agent_num)
+{
+  // check the location is valid
+  assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
+  assertm(agent_num >= 0 && agent_num < instance.get_num_of_agents(), "Invalid agent number.");
+  int free_location = instance.location_to_free_location(timepoint.location);
+
+  widen_if_needed(timepoint.interval, agent_num);
+  if (narrow)
   {
-    agents_counts[free_location][agent_num] = 1;
+    insert_constraint(narrow_constraints[free_location], timepoint.interval, agent_num);
   }
   else
   {
-    // else increase the count
-    agents_counts[free_location][agent_num] += 1;
+    insert_constraint(wide_constraints[free_location], timepoint.interval, agent_num);
   }
+
+  // add to the set of visiting agents
+  agents_counts[free_location].increment(agent_num);
 }
 
 void ConstraintTable::remove_constraint(const TimePoint& timepoint, int agent_num)
@@ -80,29 +162,19 @@ void ConstraintTable::remove_constraint(const TimePoint& timepoint, int agent_nu
   assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
   int free_location = instance.location_to_free_location(timepoint.location);
 
-
-  std::list<std::pair<TimeInterval, int>>& cur_TI_list = constraints[free_location];
-
   // check that the list is not empty
-  assertm(!cur_TI_list.empty(), "Trying to remove interval from an empty list.");
+  assertm(!(narrow ? narrow_constraints[free_location].empty() : wide_constraints[free_location].empty()),
+          "Trying to remove interval from an empty list.");
 
-  assertm(agents_counts[free_location].find(agent_num) != agents_counts[free_location].end(),
-          "Removing agent that is not in the agents counts");
-  agents_counts[free_location][agent_num] -= 1;
-  // if the count drops to 0, erase the agent number from keys
-  if (agents_counts[free_location][agent_num] == 0)
-  {
-    agents_counts[free_location].erase(agent_num);
-  }
+  assertm(agents_counts[free_location].count(agent_num) > 0, "Removing agent that is not in the agents counts");
+  agents_counts[free_location].decrement(agent_num);
 
   // remove the interval from the list
-  for (auto it = cur_TI_list.cbegin(); it != cur_TI_list.cend(); it++)
+  const bool erased = narrow ? erase_constraint(narrow_constraints[free_location], timepoint.interval)
+                             : erase_constraint(wide_constraints[free_location], timepoint.interval);
+  if (erased)
   {
-    if ((*it).first == timepoint.interval)
-    {
-      cur_TI_list.erase(it);
-      return;
-    }
+    return;
   }
   // if the interval was not found, throw an error
   throw std::runtime_error("Trying to remove non-existing interval from the constraint table.");
@@ -130,6 +202,8 @@ void ConstraintTable::add_constraints(const TimePointPath& path, int agent_num)
 #ifdef CT_PARALLELIZATION
 void ConstraintTable::add_constraints_parallel(const TimePointPath& path, int agent_num)
 {
+  // the storage has to be switched before the threads access it
+  widen_if_needed(path, agent_num);
 #pragma omp parallel for
   for (int i = 0; i < (int)path.size(); i++)
   {
@@ -209,31 +283,9 @@ auto ConstraintTable::get_blocking_agent(int from, int to, int time) const -> st
 
   int to_free = instance.location_to_free_location(to);
 
-  const std::list<std::pair<TimeInterval, int>>& cur_TI_list = constraints[to_free];
-
-  // if there are no constraints, return -1 (no agent blocking the square)
-  if (cur_TI_list.empty())
-  {
-    return std::make_pair(-1, -1);
-  };
-
-  // find the constraint
-  int vertex_constraint = -1;
-  for (const auto& it : cur_TI_list)
-  {
-    const TimeInterval& constraint_tp = it.first;
-    if (constraint_tp.t_min <= time && constraint_tp.t_max >= time)
-    {
-      // return the agent that created the constraint
-      vertex_constraint = it.second;
-      break;
-    }
-    // skip constraints that are too late
-    if (constraint_tp.t_min > time)
-    {
-      break;
-    }
-  }
+  // find the constraint, the storage is checked once and the search is templated, without constraints no agent blocks the square
+  const int vertex_constraint =
+      narrow ? find_blocking_agent(narrow_constraints[to_free], time) : find_blocking_agent(wide_constraints[to_free], time);
 
   // find edge constraint
   int edge_constraint = -1;
@@ -255,41 +307,7 @@ auto ConstraintTable::get_blocking_agents(int location, int time_min) const -> s
 
   int to_free = instance.location_to_free_location(location);
 
-  const std::list<std::pair<TimeInterval, int>>& cur_TI_list = constraints[to_free];
-
-  // if there are no constraints, return -1 (no agent blocking the square)
-  assertm(!cur_TI_list.empty(), "Trying to get blocking agents from an empty list.");
-
-  std::unordered_set<int> blocking_agents     = {};
-  std::vector<int>        blocking_agents_vec = {};
-  assertm(cur_TI_list.back().first.t_max == INT_MAX, "Last interval should be infinite.");
-
-  // check how many intervals are present
-  if (cur_TI_list.size() < 2)
-  {
-    return {};
-  }
-
-  // iterate over the constraints from end to beginning (skip the last interval, as agent can not block itself)
-  for (auto it = std::next(cur_TI_list.rbegin()); it != cur_TI_list.rend(); it++)
-  {
-    // std::cout << "Interval: " << it->first << ", agent: " << it->second << std::endl;
-    if (it->first.t_max < time_min)
-    {
-      // there can not be any more blocking agents
-      break;
-    }
-
-    // check whether the agent was not already added
-    const int agent_num = it->second;
-    if (blocking_agents.find(agent_num) == blocking_agents.end())
-    {
-      // add the agent to the set
-      blocking_agents.insert(agent_num);
-      blocking_agents_vec.push_back(agent_num);
-    }
-  }
-  return blocking_agents_vec;
+  return narrow ? find_blocking_agents(narrow_constraints[to_free], time_min) : find_blocking_agents(wide_constraints[to_free], time_min);
 }
 
 
@@ -305,6 +323,11 @@ void ConstraintTable::build_sequential(const std::vector<TimePointPath>& paths)
 #ifdef CT_PARALLELIZATION
 void ConstraintTable::build_parallel(const std::vector<TimePointPath>& paths)
 {
+  // the storage has to be switched before the threads access it
+  for (int agent_num = 0; agent_num < static_cast<int>(paths.size()); agent_num++)
+  {
+    widen_if_needed(paths[agent_num], agent_num);
+  }
 #pragma omp parallel for
   for (int agent_num = 0; agent_num < static_cast<int>(paths.size()); agent_num++)
   {
@@ -358,6 +381,8 @@ void ConstraintTable::build_parallel_2(const std::vector<TimePointPath>& paths)
       }
       idx++;
     }
+    // the storage has to be switched before the threads access it
+    widen_if_needed(path, i);
   }
 
 #pragma omp parallel for
@@ -381,6 +406,88 @@ void ConstraintTable::build_parallel_2(const std::vector<TimePointPath>& paths)
 }
 #endif
 
+// helper comparing an entry of AgentCounts with an agent number
+static auto agent_num_less(const AgentCounts::value_type& entry, int agent_num) -> bool
+{
+  return entry.first < agent_num;
+}
+
+void AgentCounts::increment(int agent_num)
+{
+  value_type* first = is_spilled() ? spilled_entries.data() : inline_entries.data();
+  value_type* last  = first + num_entries;
+  value_type* it    = std::lower_bound(first, last, agent_num, agent_num_less);
+
+  // the agent already visits the location
+  if (it != last && it->first == agent_num)
+  {
+    it->second++;
+    return;
+  }
+
+  const auto position = it - first;
+  if (num_entries < INLINE_CAPACITY)
+  {
+    // there is still space in the inline buffer, shift the later entries
+    std::move_backward(it, last, last + 1);
+    *it = {agent_num, 1};
+  }
+  else if (num_entries == INLINE_CAPACITY)
+  {
+    // the inline buffer is full, spill all entries to the heap
+    spilled_entries.reserve(2 * INLINE_CAPACITY);
+    spilled_entries.assign(inline_entries.begin(), inline_entries.end());
+    spilled_entries.insert(spilled_entries.begin() + position, {agent_num, 1});
+  }
+  else
+  {
+    spilled_entries.insert(spilled_entries.begin() + position, {agent_num, 1});
+  }
+  num_entries++;
+}
+
+void AgentCounts::decrement(int agent_num)
+{
+  value_type* first = is_spilled() ? spilled_entries.data() : inline_entries.data();
+  value_type* last  = first + num_entries;
+  value_type* it    = std::lower_bound(first, last, agent_num, agent_num_less);
+  assertm(it != last && it->first == agent_num, "Decrementing agent that is not present.");
+
+  it->second--;
+  // erase the agent when the count drops to 0
+  if (it->second > 0)
+  {
+    return;
+  }
+
+  if (is_spilled())
+  {
+    spilled_entries.erase(spilled_entries.begin() + (it - first));
+    num_entries--;
+    // move the entries back to the inline buffer once they fit
+    if (num_entries == INLINE_CAPACITY)
+    {
+      std::copy(spilled_entries.begin(), spilled_entries.end(), inline_entries.begin());
+      spilled_entries.clear();
+    }
+  }
+  else
+  {
+    std::move(it + 1, last, it);
+    num_entries--;
+  }
+}
+
+auto AgentCounts::count(int agent_num) const -> int
+{
+  const value_type* it = std::lower_bound(begin(), end(), agent_num, agent_num_less);
+  if (it != end() && it->first == agent_num)
+  {
+    return it->second;
+  }
+  return 0;
+}
+
 EdgeConstraintTableWithAgentNums::EdgeConstraintTableWithAgentNums(const Instance& instance_) : instance(instance_)
 {
   // initialize the edge constraints
@@ -228,6 +228,7 @@ void Experiment::run()
             solver.log.bsf_solution_cost.push_back(init_sol.sum_of_costs);
             solver.log.bsf_makespan.push_back(init_sol.makespan);
             solver.log.used_operator.push_back(DESTROY_TYPE::ADAPTIVE);
+            solver.log.neighborhood_size.push_back(algo.lns_settings.destroy_settings.size);
             solver.log.iteration_time_wall.push_back(0);
             solver.log.iteration_time_cpu.push_back(0);
           }
@@ -241,6 +242,17 @@ void Experiment::run()
           // calculate the cost
           solver.solution.calculate_cost(instance);
 
+          // statistics of the destroy operators
+          nlohmann::json operator_stats;
+          for (auto type : magic_enum::enum_values<DESTROY_TYPE>())
+          {
+            const OperatorStats& stats = solver.log.operator_stats[magic_enum::enum_index(type).value()];
+            operator_stats[std::string(magic_enum::enum_name(type))] = {{"calls", stats.calls},
+                                                                        {"improvements", stats.improvements},
+                                                                        {"total_improvement", stats.total_improvement},
+                                                                        {"total_time", stats.total_time}};
+          }
+
           // write the results of the experiment
           const std::string algorithm_name = algo.get_name();
           nlohmann::json    experiment_res = {{"experiment_name", experiment_name},
@@ -260,6 +272,8 @@ void Experiment::run()
                                            {"iteration_time_wall", solver.log.iteration_time_wall},
                                            {"iteration_time_cpu", solver.log.iteration_time_cpu},
                                            {"operators", solver.log.get_used_operator_str()},
+                                           {"operator_stats", operator_stats},
+                                           {"neighborhood_size", solver.log.neighborhood_size},
                                            {"expanded", solver.get_num_of_expanded_nodes()},
                                            {"generated", solver.get_num_of_generated_nodes()},
                                            {"seed", seed}};
@@ -21,6 +21,8 @@
 #include <limits>
 #include <numeric>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <boost/algorithm/string.hpp>
 #include <fstream>
 #include <iostream>
@@ -87,6 +89,8 @@ void Instance::reset()
   heuristic_euclidean.clear();
 #endif
   heuristic_distance.clear();
+  location_to_door_array.clear();
+  door_distances.reset();
   sum_of_distances = 0;
 }
 
@@ -241,6 +245,73 @@ void Instance::calculate_heuristics(bool calculate_manhattan, bool calculate_euc
   heuristic_distance.clear();
   heuristic_distance.resize(num_of_agents, int_initializer);
   calculate_distance_heuristic();
+
+  // index the doors, they are the exits of the humans, the distances to them are calculated only if a human uses them
+  location_to_door_array.assign(map_data.width * map_data.height, -1);
+  int num_doors = 0;
+  for (int i = 0; i < map_data.width * map_data.height; i++)
+  {
+    if (map_data.index(i) == 2)
+    {
+      location_to_door_array[i] = num_doors++;
+    }
+  }
+  door_distances             = std::make_shared<DoorDistances>();
+  door_distances->distance   = std::vector<std::vector<int>>(num_doors);
+  door_distances->calculated = std::make_unique<std::once_flag[]>(num_doors);
+}
+
+void Instance::calculate_exit_distance(int exit_location, std::vector<int>& distance) const
+{
+  assertm(map_data.is_in(exit_location) && map_data.index(exit_location) != 1, "Invalid exit location.");
+  distance.assign(map_data.width * map_data.height, -1);
+
+  // breadth first search from the exit through the free cells
+  std::vector<int> open_list = {exit_location};
+  distance[exit_location]    = 0;
+  for (size_t i = 0; i < open_list.size(); i++)
+  {
+    const int location = open_list[i];
+    for (int neighbor : get_neighbor_locations(location))
+    {
+      if (distance[neighbor] == -1)
+      {
+        distance[neighbor] = distance[location] + 1;
+        open_list.push_back(neighbor);
+      }
+    }
+  }
+
+  // the other doors can be left, but not passed through
+  for (int location = 0; location < map_data.width * map_data.height; location++)
+  {
+    if (map_data.index(location) != 2 || location == exit_location)
+    {
+      continue;
+    }
+    for (int neighbor : get_neighbor_locations(location))
+    {
+      if (distance[neighbor] != -1 && (distance[location] == -1 || distance[neighbor] + 1 < distance[location]))
+      {
+        distance[location] = distance[neighbor] + 1;
+      }
+    }
+  }
+}
+
+auto Instance::get_exit_distance(int exit_location, std::vector<int>& buffer) const -> const std::vector<int>&
+{
+  assertm(map_data.is_in(exit_location), "Trying to index a point that is not in the map.");
+  const int door = location_to_door_array[exit_location];
+  if (door != -1)
+  {
+    // the planners of several threads can use the same door, the other ones wait for the first calculation
+    std::call_once(door_distances->calculated[door],
+                   [this, exit_location, door]() { calculate_exit_distance(exit_location, door_distances->distance[door]); });
+    return door_distances->distance[door];
+  }
+  calculate_exit_distance(exit_location, buffer);
+  return buffer;
 }
 
 void Instance::precompute_neighbors()
@@ -253,10 +324,10 @@ void Instance::precompute_neighbors()
   neighbors.clear();
   neighbors.resize(map_data.width * map_data.height, {});
 
-  // iterate over all locations
+  // iterate over all locations, the doors can be left to the free cells
   for (int i = 0; i < map_data.width * map_data.height; i++)
   {
-    if (map_data.index(i) != 0)
+    if (map_data.index(i) == 1)
     {
       continue;
     }
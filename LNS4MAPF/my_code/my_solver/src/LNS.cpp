@@ -7,21 +7,111 @@
 
 #include "LNS.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <ctime>
+#include <functional>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <queue>
 #include <random>
 #include <set>
+#include <stdexcept>
+#include <thread>
 
 #include "SIPP.h"
 #include "utils.h"
 
 #define MIN_BLOCKED_THRESHOLD 0.01
 #define BLOCKED_REACTION_FACTOR 0.1
+#define MIN_RELATIVE_OPERATOR_TIME 0.1
+#define NEIGHBORHOOD_SIZE_WINDOW 20
+#define MAX_REPAIR_FAILURE_RATE 0.25
+#define MIN_IMPROVEMENT_RATE 0.1
+#define MAX_HUMAN_UPDATE_TIME 65535  // the latest observed step of a human, it bounds the replanned human path
+
+// a helper thread kept for the whole search, it runs one handed over task at a time, so no thread is created per iteration
+class PipelineThread
+{
+public:
+  PipelineThread() : thread([this]() { run(); })
+  {
+  }
+
+  PipelineThread(const PipelineThread&)                    = delete;
+  auto operator=(const PipelineThread&) -> PipelineThread& = delete;
+
+  ~PipelineThread()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    task_ready.notify_one();
+    thread.join();
+  }
+
+  // hands the task over to the helper thread, the previous task has to be finished
+  void start(std::function<void()> task_)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      assertm(!pending, "The previous task is not finished.");
+      task    = std::move(task_);
+      pending = true;
+    }
+    task_ready.notify_one();
+  }
+
+  // waits until the handed over task is finished
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    task_done.wait(lock, [this]() { return !pending; });
+  }
+
+private:
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      task_ready.wait(lock, [this]() { return pending || stopping; });
+      if (!pending)
+      {
+        return;
+      }
+      lock.unlock();
+      task();
+      lock.lock();
+      pending = false;
+      task_done.notify_one();
+    }
+  }
 
+  std::mutex              mutex;
+  std::condition_variable task_ready;
+  std::condition_variable task_done;
+  std::function<void()>   task;
+  bool                    pending  = false;
+  bool                    stopping = false;
+  std::thread             thread;  // started last, after the other members are initialized
+};
+
+// CPU time of the calling thread, it does not advance while the thread waits
+static auto thread_cpu_time() -> double
+{
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
 
 LNS::LNS(const Instance& instance_, std::mt19937& rnd_generator_, SharedData* shared_data_, LNS_settings& settings_)
     : Solver("LNS", instance_, rnd_generator_),
-      destroy_operator(Operator([this](Solution& sol) {
+      destroy_operator(Operator<Solution>([this](Solution& sol) {
         if (settings.destroy_settings.type == DESTROY_TYPE::RANDOMWALK)
         {
           destroy_randomwalk(sol);
@@ -42,6 +132,10 @@ LNS::LNS(const Instance& instance_, std::mt19937& rnd_generator_, SharedData* sh
         {
           destroy_blocked(sol);
         }
+        else if (settings.destroy_settings.type == DESTROY_TYPE::SAFETY)
+        {
+          destroy_safety(sol);
+        }
         else
         {
           destroy_random(sol);
@@ -49,18 +143,24 @@ LNS::LNS(const Instance& instance_, std::mt19937& rnd_generator_, SharedData* sh
       })),
       settings(settings_),
       shared_data(shared_data_),
-      repair_operator(Operator([this](Solution& sol) { repair_default(sol); })),
+      repair_operator(Operator<SolutionOverlay>([this](SolutionOverlay& sol_overlay) { repair_default(sol_overlay); })),
+      overlay(solution),
       constraint_table(instance)
 {
   // SIPP's lifetime can not be longer than LNS's lifetime, because then map_data might be deleted before SIPP
   planner = std::make_unique<SIPP>(instance, rnd_generator, settings.sipp_settings);
+  destroy_size = settings.destroy_settings.size;
 
   // initialize destroy weights for adaptive LNS to 1
   if (settings.destroy_settings.type == DESTROY_TYPE::ADAPTIVE)
   {
-    // the number of destroy operator is 1 less than destoroy types, because ADAPTIVE is not an operator
-    // destroy_weights.assign(magic_enum::enum_count<DESTROY_TYPE>() - 1, 1);
-    destroy_weights.assign(3, 1);  // RANDOM, RANDOMWALK, INTERSECTION
+    // the weights are indexed by DESTROY_TYPE, ADAPTIVE, RANDOM_CHOOSE and BLOCKED are not chosen by the adaptive destroy
+    destroy_weights.assign(magic_enum::enum_count<DESTROY_TYPE>(), 1);
+    destroy_weights[static_cast<int>(DESTROY_TYPE::ADAPTIVE)]      = 0;
+    destroy_weights[static_cast<int>(DESTROY_TYPE::RANDOM_CHOOSE)] = 0;
+    destroy_weights[static_cast<int>(DESTROY_TYPE::BLOCKED)]       = 0;
+    // the safety operator is enabled in solve, if the safety check is used
+    destroy_weights[static_cast<int>(DESTROY_TYPE::SAFETY)] = 0;
   }
 }
 
@@ -82,22 +182,31 @@ void LNS::initialize_constraint_table(const std::vector<TimePointPath>& paths)
 void LNS::solve()
 {
   // 0. Pre-computation: Calculate human path if needed
-  if (human_start_location != -1 && safety_exit_location != -1)
-  {
-      std::cout << "Calculating optimized human path..." << std::endl;
-      // Vyčistíme tabulku překážek, aby člověk "neviděl" roboty (má prioritu)
-      auto human_planner = std::make_unique<SIPP>(instance, rnd_generator, settings.sipp_settings);
-      
-      // Voláme SIPP pro nalezení cesty člověka
-      human_path_locations = human_planner->find_shortest_path(human_start_location, safety_exit_location);
-      
-      if (human_path_locations.empty()) {
-          std::cout << "WARNING: Human cannot reach the exit from start location!" << std::endl;
-      } else {
-          std::cout << "Human path calculated. Length: " << human_path_locations.size() << std::endl;
+  if (!human_start_locations.empty() && !safety_exit_locations.empty())
+  {
+      std::cout << "Calculating optimized human paths..." << std::endl;
+
+      // Voláme SIPP pro nalezení cesty člověka, každý člověk jde k nejbližším dveřím
+      human_paths.assign(human_start_locations.size(), {});
+      for (size_t human = 0; human < human_start_locations.size(); human++)
+      {
+          human_paths[human] = find_human_path(human_start_locations[human]);
+
+          if (human_paths[human].empty()) {
+              std::cout << "WARNING: Human " << human << " cannot reach any exit from start location!" << std::endl;
+          } else {
+              std::cout << "Human " << human << " path calculated. Length: " << human_paths[human].size() << std::endl;
+          }
       }
   }
 
+  // reserve the escape corridor of the human before the first robot is planned
+  if (!found_initial_solution)
+  {
+    build_safety_reservations();
+    add_safety_reservations(planner->safe_interval_table);
+  }
+
   // start measuring time
   Clock clock;
   clock.start();
@@ -111,6 +220,7 @@ void LNS::solve()
     if (!found_initial_solution)
     {
       planner->reset();
+      add_safety_reservations(planner->safe_interval_table);
       already_planned.clear();
     }
 
@@ -134,6 +244,51 @@ void LNS::solve()
     initialize_constraint_table(solution.paths);
   }
 
+  // run the workers in parallel, the safety check and the visualization need the sequential iterations
+  if (settings.threads > 1)
+  {
+    if (!safety_aware_mode && settings.sipp_settings.info_type != INFO_type::visualisation)
+    {
+      solve_parallel(clock);
+      if (portfolio != nullptr)
+      {
+        exchange_with_portfolio();
+        portfolio->finish();
+      }
+      std::cout << "Final solution has sum of costs: " << solution.sum_of_costs << std::endl;
+      return;
+    }
+    std::cout << "WARNING: Parallel LNS does not support the safety check and the visualization, running sequentially." << std::endl;
+  }
+  const double iterations_start_time = clock.get_current_time().first;
+
+  // the safety of the initial solution decides, whether the iterations have to restore it first
+  if (safety_aware_mode && has_humans())
+  {
+    initialize_safety_checker();
+
+    // the adaptive destroy can target the robots blocking the human
+    if (settings.destroy_settings.type == DESTROY_TYPE::ADAPTIVE && destroy_weights[static_cast<int>(DESTROY_TYPE::SAFETY)] == 0)
+    {
+      destroy_weights[static_cast<int>(DESTROY_TYPE::SAFETY)] = 1;
+    }
+  }
+
+  // the pipelined destroy runs concurrently with the repair, so it can not share the generator with the planner
+  if (settings.pipelined_destroy && destroy_generator != &pipeline_generator)
+  {
+    pipeline_generator.seed(rnd_generator());
+    destroy_generator = &pipeline_generator;
+  }
+  exchange_with_portfolio();
+
+  // the next neighborhood is computed by a single helper thread, which is reused by all iterations
+  std::optional<PipelineThread> destroy_thread;
+  if (settings.pipelined_destroy)
+  {
+    destroy_thread.emplace();
+  }
+
   while (iteration_num < settings.max_iter && clock.get_current_time().first < settings.time_limit)
   {
     // check for visualization thread end
@@ -145,26 +300,68 @@ void LNS::solve()
       }
     }
 
+    // stop when another solver of the portfolio finished, otherwise exchange the best solution
+    if (portfolio != nullptr)
+    {
+      if (portfolio->is_finished())
+      {
+        break;
+      }
+      exchange_with_portfolio();
+    }
+
+    // the observed human positions are applied before the next neighborhood is chosen
+    process_human_updates();
+
     iteration_num++;
 
     // time the iteration
     Clock iteration_clock;
     iteration_clock.start();
-    // copy solution (S_bsf -> S_new)
-    Solution perturbed_sol = solution;
+    // destroy operator, it only selects the neighborhood, the new paths are stored in the overlay instead of a copy of the solution
+    // the neighborhood computed during the previous repair is used, if the solution and the size did not change since
+    DESTROY_TYPE strategy = DESTROY_TYPE::RANDOM;
+    if (has_candidate && candidate_cost == solution.sum_of_costs && candidate_size == destroy_size)
+    {
+      solution.destroyed_paths.swap(candidate_neighborhood);
+      strategy = candidate_strategy;
+    }
+    else
+    {
+      destroy_operator.apply(solution);
+      strategy = last_destroy_strategy;
+    }
+    has_candidate = false;
+    overlay.reset(solution.destroyed_paths);
+    solution.feasible = true;
 
-    // destroy operator
-    destroy_operator.apply(perturbed_sol);
+    // compute the next neighborhood on the pre-repair state, the repair changes neither the solution nor the constraint table
+    if (destroy_thread.has_value())
+    {
+      destroy_thread->start([this]() { destroy_operator.apply(solution); });
+    }
 
     // repair operator
-    repair_operator.apply(perturbed_sol);
+    repair_operator.apply(overlay);
+    if (destroy_thread.has_value())
+    {
+      destroy_thread->wait();
+      candidate_neighborhood.swap(solution.destroyed_paths);
+      solution.destroyed_paths.clear();
+      solution.feasible  = true;
+      candidate_strategy = last_destroy_strategy;
+      candidate_size     = destroy_size;
+      has_candidate      = true;
+    }
+    const double repair_time = iteration_clock.get_current_time().first;
+    record_operator_time(strategy, repair_time);
 
     bool safety_violation = false;
     
     // Safety check běží jen pokud je řešení validní (feasible) a máme zapnutý safety mód
-    if (perturbed_sol.feasible && safety_aware_mode) 
+    if (overlay.feasible && safety_aware_mode) 
     {
-        if (!validate_safety(perturbed_sol)) 
+        if (!validate_safety(overlay)) 
         {
             safety_violation = true;
         }
@@ -173,77 +370,76 @@ void LNS::solve()
     int  improvement = 0;
 
     // Podmínka: Řešení musí být validní (feasible) AND bezpečné (!safety_violation)
-    if (!perturbed_sol.feasible || safety_violation)
+    if (!overlay.feasible || safety_violation)
     {
+      // the bounded repair aborts the neighborhoods, which would not improve, they count as not improving
+      if (overlay.bound_exceeded)
+      {
+        update_destroy_weights(strategy, 0);
+      }
       // Discard unsafe or infeasible solution
-      discard_solution(perturbed_sol, solution);
+      discard_solution(overlay);
     }
     else
     {
       // Calculate Cost
-      perturbed_sol.calculate_cost(instance);
-      improvement = solution.sum_of_delays - perturbed_sol.sum_of_delays;
+      improvement = overlay.get_improvement();
 
-      // Find out which destroy strategy was used (for adaptive weights)
-      auto destroy_strategy_index_help = magic_enum::enum_index<DESTROY_TYPE>(last_destroy_strategy);
-      int  destroy_strategy_index      = -1;
-      if (destroy_strategy_index_help.has_value())
-      {
-        destroy_strategy_index = destroy_strategy_index_help.value();
-      }
-      assertm(destroy_strategy_index >= 0 && destroy_strategy_index < static_cast<int>(magic_enum::enum_count<DESTROY_TYPE>()),
-              "Wrong destroy strategy index.");
+      // an unsafe solution is replaced by any candidate with fewer unsafe steps, which counts as an improvement for the weights
+      const bool improves_safety = safety_aware_mode && !solution_unsafe_steps.empty();
+
+      // Update the weights of the used destroy strategy
+      update_destroy_weights(strategy, improves_safety ? std::max(improvement, 1) : improvement);
 
       // Check improvement
-      if (improvement <= 0)
+      if (improvement <= 0 && !improves_safety)
       {
-        // Worse solution -> Update weights (Fail)
-        if (settings.destroy_settings.type == DESTROY_TYPE::ADAPTIVE)
-        {
-          destroy_weights[destroy_strategy_index] = (1 - BLOCKED_REACTION_FACTOR) * destroy_weights[destroy_strategy_index];
-        }
-        if (last_destroy_strategy == DESTROY_TYPE::BLOCKED)
-        {
-          threshold_blocked = std::max((1 - BLOCKED_REACTION_FACTOR) * threshold_blocked, MIN_BLOCKED_THRESHOLD);
-        }
-        
         // Discard worse solution
-        discard_solution(perturbed_sol, solution);
+        discard_solution(overlay);
       }
       else
       {
-        // Better solution -> Update weights (Success)
-        if (settings.destroy_settings.type == DESTROY_TYPE::ADAPTIVE)
-        {
-          destroy_weights[destroy_strategy_index] =
-              reaction_factor * static_cast<double>(improvement) / static_cast<double>(settings.destroy_settings.size) +
-              (1 - reaction_factor) * destroy_weights[destroy_strategy_index];
-        }
-        else if (last_destroy_strategy == DESTROY_TYPE::BLOCKED)
-        {
-          threshold_blocked = std::min((1 + reaction_factor) * threshold_blocked, 1.0);
-        }
-        
         // Accept better solution
         accepted = true;
-        solution = std::move(perturbed_sol);
+        commit_overlay();
       }
     }
     
+    sync_ordering_planners();
+    sync_safety_checker(accepted);
+    if (accepted)
+    {
+      publish_safe_solution();
+    }
+
     // Logging and Visualization
     auto [iteration_time_wall, iteration_time_cpu] = iteration_clock.end();
+    const int used_neighborhood_size               = destroy_size;
+    // the bounded aborts are not failures, the neighborhood shrinks only if its repairs are infeasible
+    update_neighborhood_size(overlay.feasible || overlay.bound_exceeded, accepted, repair_time);
 
-    // construct LNS iteration info and add to the shared data
-    if (settings.sipp_settings.info_type == INFO_type::visualisation)
+    // the candidate neighborhood has to be recomputed if the accepted paths changed any of its agents
+    candidate_cost = solution.sum_of_costs;
+    if (accepted && has_candidate)
     {
-      // get the pointer to the original perturbed solution (which might have been moved)
-      Solution* sol = &solution;
-      if (!accepted)
+      for (int agent : candidate_neighborhood)
       {
-        sol = &perturbed_sol;
+        if (std::find(overlay.destroyed_paths.begin(), overlay.destroyed_paths.end(), agent) != overlay.destroyed_paths.end())
+        {
+          has_candidate = false;
+          break;
+        }
       }
-      LNSIterationInfo lns_info(iteration_num, accepted, improvement, sipp_info, *sol,
-                                (std::string)magic_enum::enum_name<DESTROY_TYPE>(last_destroy_strategy));
+    }
+
+    // construct LNS iteration info and add to the shared data
+    if (settings.sipp_settings.info_type == INFO_type::visualisation)
+    {
+      // the committed overlay holds the replaced paths, so the accepted solution is copied directly
+      Solution sol = accepted ? solution : overlay.to_solution(instance);
+      sol.destroyed_paths = overlay.destroyed_paths;
+      LNSIterationInfo lns_info(iteration_num, accepted, improvement, sipp_info, sol,
+                                (std::string)magic_enum::enum_name<DESTROY_TYPE>(strategy));
       sipp_info.clear();
       shared_data->update_lns_info(lns_info);
     }
@@ -252,786 +448,1965 @@ void LNS::solve()
     {
       log.bsf_solution_cost.push_back(solution.sum_of_costs);
       log.bsf_makespan.push_back(solution.makespan);
-      log.used_operator.push_back(last_destroy_strategy);
+      log.used_operator.push_back(strategy);
+      log.neighborhood_size.push_back(used_neighborhood_size);
       log.iteration_time_wall.push_back(iteration_time_wall);
       log.iteration_time_cpu.push_back(iteration_time_cpu);
     }
   }
-  
+
+  // publish the final solution and stop the rest of the portfolio
+  if (portfolio != nullptr)
+  {
+    exchange_with_portfolio();
+    portfolio->finish();
+  }
+
+  // the throughput is reported only by the experiments
+  if (settings.sipp_settings.info_type == INFO_type::experiment)
+  {
+    const double iterations_time = clock.get_current_time().first - iterations_start_time;
+    std::cout << "LNS performed " << iteration_num << " iterations in " << iterations_time << " s ("
+              << static_cast<double>(iteration_num) / std::max(iterations_time, 1e-9) << " iterations per second)." << std::endl;
+  }
   std::cout << "Final solution has sum of costs: " << solution.sum_of_costs << std::endl;
-  print_safety_report();
 }
 
-auto LNS::find_initial_solution() -> bool
+void LNS::exchange_with_portfolio()
 {
-  Clock clock;
-  clock.start();
-
-  // create initial solution
-  solution                                     = PrioritizedPlanning();
-  auto [init_sol_time_wall, init_sol_time_cpu] = clock.get_current_time();
-  solution.calculate_cost(instance);
-
-  // construct LNS iteration info and add to the shared data
-  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  if (portfolio == nullptr)
   {
-    LNSIterationInfo lns_info(0, solution.feasible, 0, sipp_info, solution, "None");
-    sipp_info.clear();
-    shared_data->update_lns_info(lns_info);
+    return;
   }
-  // log the experiment data
-  else if (settings.sipp_settings.info_type == INFO_type::experiment)
+
+  // publish a better solution, the shared cost is checked first, so that the solution is not copied needlessly
+  // in the safety mode only the solutions verified to be safe are shared
+  const bool safe = is_verified_safe();
+  if (safe && solution.sum_of_costs < portfolio->get_best_cost())
   {
-    log.bsf_solution_cost.push_back(solution.sum_of_costs);
-    log.bsf_makespan.push_back(solution.makespan);
-    log.used_operator.push_back(DESTROY_TYPE::ADAPTIVE);
-    log.iteration_time_wall.push_back(init_sol_time_wall);
-    log.iteration_time_cpu.push_back(init_sol_time_cpu);
+    portfolio->publish(solution);
+    return;
   }
 
-  // std::cout << "Solution has sum of costs: " << solution.sum_of_costs << ", sol has delay: " << solution.sum_of_delays << std::endl;
-  return solution.feasible;
+  // adopt a better solution, an unsafe solution is replaced by any shared one
+  if (!safe || portfolio->get_best_cost() < solution.sum_of_costs)
+  {
+    auto best = portfolio->get_best();
+    if (best != nullptr && (!safe || best->sum_of_costs < solution.sum_of_costs))
+    {
+      adopt_solution(*best);
+
+      // the shared solution is safe, the checker is rebuilt to verify it for this solver as well
+      if (safety_aware_mode && has_humans())
+      {
+        initialize_safety_checker();
+      }
+    }
+  }
 }
 
-auto LNS::PrioritizedPlanning() -> Solution
+void LNS::adopt_solution(const Solution& sol)
 {
-  Solution sol;
-  sol.paths.resize(instance.get_num_of_agents(), TimePointPath());
-  const int agent_num = instance.get_num_of_agents();
-
-  // create a sequence from 0 to agent_num
-  std::vector<int> priorities(agent_num);
-  std::iota(priorities.begin(), priorities.end(), 0);
-
-  // shuffle the sequence to get random priorities
-  std::shuffle(priorities.begin(), priorities.end(), rnd_generator);
+  assertm(sol.feasible && sol.paths.size() == solution.paths.size(), "Can not adopt an infeasible solution.");
 
-  // initialize iter info
-  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  // find the paths, which differ
+  std::vector<int> changed;
+  for (int i = 0; i < static_cast<int>(sol.paths.size()); i++)
   {
-    sipp_info.clear();
-    sipp_info.resize(agent_num);
+    if (!(sol.paths[i] == solution.paths[i]))
+    {
+      changed.push_back(i);
+    }
   }
 
-  // plan path for each agent according to its priority
-  assertm(already_planned.empty(), "Running Prioritized Planning when some agents were already planned.");
-  for (int i = 0; i < agent_num; i++)
+  // replace the changed paths in the tables, the new paths may collide with the old ones, so all old paths are removed first
+  for (int it : changed)
   {
-    // get agent with priority i
-    int agent_id = priorities[i];
-
-    // plan path for agent
-    TimePointPath tp_path = planner->plan(agent_id, already_planned);
-
-    // get the visualization info
-    if (settings.sipp_settings.info_type == INFO_type::visualisation)
+    planner->safe_interval_table.remove_constraints(solution.paths[it]);
+    if (constraint_table_initialized)
     {
-      sipp_info[agent_id] = std::move(planner->iter_info);
-      planner->iter_info.clear();
+      constraint_table.remove_constraints(solution.paths[it], it);
     }
-
-    // check validity
-    if (tp_path.empty())
+  }
+  for (int it : changed)
+  {
+    planner->safe_interval_table.add_constraints(sol.paths[it]);
+    if (constraint_table_initialized)
     {
-      // std::cout << "Unable to find initial solution by prioritized planning. " << std::endl;
-      sol.feasible = false;
-      return sol;
+      constraint_table.add_constraints(sol.paths[it], it);
     }
+  }
 
-    // check validity
-    assertm(instance.check_timepointpath_validity(tp_path), "SIPP planned an invalid timepointpath.");
+  solution = sol;
+  solution.destroyed_paths.clear();
 
-    // update the safe interval table
-    planner->safe_interval_table.add_constraints(tp_path);
+  // the planners of the repair orderings and the safety checker are rebuilt from the adopted paths
+  ordering_planners.clear();
+  ordering_generators.clear();
+  safety_checker.reset();
+  solution_unsafe_steps.clear();
+  candidate_unsafe_steps.clear();
+  escape_routes.clear();
+}
 
-    // add to the solution
-    sol.paths[agent_id] = tp_path;
+void LNS::update_neighborhood_size(bool repaired, bool improved, double time)
+{
+  if (!settings.adaptive_neighborhood)
+  {
+    return;
+  }
 
-    // add to the already planned agents
-    already_planned.insert(agent_id);
+  size_window_iterations++;
+  size_window_failures += repaired ? 0 : 1;
+  size_window_improvements += improved ? 1 : 0;
+  size_window_time += time;
+  if (size_window_iterations < NEIGHBORHOOD_SIZE_WINDOW)
+  {
+    return;
   }
-  // add priorities to the visualization info
-  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+
+  // the destroy operators need at least one agent outside of the neighborhood
+  const int    max_size         = std::min(settings.max_neighborhood_size, instance.get_num_of_agents() - 1);
+  const int    min_size         = std::min(settings.min_neighborhood_size, max_size);
+  const int    step             = std::max(1, destroy_size / 4);
+  const double failure_rate     = static_cast<double>(size_window_failures) / size_window_iterations;
+  const double improvement_rate = static_cast<double>(size_window_improvements) / size_window_iterations;
+  const double average_time     = size_window_time / size_window_iterations;
+  if (failure_rate > MAX_REPAIR_FAILURE_RATE || average_time > settings.max_repair_time)
   {
-    sol.priorities = std::move(priorities);
+    // the repairs fail or are too slow
+    destroy_size = destroy_size - step;
   }
-  return sol;
+  else if (improvement_rate < MIN_IMPROVEMENT_RATE)
+  {
+    // the neighborhoods are too small to improve the solution
+    destroy_size = destroy_size + step;
+  }
+  destroy_size = std::clamp(destroy_size, min_size, max_size);
+
+  size_window_iterations   = 0;
+  size_window_failures     = 0;
+  size_window_improvements = 0;
+  size_window_time         = 0.0;
 }
 
-void LNS::destroy_random(Solution& sol) const
+void LNS::record_operator_time(DESTROY_TYPE strategy, double time)
 {
-  last_destroy_strategy = DESTROY_TYPE::RANDOM;
-  assertm(settings.destroy_settings.size >= 0 && settings.destroy_settings.size <= instance.get_num_of_agents(),
-          "Invalid neighborhood size.");
-  std::vector<int> path_idcs(sol.paths.size());
-  std::iota(path_idcs.begin(), path_idcs.end(), 0);
-  std::shuffle(path_idcs.begin(), path_idcs.end(), rnd_generator);
-  assertm((int)path_idcs.size() > settings.destroy_settings.size, "Not enough paths for the destroy operator.");
-  int num_to_destroy = std::min(settings.destroy_settings.size, instance.get_num_of_agents());
-  sol.destroyed_paths =
-      std::vector(std::make_move_iterator(path_idcs.begin()), std::make_move_iterator(path_idcs.begin() + num_to_destroy));
-  assertm(sol.destroyed_paths.size() > 0, "No paths were destroyed.");
-  sol.feasible = false;
+  auto destroy_strategy_index = magic_enum::enum_index<DESTROY_TYPE>(strategy);
+  assertm(destroy_strategy_index.has_value(), "Wrong destroy strategy index.");
+  OperatorStats& stats = log.operator_stats[destroy_strategy_index.value()];
+  stats.calls++;
+  stats.total_time += time;
 }
 
-void LNS::destroy_randomwalk(Solution& sol) const
+void LNS::update_destroy_weights(DESTROY_TYPE strategy, int improvement)
 {
-  last_destroy_strategy = DESTROY_TYPE::RANDOMWALK;
-
-  assertm(constraint_table_initialized, "Constraint table is not initialized.");
-  assertm(settings.destroy_settings.size >= 0 && settings.destroy_settings.size <= instance.get_num_of_agents(),
-          "Invalid neighborhood size.");
-  // if neighborhood size the same as number of agents or more, return all agents
-  if (settings.destroy_settings.size >= instance.get_num_of_agents())
+  // Find out which destroy strategy was used (for adaptive weights)
+  auto destroy_strategy_index_help = magic_enum::enum_index<DESTROY_TYPE>(strategy);
+  int  destroy_strategy_index      = -1;
+  if (destroy_strategy_index_help.has_value())
   {
-    destroy_random(sol);
-    return;
+    destroy_strategy_index = destroy_strategy_index_help.value();
   }
+  assertm(destroy_strategy_index >= 0 && destroy_strategy_index < static_cast<int>(magic_enum::enum_count<DESTROY_TYPE>()),
+          "Wrong destroy strategy index.");
 
-  // the tabu list
-  static std::unordered_set<int> tabu_list;
+  OperatorStats& stats = log.operator_stats[destroy_strategy_index];
+  if (improvement > 0)
+  {
+    stats.improvements++;
+    stats.total_improvement += improvement;
+  }
 
-  // find the most delayed agent that is not on the tabu list
-  assertm(static_cast<int>(sol.delays.size()) == instance.get_num_of_agents(),
-          "The length of delay list must be the same as the numebr of agents.");
+  // the average time of the operator relative to the average iteration, expensive operators have to improve more to keep their weight
+  int    all_calls     = 0;
+  double all_time      = 0.0;
+  double relative_time = 1.0;
+  for (const auto& it : log.operator_stats)
+  {
+    all_calls += it.calls;
+    all_time += it.total_time;
+  }
+  if (stats.calls > 0 && all_time > 0.0)
+  {
+    relative_time = std::max(stats.get_average_time() / (all_time / all_calls), MIN_RELATIVE_OPERATOR_TIME);
+  }
 
-  int max_delay    = 0;
-  int most_delayed = -1;
-  for (int i = 0; i < instance.get_num_of_agents(); i++)
+  if (improvement <= 0)
   {
-    // skip agents in tabu list
-    if (tabu_list.find(i) != tabu_list.end())
+    // Worse solution -> Update weights (Fail), a slower operator loses more weight
+    if (settings.destroy_settings.type == DESTROY_TYPE::ADAPTIVE)
     {
-      continue;
+      destroy_weights[destroy_strategy_index] = std::pow(1 - BLOCKED_REACTION_FACTOR, relative_time) * destroy_weights[destroy_strategy_index];
     }
-
-    if (sol.delays[i] > max_delay)
+    if (strategy == DESTROY_TYPE::BLOCKED)
     {
-      max_delay    = sol.delays[i];
-      most_delayed = i;
+      threshold_blocked = std::max((1 - BLOCKED_REACTION_FACTOR) * threshold_blocked, MIN_BLOCKED_THRESHOLD);
     }
   }
-
-  // check, whether to reset tabu list
-  if (max_delay == 0)
+  else
   {
-    // reset the tabu list and try again
-    if (!tabu_list.empty())
+    // Better solution -> Update weights (Success), the improvement is rewarded per unit of time
+    if (settings.destroy_settings.type == DESTROY_TYPE::ADAPTIVE)
     {
-      tabu_list.clear();
-      destroy_randomwalk(sol);
-      return;
+      destroy_weights[destroy_strategy_index] =
+          reaction_factor * static_cast<double>(improvement) / static_cast<double>(destroy_size) / relative_time +
+          (1 - reaction_factor) * destroy_weights[destroy_strategy_index];
+    }
+    else if (strategy == DESTROY_TYPE::BLOCKED)
+    {
+      threshold_blocked = std::min((1 + reaction_factor) * threshold_blocked, 1.0);
     }
+  }
+}
 
-    // select random agents
-    std::cout << "Using random destroy" << std::endl;
-    destroy_random(sol);
-    return;
+void LNS::solve_parallel(const Clock& clock)
+{
+  const int        num_workers = settings.threads;
+  ParallelLNSState state(instance.get_num_of_agents(), num_workers);
+
+  // each worker plans with its own generator, the seeds are drawn from the shared one to keep seeded runs reproducible in the seeds
+  std::vector<std::mt19937> worker_generators;
+  worker_generators.reserve(num_workers);
+  for (int i = 0; i < num_workers; i++)
+  {
+    worker_generators.emplace_back(rnd_generator());
   }
 
-  assertm(max_delay > 0, "Max delay is invalid.");
-  assertm(most_delayed >= 0 && most_delayed < instance.get_num_of_agents() && sol.delays[most_delayed] == max_delay,
-          "Invalid id of most delayed agent");
+  Clock parallel_clock;
+  parallel_clock.start();
 
-  // update the tabu list
-  tabu_list.insert(most_delayed);
-  if (static_cast<int>(tabu_list.size()) == instance.get_num_of_agents())
+  std::vector<std::thread> workers;
+  workers.reserve(num_workers);
+  for (int i = 0; i < num_workers; i++)
   {
-    tabu_list.clear();
+    workers.emplace_back(&LNS::run_worker, this, std::ref(state), std::cref(clock), std::ref(worker_generators[i]), i);
+  }
+  for (auto& worker : workers)
+  {
+    worker.join();
   }
 
-  std::set<int> chosen = {
-      most_delayed};  // TODO in the original code they use set, but I think it makes more sense to use either unordered set or vector
+  auto [time_wall, time_cpu] = parallel_clock.end();
+  parallel_stats              = state.stats;
+  if (settings.sipp_settings.info_type == INFO_type::experiment)
+  {
+    std::cout << "Parallel LNS with " << num_workers << " workers performed " << iteration_num << " iterations in " << time_wall << " s ("
+              << static_cast<double>(iteration_num) / std::max(time_wall, 1e-9) << " iterations per second), committed "
+              << parallel_stats.commits << " neighborhoods, rejected " << parallel_stats.conflicts << " conflicting neighborhoods, "
+              << 100.0 * parallel_stats.locked_time / std::max(parallel_stats.busy_time, 1e-9) << " % of the work serialized." << std::endl;
+  }
+  assertm(solution.is_valid(instance), "Parallel LNS produced an invalid solution.");
+}
+
+void LNS::run_worker(ParallelLNSState& state, const Clock& clock, std::mt19937& worker_generator, int worker)
+{
+  // the safe interval table of the worker's planner is its snapshot of the reservations
+  SIPP                    worker_planner(instance, worker_generator, settings.sipp_settings);
+  std::unordered_set<int> worker_planned;
+  {
+    std::vector<TimePointPath> paths;
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      paths                         = solution.paths;
+      state.worker_versions[worker] = state.first_update_version + static_cast<int>(state.updates.size());
+    }
+    worker_planner.safe_interval_table.build_sequential(paths);
+    for (int i = 0; i < instance.get_num_of_agents(); i++)
+    {
+      worker_planned.insert(i);
+    }
+  }
+
+  std::vector<NeighborhoodUpdate> pending_updates;
+  std::vector<int>           neighborhood;
+  std::vector<TimePointPath> old_paths;
+  std::vector<TimePointPath> new_paths;
+  double                     busy_time   = 0.0;
+  double                     locked_time = 0.0;
+  while (true)
+  {
+    Clock iteration_clock;
+    iteration_clock.start();
+    const double iteration_start = thread_cpu_time();
+    DESTROY_TYPE strategy        = DESTROY_TYPE::RANDOM;
+    neighborhood.clear();
+    old_paths.clear();
+    new_paths.clear();
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      const double lock_start = thread_cpu_time();
+      if (iteration_num >= settings.max_iter || clock.get_current_time().first >= settings.time_limit)
+      {
+        state.stats.busy_time += busy_time;
+        state.stats.locked_time += locked_time;
+        break;
+      }
+      iteration_num++;
+
+      // fetch the updates committed since the last iteration and drop the ones replayed by all workers
+      const int replayed = state.worker_versions[worker] - state.first_update_version;
+      pending_updates.assign(state.updates.begin() + replayed, state.updates.end());
+      state.worker_versions[worker] = state.first_update_version + static_cast<int>(state.updates.size());
+      const int min_version = *std::min_element(state.worker_versions.begin(), state.worker_versions.end());
+      while (state.first_update_version < min_version)
+      {
+        state.updates.pop_front();
+        state.first_update_version++;
+      }
+
+      // the destroy operators only select the neighborhood, so they can be applied to the shared solution
+      destroy_operator.apply(solution);
+      strategy = last_destroy_strategy;
+      for (int agent : solution.destroyed_paths)
+      {
+        // skip agents repaired by other workers
+        if (!state.in_flight[agent])
+        {
+          state.in_flight[agent] = true;
+          neighborhood.push_back(agent);
+          old_paths.push_back(solution.paths[agent]);
+        }
+      }
+      solution.destroyed_paths.clear();
+      solution.feasible = true;
+      locked_time += thread_cpu_time() - lock_start;
+    }
+
+    // replay the updates of the other workers, the new paths of a neighborhood may collide with its old paths
+    for (const auto& update : pending_updates)
+    {
+      for (const auto& tp_path : update.old_paths)
+      {
+        worker_planner.safe_interval_table.remove_constraints(tp_path);
+      }
+      for (const auto& tp_path : update.new_paths)
+      {
+        worker_planner.safe_interval_table.add_constraints(tp_path);
+      }
+    }
+
+    // repair the neighborhood in the snapshot
+    for (int i = 0; i < static_cast<int>(neighborhood.size()); i++)
+    {
+      worker_planner.safe_interval_table.remove_constraints(old_paths[i]);
+      worker_planned.erase(neighborhood[i]);
+    }
+    bool feasible    = !neighborhood.empty();
+    int  improvement = 0;
+    for (int i = 0; i < static_cast<int>(neighborhood.size()); i++)
+    {
+      TimePointPath tp_path = worker_planner.plan(neighborhood[i], worker_planned);
+      if (tp_path.empty())
+      {
+        feasible = false;
+        break;
+      }
+      worker_planner.safe_interval_table.add_constraints(tp_path);
+      worker_planned.insert(neighborhood[i]);
+      improvement += old_paths[i].back().interval.t_min - tp_path.back().interval.t_min;
+      new_paths.push_back(std::move(tp_path));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      const double lock_start             = thread_cpu_time();
+      const double repair_time            = iteration_clock.get_current_time().first;
+      const int    used_neighborhood_size = destroy_size;
+      record_operator_time(strategy, repair_time);
+      bool accepted = false;
+      if (feasible)
+      {
+        accepted = improvement > 0 && commit_neighborhood(state, neighborhood, old_paths, new_paths);
+        update_destroy_weights(strategy, accepted ? improvement : 0);
+      }
+      update_neighborhood_size(feasible, accepted, repair_time);
+      for (int agent : neighborhood)
+      {
+        state.in_flight[agent] = false;
+      }
+
+      // log the iteration
+      if (settings.sipp_settings.info_type == INFO_type::experiment)
+      {
+        auto [iteration_time_wall, iteration_time_cpu] = iteration_clock.end();
+        log.bsf_solution_cost.push_back(solution.sum_of_costs);
+        log.bsf_makespan.push_back(solution.makespan);
+        log.used_operator.push_back(strategy);
+        log.neighborhood_size.push_back(used_neighborhood_size);
+        log.iteration_time_wall.push_back(iteration_time_wall);
+        log.iteration_time_cpu.push_back(iteration_time_cpu);
+      }
+      locked_time += thread_cpu_time() - lock_start;
+    }
+
+    // restore the snapshot, a committed repair is replayed with the other updates
+    for (const auto& tp_path : new_paths)
+    {
+      worker_planner.safe_interval_table.remove_constraints(tp_path);
+    }
+    for (int i = 0; i < static_cast<int>(neighborhood.size()); i++)
+    {
+      worker_planner.safe_interval_table.add_constraints(old_paths[i]);
+      worker_planned.insert(neighborhood[i]);
+    }
+    busy_time += thread_cpu_time() - iteration_start;
+  }
+}
+
+auto LNS::commit_neighborhood(ParallelLNSState& state, const std::vector<int>& neighborhood, const std::vector<TimePointPath>& old_paths,
+                              const std::vector<TimePointPath>& new_paths) -> bool
+{
+  assertm(neighborhood.size() == old_paths.size() && neighborhood.size() == new_paths.size(), "Incomplete neighborhood.");
+  SafeIntervalTable& master_table = planner->safe_interval_table;
+  for (const auto& tp_path : old_paths)
+  {
+    master_table.remove_constraints(tp_path);
+  }
+
+  // validate the new paths against the paths committed by the other workers
+  int added = 0;
+  for (; added < static_cast<int>(new_paths.size()); added++)
+  {
+    if (!master_table.is_path_free(new_paths[added]))
+    {
+      break;
+    }
+    master_table.add_constraints(new_paths[added]);
+  }
+
+  // restore the old paths on a conflict
+  if (added < static_cast<int>(new_paths.size()))
+  {
+    for (int i = 0; i < added; i++)
+    {
+      master_table.remove_constraints(new_paths[i]);
+    }
+    for (const auto& tp_path : old_paths)
+    {
+      master_table.add_constraints(tp_path);
+    }
+    state.stats.conflicts++;
+    return false;
+  }
+
+  // replace the paths in the solution
+  if (constraint_table_initialized)
+  {
+    for (int i = 0; i < static_cast<int>(neighborhood.size()); i++)
+    {
+      constraint_table.remove_constraints(old_paths[i], neighborhood[i]);
+    }
+    for (int i = 0; i < static_cast<int>(neighborhood.size()); i++)
+    {
+      constraint_table.add_constraints(new_paths[i], neighborhood[i]);
+    }
+  }
+  for (int i = 0; i < static_cast<int>(neighborhood.size()); i++)
+  {
+    TimePointPath new_path = new_paths[i];
+    solution.replace_path(neighborhood[i], new_path, instance);
+  }
+  state.updates.push_back({neighborhood, old_paths, new_paths});
+  state.stats.commits++;
+  return true;
+}
+
+auto LNS::find_initial_solution() -> bool
+{
+  Clock clock;
+  clock.start();
+
+  // create initial solution, the racing orderings do not provide the visualization info
+  if (settings.initial_planners > 1 && settings.sipp_settings.info_type != INFO_type::visualisation)
+  {
+    solution = race_prioritized_planning();
+  }
+  else
+  {
+    solution = PrioritizedPlanning();
+  }
+  auto [init_sol_time_wall, init_sol_time_cpu] = clock.get_current_time();
+  solution.calculate_cost(instance);
+
+  // construct LNS iteration info and add to the shared data
+  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  {
+    LNSIterationInfo lns_info(0, solution.feasible, 0, sipp_info, solution, "None");
+    sipp_info.clear();
+    shared_data->update_lns_info(lns_info);
+  }
+  // log the experiment data
+  else if (settings.sipp_settings.info_type == INFO_type::experiment)
+  {
+    log.bsf_solution_cost.push_back(solution.sum_of_costs);
+    log.bsf_makespan.push_back(solution.makespan);
+    log.used_operator.push_back(DESTROY_TYPE::ADAPTIVE);
+    log.neighborhood_size.push_back(destroy_size);
+    log.iteration_time_wall.push_back(init_sol_time_wall);
+    log.iteration_time_cpu.push_back(init_sol_time_cpu);
+  }
+
+  // std::cout << "Solution has sum of costs: " << solution.sum_of_costs << ", sol has delay: " << solution.sum_of_delays << std::endl;
+  return solution.feasible;
+}
+
+auto LNS::PrioritizedPlanning() -> Solution
+{
+  return prioritized_planning(*planner, rnd_generator, already_planned, nullptr);
+}
+
+auto LNS::prioritized_planning(SIPP& pp_planner, std::mt19937& generator, std::unordered_set<int>& planned,
+                               const std::atomic<bool>* cancel) const -> Solution
+{
+  Solution sol;
+  sol.paths.resize(instance.get_num_of_agents(), TimePointPath());
+  const int agent_num = instance.get_num_of_agents();
+
+  // create a sequence from 0 to agent_num
+  std::vector<int> priorities(agent_num);
+  std::iota(priorities.begin(), priorities.end(), 0);
+
+  // shuffle the sequence to get random priorities
+  std::shuffle(priorities.begin(), priorities.end(), generator);
+
+  // initialize iter info
+  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  {
+    sipp_info.clear();
+    sipp_info.resize(agent_num);
+  }
+
+  // plan path for each agent according to its priority
+  assertm(planned.empty(), "Running Prioritized Planning when some agents were already planned.");
+  for (int i = 0; i < agent_num; i++)
+  {
+    // stop, when another ordering already succeeded
+    if (cancel != nullptr && cancel->load(std::memory_order_relaxed))
+    {
+      sol.feasible = false;
+      return sol;
+    }
+
+    // get agent with priority i
+    int agent_id = priorities[i];
+
+    // plan path for agent
+    TimePointPath tp_path = pp_planner.plan(agent_id, planned);
+
+    // get the visualization info
+    if (settings.sipp_settings.info_type == INFO_type::visualisation)
+    {
+      sipp_info[agent_id] = std::move(pp_planner.iter_info);
+      pp_planner.iter_info.clear();
+    }
+
+    // check validity
+    if (tp_path.empty())
+    {
+      // std::cout << "Unable to find initial solution by prioritized planning. " << std::endl;
+      sol.feasible = false;
+      return sol;
+    }
+
+    // check validity
+    assertm(instance.check_timepointpath_validity(tp_path), "SIPP planned an invalid timepointpath.");
+
+    // update the safe interval table
+    pp_planner.safe_interval_table.add_constraints(tp_path);
+
+    // add to the solution
+    sol.paths[agent_id] = tp_path;
+
+    // add to the already planned agents
+    planned.insert(agent_id);
+  }
+  // add priorities to the visualization info
+  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  {
+    sol.priorities = std::move(priorities);
+  }
+  return sol;
+}
+
+auto LNS::race_prioritized_planning() -> Solution
+{
+  const int         num_racers = settings.initial_planners;
+  std::atomic<bool> cancel{false};
+  std::atomic<int>  winner{-1};
+  std::vector<Solution> solutions(num_racers);
+
+  // the first ordering is planned by the planner of the LNS, the others by their own planners with their own generators
+  std::vector<std::mt19937>          generators;
+  std::vector<std::unique_ptr<SIPP>> racer_planners;
+  generators.reserve(num_racers - 1);
+  racer_planners.reserve(num_racers - 1);
+  for (int i = 1; i < num_racers; i++)
+  {
+    generators.emplace_back(rnd_generator());
+    racer_planners.push_back(std::make_unique<SIPP>(instance, generators.back(), settings.sipp_settings));
+    add_safety_reservations(racer_planners.back()->safe_interval_table);
+  }
+
+  // the first feasible ordering wins and cancels the rest
+  auto finish = [&](int racer)
+  {
+    int expected = -1;
+    if (solutions[racer].feasible && winner.compare_exchange_strong(expected, racer))
+    {
+      cancel.store(true, std::memory_order_relaxed);
+    }
+  };
+
+  std::vector<std::thread> racers;
+  racers.reserve(num_racers - 1);
+  for (int i = 1; i < num_racers; i++)
+  {
+    racers.emplace_back(
+        [&, i]()
+        {
+          std::unordered_set<int> planned;
+          solutions[i] = prioritized_planning(*racer_planners[i - 1], generators[i - 1], planned, &cancel);
+          finish(i);
+        });
+  }
+  solutions[0] = prioritized_planning(*planner, rnd_generator, already_planned, &cancel);
+  finish(0);
+  for (auto& racer : racers)
+  {
+    racer.join();
+  }
+
+  const int won = winner.load();
+  if (won <= 0)
+  {
+    return std::move(solutions[0]);
+  }
+
+  // load the winning paths to the planner of the LNS
+  planner->reset();
+  add_safety_reservations(planner->safe_interval_table);
+  already_planned.clear();
+  for (int i = 0; i < instance.get_num_of_agents(); i++)
+  {
+    planner->safe_interval_table.add_constraints(solutions[won].paths[i]);
+    already_planned.insert(i);
+  }
+  return std::move(solutions[won]);
+}
+
+void LNS::destroy_random(Solution& sol) const
+{
+  last_destroy_strategy = DESTROY_TYPE::RANDOM;
+  assertm(destroy_size >= 0 && destroy_size <= instance.get_num_of_agents(),
+          "Invalid neighborhood size.");
+  std::vector<int> path_idcs(sol.paths.size());
+  std::iota(path_idcs.begin(), path_idcs.end(), 0);
+  std::shuffle(path_idcs.begin(), path_idcs.end(), *destroy_generator);
+  assertm((int)path_idcs.size() > destroy_size, "Not enough paths for the destroy operator.");
+  int num_to_destroy = std::min(destroy_size, instance.get_num_of_agents());
+  sol.destroyed_paths =
+      std::vector(std::make_move_iterator(path_idcs.begin()), std::make_move_iterator(path_idcs.begin() + num_to_destroy));
+  assertm(sol.destroyed_paths.size() > 0, "No paths were destroyed.");
+  sol.feasible = false;
+}
+
+void LNS::destroy_randomwalk(Solution& sol) const
+{
+  last_destroy_strategy = DESTROY_TYPE::RANDOMWALK;
+
+  assertm(constraint_table_initialized, "Constraint table is not initialized.");
+  assertm(destroy_size >= 0 && destroy_size <= instance.get_num_of_agents(),
+          "Invalid neighborhood size.");
+  // if neighborhood size the same as number of agents or more, return all agents
+  if (destroy_size >= instance.get_num_of_agents())
+  {
+    destroy_random(sol);
+    return;
+  }
+
+  // find the most delayed agent that is not on the tabu list
+  assertm(static_cast<int>(sol.delays.size()) == instance.get_num_of_agents(),
+          "The length of delay list must be the same as the numebr of agents.");
+
+  int max_delay    = 0;
+  int most_delayed = -1;
+  for (int i = 0; i < instance.get_num_of_agents(); i++)
+  {
+    // skip agents in tabu list
+    if (tabu_list.find(i) != tabu_list.end())
+    {
+      continue;
+    }
+
+    if (sol.delays[i] > max_delay)
+    {
+      max_delay    = sol.delays[i];
+      most_delayed = i;
+    }
+  }
+
+  // check, whether to reset tabu list
+  if (max_delay == 0)
+  {
+    // reset the tabu list and try again
+    if (!tabu_list.empty())
+    {
+      tabu_list.clear();
+      destroy_randomwalk(sol);
+      return;
+    }
+
+    // select random agents
+    std::cout << "Using random destroy" << std::endl;
+    destroy_random(sol);
+    return;
+  }
+
+  assertm(max_delay > 0, "Max delay is invalid.");
+  assertm(most_delayed >= 0 && most_delayed < instance.get_num_of_agents() && sol.delays[most_delayed] == max_delay,
+          "Invalid id of most delayed agent");
+
+  // update the tabu list
+  tabu_list.insert(most_delayed);
+  if (static_cast<int>(tabu_list.size()) == instance.get_num_of_agents())
+  {
+    tabu_list.clear();
+  }
+
+  std::set<int> chosen = {
+      most_delayed};  // TODO in the original code they use set, but I think it makes more sense to use either unordered set or vector
   int upperbound = sol.paths[most_delayed].back().interval.t_min;
   assertm(upperbound > 0, "Upperbound is too small.");
   // perform the first randomwalk from start - not in pseudocode, but in MAPF-LNS2 implementation
   int chosen_agent = most_delayed;
-  if (!random_walk(chosen_agent, settings.destroy_settings.size, sol.paths[chosen_agent][0].location, 0, upperbound, chosen))
+  if (!random_walk(chosen_agent, destroy_size, sol.paths[chosen_agent][0].location, 0, upperbound, chosen))
+  {
+    // perform the random walk again, maximum 10 iterations
+    for (int i = 0; i < 10; i++)
+    {
+      // choose a random time from the agents path
+      std::uniform_int_distribution<int> dist_time(0, upperbound);
+      int                                chosen_t = dist_time(*destroy_generator);
+
+      // choose location
+      int rw_start_location = location_at_time(sol.paths[chosen_agent], chosen_t);
+      assertm(rw_start_location >= 0, "Invalid start location of randomwalk");
+
+      // perform randomwalk
+      if (random_walk(chosen_agent, destroy_size, rw_start_location, chosen_t, upperbound, chosen))
+      {
+        break;
+      }
+      assertm(static_cast<int>(chosen.size()) < destroy_size, "Enough agents were selected, but false returned.");
+
+      // choose a random agent
+      std::uniform_int_distribution<int> dist(0, chosen.size() - 1);
+      int                                idx = dist(*destroy_generator);
+      assertm(idx >= 0 && idx < static_cast<int>(chosen.size()), "Index out of bounds.");
+      // iterator to the first element
+      auto it = chosen.begin();
+      std::advance(it, idx);
+      chosen_agent = *it;
+      upperbound   = sol.paths[chosen_agent].back().interval.t_min;
+    }
+  }
+
+  // if not enough agents selected, repeat
+  if (static_cast<int>(chosen.size()) <= 1)
+  {
+    destroy_randomwalk(sol);
+    return;
+  }
+  assertm(static_cast<int>(chosen.size()) > 1, "Not enough agents selected.");
+
+  // but it is implemented like this in MAPF-LNS2
+  // sol.destroyed_paths = std::vector(std::make_move_iterator(chosen.begin()), std::make_move_iterator(chosen.end()));
+  sol.destroyed_paths.assign(chosen.begin(), chosen.end());
+
+  std::shuffle(sol.destroyed_paths.begin(), sol.destroyed_paths.end(), *destroy_generator);
+  assertm(sol.destroyed_paths.size() > 1, "Not enough paths were destroyed.");
+  sol.feasible = false;
+}
+
+
+auto LNS::random_walk(int agent_num, int neighborhood_size, int start_location, int start_time, int upperbound, std::set<int>& chosen) const
+    -> bool
+{
+  assertm(static_cast<int>(chosen.size()) < neighborhood_size, "Randomwalk not needed.");
+  int curr = start_location;
+  for (int t = start_time; t < upperbound; t++)
+  {
+    std::vector<int> next_locations = instance.get_neighbor_locations(curr);
+    next_locations.push_back(curr);  // agent can also stay
+    std::shuffle(next_locations.begin(), next_locations.end(), *destroy_generator);
+    // try all possible neighbors in random order
+    bool moved = false;
+    for (auto loc : next_locations)
+    {
+      int next_h_val = instance.get_heuristic_distance(agent_num, loc);
+      // if lowerbound on the time to reach goal smaller than limit, accept the move
+      if (t + 1 + next_h_val < upperbound)
+      {
+        // get the agent that is in conflict and add it to the neighborhood
+        auto [conflicting_agent_vertex, conflicting_agent_edge] = constraint_table.get_blocking_agent(curr, loc, t + 1);
+
+        // if there is an agent in collision, add it to the neighborhood
+        if (conflicting_agent_vertex != -1)
+        {
+          chosen.insert(conflicting_agent_vertex);
+        }
+
+        if (conflicting_agent_edge != -1)
+        {
+          chosen.insert(conflicting_agent_edge);
+        }
+
+        curr  = loc;
+        moved = true;
+        break;
+      }
+    }
+    // test whether enough agents selected
+    if (static_cast<int>(chosen.size()) >= neighborhood_size)
+    {
+      return true;
+    }
+
+    // if none of the next locations was valid, return
+    if (!moved)
+    {
+      break;
+    }
+  }
+  assertm(static_cast<int>(chosen.size()) <= neighborhood_size, "Enough agents selected, but false returned.");
+  return false;
+}
+
+void LNS::destroy_intersection(Solution& sol) const
+{
+  last_destroy_strategy = DESTROY_TYPE::INTERSECTION;
+  assertm(constraint_table_initialized, "Constraint table is not initialized.");
+
+  // find all intersection vertices
+  std::vector<int> intersection_vertices_free;
+  intersection_vertices_free.reserve(instance.get_num_free_cells());  // upperbound on number of intersection vertices
+
+  for (int i = 0; i < instance.get_num_free_cells(); i++)
+  {
+    const auto& agents_counts = constraint_table.get_agents_counts_free(i);
+    if (static_cast<int>(agents_counts.size()) >= 3)
+    {
+      intersection_vertices_free.push_back(i);
+    }
+  }
+
+  // create queue
+  std::queue<int> openlist;
+
+  // pick a random intersection vertex
+  {
+    std::uniform_int_distribution<int> dist(0, intersection_vertices_free.size() - 1);
+    int                                idx    = dist(*destroy_generator);
+    int                                chosen = instance.free_location_to_location(intersection_vertices_free[idx]);
+    openlist.push(chosen);
+  }
+
+
+  std::unordered_set<int> neighborhood;  // TODO try set
+  std::vector<bool>       known(instance.get_num_cells(), false);
+
+  while (!openlist.empty())
+  {
+    // retrieve current node
+    int current = openlist.front();
+    openlist.pop();
+    // std::cout << "Current: " << current << std::endl;
+    if (known[current])
+    {
+      continue;
+    }
+    known[current] = true;
+
+    // check whether intersection vertex
+    const auto& agents_counts = constraint_table.get_agents_counts(current);
+    if (static_cast<int>(agents_counts.size()) >= 3)
+    {
+      // add agents that visit this vertex to the neighborhood
+      get_intersection_agents(neighborhood, current);
+    }
+
+    // check whether enough agents selected
+    // std::cout << "Selected: " << static_cast<int>(neighborhood.size()) << std::endl;
+    if (destroy_size == static_cast<int>(neighborhood.size()))
+    {
+      break;
+    }
+
+    // add neighbors to the queue
+    auto neighbors = instance.get_neighbor_locations(current);
+    for (auto it : neighbors)
+    {
+      openlist.push(it);
+    }
+  }
+  //assertm(static_cast<int>(neighborhood.size()) > 1, "Not enough agents selected for destroy.");
+  if (static_cast<int>(neighborhood.size()) <= 1)
+  {
+      // std::cout << "Intersection destroy failed (not enough agents), switching to Random." << std::endl;
+      destroy_random(sol);
+      return;
+  }
+
+  // convert to vector and shuffle
+  sol.destroyed_paths = std::vector(std::make_move_iterator(neighborhood.begin()), std::make_move_iterator(neighborhood.end()));
+  // shuffle the paths
+  std::shuffle(sol.destroyed_paths.begin(), sol.destroyed_paths.end(), *destroy_generator);
+  assertm(sol.destroyed_paths.size() > 0, "No paths were destroyed.");
+  sol.feasible = false;
+}
+
+void LNS::get_intersection_agents(std::unordered_set<int>& neighborhood, int current) const
+{
+  // find maximal T
+  int t_max = constraint_table.get_last_constraint_start(current);
+
+  // choose random time
+  std::uniform_int_distribution<int> dist(0, t_max);
+  int                                t     = dist(*destroy_generator);
+  int                                delta = 0;
+  while (static_cast<int>(neighborhood.size()) < destroy_size && t + delta <= t_max && t - delta >= 0)
+  {
+    // find the agent, that blocks the cell at time t + delta
+    auto [blocking_agent_1, blocking_agent_2] = constraint_table.get_blocking_agent(current, current, t + delta);
+    // find the agent, that blocks the cell at time t - delta
+    auto [blocking_agent_3, blocking_agent_4] = constraint_table.get_blocking_agent(current, current, t - delta);
+
+    // add the agents to the neighborhood
+    std::array<int, 4> blocking_agents = {blocking_agent_1, blocking_agent_2, blocking_agent_3, blocking_agent_4};
+    for (auto blocking_agent : blocking_agents)
+    {
+      if (blocking_agent >= 0 && static_cast<int>(neighborhood.size()) < destroy_size)
+      {
+        neighborhood.insert(blocking_agent);
+      }
+    }
+    delta++;
+  }
+}
+
+void LNS::destroy_adaptive(Solution& sol) const
+{
+  // choose strategy by roulette wheel selection
+  // calculate the sum of weights
+  auto sum_of_weights = std::reduce(destroy_weights.begin(), destroy_weights.end());
+  assertm(sum_of_weights > 0, "Invalid weights.");
+
+
+  // choose a random number in the range [0, sum_of_weights]
+  std::uniform_real_distribution<double> dist(0.0, sum_of_weights);
+  double                                 rand_value = dist(*destroy_generator);
+
+  // spin the roulette
+  double       cummulative_sum = 0.0;
+  DESTROY_TYPE chosen_type     = DESTROY_TYPE::ADAPTIVE;
+  for (int i = 0; i < static_cast<int>(destroy_weights.size()); i++)
+  {
+    cummulative_sum += destroy_weights[i];
+    if (rand_value <= cummulative_sum)
+    {
+      auto chosen = magic_enum::enum_cast<DESTROY_TYPE>(i);
+      if (chosen.has_value())
+      {
+        chosen_type = chosen.value();
+        break;
+      }
+      throw std::runtime_error(std::string("Unknown DESTROY_TYPE ") + std::string(magic_enum::enum_name<DESTROY_TYPE>(chosen_type)) +
+                               std::string(" encountered in adaptive destroy."));
+    }
+  }
+  assertm(chosen_type != DESTROY_TYPE::ADAPTIVE && chosen_type != DESTROY_TYPE::RANDOM_CHOOSE, "Did not select any destroy strategy.");
+
+  // if sum of weights too small, increase it
+  if (sum_of_weights < 0.1)
+  {
+    for (double& destroy_weight : destroy_weights)
+    {
+      destroy_weight *= 10;
+    }
+  }
+  // std::cout << "Weights are: " << std::endl;
+  // for (auto it : destroy_weights)
+  // {
+  //   std::cout << it << ", ";
+  // }
+  // std::cout << std::endl;
+  // std::cout << "Chosen destroy: " << magic_enum::enum_name<DESTROY_TYPE>(chosen_type) << std::endl;
+
+  // apply the destroy operator
+  switch (chosen_type)
+  {
+    case DESTROY_TYPE::RANDOM:
+      destroy_random(sol);
+      break;
+    case DESTROY_TYPE::RANDOMWALK:
+      destroy_randomwalk(sol);
+      break;
+    case DESTROY_TYPE::INTERSECTION:
+      destroy_intersection(sol);
+      break;
+    case DESTROY_TYPE::SAFETY:
+      destroy_safety(sol);
+      break;
+    default:
+      throw std::runtime_error(std::string("Unknown DESTROY_TYPE ") + std::string(magic_enum::enum_name<DESTROY_TYPE>(chosen_type)) +
+                               std::string(" encountered in adaptive destroy."));
+  }
+}
+
+void LNS::destroy_blocked(Solution& sol) const
+{
+  last_destroy_strategy = DESTROY_TYPE::BLOCKED;
+
+  // if a random value is higher, than the threshold, perform randomwalk instead
+  std::uniform_real_distribution<float> blocked_dist(0, 1);
+  if (blocked_dist(*destroy_generator) >= threshold_blocked)
+  {
+    // std::cout << "Running randomwalk. Threshold: " << threshold_blocked << std::endl;
+    destroy_randomwalk(sol);
+    return;
+  }
+
+  // find all agents whose end is blocked
+  std::vector<int> blocked_agents;
+  for (int i = 0; i < instance.get_num_of_agents(); i++)
+  {
+    const int loc        = instance.get_goal_locations()[i];
+    const int reach_time = sol.paths[i].back().interval.t_min;
+    assertm(sol.paths[i].back().location == loc, "The path does not end in the goal location");
+    // skip agents that dont have any delay
+    if (reach_time == instance.get_heuristic_distance(i, instance.get_start_locations()[i]) - 1)
+    {
+      continue;
+    }
+    assertm(reach_time >= instance.get_heuristic_distance(i, instance.get_start_locations()[i]), "Invalid reach time");
+    assertm(constraint_table_initialized, "Constraint table is not initialized.");
+    int from = loc;
+    if (static_cast<int>(sol.paths[i].size()) > 1)
+    {
+      from = std::prev(sol.paths[i].end(), 2)->location;
+    }
+    auto [blocking_agent_1, blocking_agent_2] = constraint_table.get_blocking_agent(from, loc, reach_time - 1);
+    if (blocking_agent_1 != -1 || blocking_agent_2 != -1)
+    {
+      blocked_agents.push_back(i);
+    }
+  }
+
+  // if no agent is blocked, use the randomwalk
+  if (blocked_agents.empty())
+  {
+    destroy_randomwalk(sol);
+    return;
+  }
+  // std::cout << "Number of blocked_agents: " << blocked_agents.size() << std::endl;
+
+  // choose a random agent from blocked agents
+  std::uniform_int_distribution<int> dist(0, blocked_agents.size() - 1);
+  int                                chosen_agent = -1;
+  {
+    int idx      = dist(*destroy_generator);
+    chosen_agent = blocked_agents[idx];
+  }
+  // std::cout << "Chosen agent: " << chosen_agent << std::endl;
+
+  // add the agent to the neighborhood
+  std::unordered_set<int> neighborhood = {chosen_agent};
+  int                     idx          = -1;
+  sol.destroyed_paths                  = {chosen_agent};
+  while (static_cast<int>(sol.destroyed_paths.size()) < destroy_size)
+  {
+    const int        loc                 = instance.get_goal_locations()[chosen_agent];
+    const int        min_reach_time      = instance.get_heuristic_distance(chosen_agent, instance.get_start_locations()[chosen_agent]);
+    std::vector<int> blocking_agents_new = constraint_table.get_blocking_agents(loc, min_reach_time - 1);
+
+    // add all new blocking agents to the neighborhood
+    for (auto it : blocking_agents_new)
+    {
+      if (neighborhood.find(it) == neighborhood.end())
+      {
+        neighborhood.insert(it);
+        sol.destroyed_paths.push_back(it);
+        // make sure that the neighborhood size is not exceeded
+        // if (static_cast<int>(sol.destroyed_paths.size()) >= destroy_size)
+        // {
+        //   break;
+        // }
+      }
+    }
+
+    // update index
+    idx++;
+    if (idx >= static_cast<int>(sol.destroyed_paths.size()))
+    {
+      break;
+    }
+
+    // update chosen agent
+    chosen_agent = sol.destroyed_paths[idx];
+  }
+  // shuffle randomly,  only when threshold is low (we need more variance)
+  if (blocked_dist(*destroy_generator) >= threshold_blocked)
+  {
+    // std::cout << "Shuffle. Threshold: " << threshold_blocked << std::endl;
+    std::shuffle(sol.destroyed_paths.begin(), sol.destroyed_paths.end(), *destroy_generator);
+  }
+  // dont exceed the neighborhood size
+  if (destroy_size < static_cast<int>(sol.destroyed_paths.size()))
+  {
+    sol.destroyed_paths.resize(destroy_size);
+  }
+  assertm(destroy_size == 1 || static_cast<int>(sol.destroyed_paths.size()) > 1,
+          "At least two paths should be destroyed.");
+  sol.feasible = false;
+}
+
+void LNS::destroy_random_choose(Solution& sol) const
+{
+  std::uniform_int_distribution<int> dist(0, 2);
+  int                                rand_value = dist(*destroy_generator);
+  // apply the destroy operator
+  switch (rand_value)
   {
-    // perform the random walk again, maximum 10 iterations
-    for (int i = 0; i < 10; i++)
-    {
-      // choose a random time from the agents path
-      std::uniform_int_distribution<int> dist_time(0, upperbound);
-      int                                chosen_t = dist_time(rnd_generator);
+    case 0:
+      destroy_random(sol);
+      break;
+    case 1:
+      destroy_randomwalk(sol);
+      break;
+    case 2:
+      destroy_intersection(sol);
+      break;
+    default:
+      throw std::runtime_error("Unknown DESTROY_TYPE encountered in adaptive destroy.");
+  }
+}
 
-      // choose location
-      int rw_start_location = location_at_time(sol.paths[chosen_agent], chosen_t);
-      assertm(rw_start_location >= 0, "Invalid start location of randomwalk");
+void LNS::repair_default(SolutionOverlay& sol_overlay) const
+{
+  assertm(!sol_overlay.feasible, "Can not repair a feasible solution");
+  assertm((int)sol_overlay.destroyed_paths.size() > 0, "There are no destroyed paths in the solution to be repaired.");
+  const Solution& sol = sol_overlay.get_base();
 
-      // perform randomwalk
-      if (random_walk(chosen_agent, settings.destroy_settings.size, rw_start_location, chosen_t, upperbound, chosen))
-      {
-        break;
-      }
-      assertm(static_cast<int>(chosen.size()) < settings.destroy_settings.size, "Enough agents were selected, but false returned.");
+  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  {
+    sipp_info.clear();
+    sipp_info.resize(sol_overlay.destroyed_paths.size());
+  }
 
-      // choose a random agent
-      std::uniform_int_distribution<int> dist(0, chosen.size() - 1);
-      int                                idx = dist(rnd_generator);
-      assertm(idx >= 0 && idx < static_cast<int>(chosen.size()), "Index out of bounds.");
-      // iterator to the first element
-      auto it = chosen.begin();
-      std::advance(it, idx);
-      chosen_agent = *it;
-      upperbound   = sol.paths[chosen_agent].back().interval.t_min;
-    }
+  // remove the destroyed paths, the constraint table is updated only when the new paths are committed
+  for (auto& it : sol_overlay.destroyed_paths)
+  {
+    planner->safe_interval_table.remove_constraints(sol.paths[it]);
+    already_planned.erase(it);
   }
 
-  // if not enough agents selected, repeat
-  if (static_cast<int>(chosen.size()) <= 1)
+  // the robots of an unsafe solution are replanned around the escape routes of the human, using a single ordering, the planners of the
+  // other orderings are rebuilt once the solution is safe
+  if (!escape_routes.empty())
   {
-    destroy_randomwalk(sol);
+    ordering_planners.clear();
+    ordering_generators.clear();
+    std::vector<TimePoint> escape_reservations;
+    add_escape_reservations(planner->safe_interval_table, escape_reservations);
+    sol_overlay.feasible =
+        repair_ordering(*planner, already_planned, sol_overlay.destroyed_paths, sol_overlay.new_paths, sol_overlay.bound_exceeded);
+    for (const auto& reservation : escape_reservations)
+    {
+      planner->safe_interval_table.remove_constraint(reservation);
+    }
     return;
   }
-  assertm(static_cast<int>(chosen.size()) > 1, "Not enough agents selected.");
 
-  // but it is implemented like this in MAPF-LNS2
-  // sol.destroyed_paths = std::vector(std::make_move_iterator(chosen.begin()), std::make_move_iterator(chosen.end()));
-  sol.destroyed_paths.assign(chosen.begin(), chosen.end());
+  // evaluate several orderings of the neighborhood in parallel, the visualization shows only one ordering
+  if (settings.repair_orderings > 1 && settings.sipp_settings.info_type != INFO_type::visualisation)
+  {
+    repair_orderings(sol_overlay);
+    return;
+  }
 
-  std::shuffle(sol.destroyed_paths.begin(), sol.destroyed_paths.end(), rnd_generator);
-  assertm(sol.destroyed_paths.size() > 1, "Not enough paths were destroyed.");
-  sol.feasible = false;
+  sol_overlay.feasible =
+      repair_ordering(*planner, already_planned, sol_overlay.destroyed_paths, sol_overlay.new_paths, sol_overlay.bound_exceeded);
 }
 
-
-auto LNS::random_walk(int agent_num, int neighborhood_size, int start_location, int start_time, int upperbound, std::set<int>& chosen) const
-    -> bool
+auto LNS::repair_ordering(SIPP& sipp, std::unordered_set<int>& planned, const std::vector<int>& order,
+                          std::vector<TimePointPath>& new_paths, bool& bound_exceeded) const -> bool
 {
-  assertm(static_cast<int>(chosen.size()) < neighborhood_size, "Randomwalk not needed.");
-  int curr = start_location;
-  for (int t = start_time; t < upperbound; t++)
+  // the arrival budget of the neighborhood, the new paths have to improve the sum of costs at least by one
+  // an unsafe solution is replaced by any safe one, so its neighborhoods are not bounded
+  const bool bounded          = settings.bounded_repair && solution_unsafe_steps.empty();
+  int        budget           = -1;
+  int        lower_bound_rest = 0;
+  if (bounded)
   {
-    std::vector<int> next_locations = instance.get_neighbor_locations(curr);
-    next_locations.push_back(curr);  // agent can also stay
-    std::shuffle(next_locations.begin(), next_locations.end(), rnd_generator);
-    // try all possible neighbors in random order
-    bool moved = false;
-    for (auto loc : next_locations)
+    for (int it : order)
     {
-      int next_h_val = instance.get_heuristic_distance(agent_num, loc);
-      // if lowerbound on the time to reach goal smaller than limit, accept the move
-      if (t + 1 + next_h_val < upperbound)
-      {
-        // get the agent that is in conflict and add it to the neighborhood
-        auto [conflicting_agent_vertex, conflicting_agent_edge] = constraint_table.get_blocking_agent(curr, loc, t + 1);
-
-        // if there is an agent in collision, add it to the neighborhood
-        if (conflicting_agent_vertex != -1)
-        {
-          chosen.insert(conflicting_agent_vertex);
-        }
-
-        if (conflicting_agent_edge != -1)
-        {
-          chosen.insert(conflicting_agent_edge);
-        }
+      budget += solution.paths[it].back().interval.t_min;
+      lower_bound_rest += instance.get_heuristic_distance(it, instance.get_start_locations()[it]);
+    }
+  }
 
-        curr  = loc;
-        moved = true;
-        break;
-      }
+  // replan
+  for (int i = 0; i < static_cast<int>(order.size()); i++)
+  {
+    int path_idx    = order[i];
+    int max_arrival = INT_MAX;
+    if (bounded)
+    {
+      // the agents planned later need at least their shortest path
+      lower_bound_rest -= instance.get_heuristic_distance(path_idx, instance.get_start_locations()[path_idx]);
+      max_arrival = budget - lower_bound_rest;
     }
-    // test whether enough agents selected
-    if (static_cast<int>(chosen.size()) >= neighborhood_size)
+    TimePointPath tp_path = sipp.plan(path_idx, planned, max_arrival);
+    if (tp_path.empty())
     {
-      return true;
+      // the repair is aborted by the bound only if the bound cut the search, otherwise the neighborhood is infeasible
+      bound_exceeded = bounded && sipp.bound_pruned;
+      return false;
     }
+    budget -= tp_path.back().interval.t_min;
 
-    // if none of the next locations was valid, return
-    if (!moved)
+    // get the visualization info
+    if (settings.sipp_settings.info_type == INFO_type::visualisation)
     {
-      break;
+      sipp_info[i] = std::move(sipp.iter_info);
+      sipp.iter_info.clear();
     }
+
+    sipp.safe_interval_table.add_constraints(tp_path);
+    new_paths[i] = std::move(tp_path);
+    planned.insert(path_idx);
   }
-  assertm(static_cast<int>(chosen.size()) <= neighborhood_size, "Enough agents selected, but false returned.");
-  return false;
+  return true;
 }
 
-void LNS::destroy_intersection(Solution& sol) const
+void LNS::repair_orderings(SolutionOverlay& sol_overlay) const
 {
-  last_destroy_strategy = DESTROY_TYPE::INTERSECTION;
-  assertm(constraint_table_initialized, "Constraint table is not initialized.");
+  const int num_orderings = settings.repair_orderings;
+  const int num_destroyed = static_cast<int>(sol_overlay.destroyed_paths.size());
 
-  // find all intersection vertices
-  std::vector<int> intersection_vertices_free;
-  intersection_vertices_free.reserve(instance.get_num_free_cells());  // upperbound on number of intersection vertices
+  // the other orderings plan on their own planners, which mirror the reservations of the solution
+  if (static_cast<int>(ordering_planners.size()) != num_orderings - 1)
+  {
+    ordering_planners.clear();
+    ordering_generators.clear();
+    ordering_generators.reserve(num_orderings - 1);
+    for (int r = 1; r < num_orderings; r++)
+    {
+      ordering_generators.emplace_back(rnd_generator());
+      ordering_planners.push_back(std::make_unique<SIPP>(instance, ordering_generators.back(), settings.sipp_settings));
+      ordering_planners.back()->safe_interval_table.build_sequential(solution.paths);
+      add_safety_reservations(ordering_planners.back()->safe_interval_table);
+    }
+  }
+  ordering_results.resize(num_orderings);
 
-  for (int i = 0; i < instance.get_num_free_cells(); i++)
+  // the first ordering is the one chosen by the destroy operator, the others are shuffled
+  for (int r = 0; r < num_orderings; r++)
   {
-    const auto& agents_counts = constraint_table.get_agents_counts_free(i);
-    if (static_cast<int>(agents_counts.size()) >= 3)
+    OrderingResult& result = ordering_results[r];
+    result.order           = sol_overlay.destroyed_paths;
+    result.new_paths.assign(num_destroyed, TimePointPath());
+    result.bound_exceeded = false;
+    if (r > 0)
     {
-      intersection_vertices_free.push_back(i);
+      std::shuffle(result.order.begin(), result.order.end(), ordering_generators[r - 1]);
+      result.planned = already_planned;
+      for (int it : result.order)
+      {
+        ordering_planners[r - 1]->safe_interval_table.remove_constraints(solution.paths[it]);
+      }
     }
   }
 
-  // create queue
-  std::queue<int> openlist;
+#pragma omp parallel for num_threads(num_orderings) schedule(static, 1)
+  for (int r = 0; r < num_orderings; r++)
+  {
+    OrderingResult& result = ordering_results[r];
+    SIPP&           sipp   = r == 0 ? *planner : *ordering_planners[r - 1];
+    result.feasible = repair_ordering(sipp, r == 0 ? already_planned : result.planned, result.order, result.new_paths, result.bound_exceeded);
+    result.cost     = 0;
+    for (const auto& tp_path : result.new_paths)
+    {
+      result.cost += tp_path.empty() ? 0 : tp_path.back().interval.t_min;
+    }
+  }
 
-  // pick a random intersection vertex
+  // choose the cheapest feasible ordering
+  int winner = -1;
+  for (int r = 0; r < num_orderings; r++)
   {
-    std::uniform_int_distribution<int> dist(0, intersection_vertices_free.size() - 1);
-    int                                idx    = dist(rnd_generator);
-    int                                chosen = instance.free_location_to_location(intersection_vertices_free[idx]);
-    openlist.push(chosen);
+    if (ordering_results[r].feasible && (winner == -1 || ordering_results[r].cost < ordering_results[winner].cost))
+    {
+      winner = r;
+    }
   }
 
+  // the other planners drop their paths, they get the final paths of the neighborhood in sync_ordering_planners
+  for (int r = 1; r < num_orderings; r++)
+  {
+    for (const auto& tp_path : ordering_results[r].new_paths)
+    {
+      if (!tp_path.empty())
+      {
+        ordering_planners[r - 1]->safe_interval_table.remove_constraints(tp_path);
+      }
+    }
+  }
+  orderings_pending = true;
 
-  std::unordered_set<int> neighborhood;  // TODO try set
-  std::vector<bool>       known(instance.get_num_cells(), false);
+  // the planner of the LNS holds the paths of the winner, or the partial paths of the first ordering if all failed
+  if (winner > 0)
+  {
+    for (const auto& tp_path : ordering_results[0].new_paths)
+    {
+      if (!tp_path.empty())
+      {
+        planner->safe_interval_table.remove_constraints(tp_path);
+      }
+    }
+    for (const auto& tp_path : ordering_results[winner].new_paths)
+    {
+      planner->safe_interval_table.add_constraints(tp_path);
+    }
+    already_planned.insert(ordering_results[winner].order.begin(), ordering_results[winner].order.end());
+  }
+  const OrderingResult& chosen = ordering_results[std::max(winner, 0)];
+  sol_overlay.destroyed_paths  = chosen.order;
+  sol_overlay.new_paths        = chosen.new_paths;
+  sol_overlay.feasible         = winner >= 0;
+  sol_overlay.bound_exceeded   = winner < 0 && chosen.bound_exceeded;
+}
 
-  while (!openlist.empty())
+void LNS::sync_ordering_planners()
+{
+  if (!orderings_pending)
   {
-    // retrieve current node
-    int current = openlist.front();
-    openlist.pop();
-    // std::cout << "Current: " << current << std::endl;
-    if (known[current])
+    return;
+  }
+  // the planners of the orderings get the final paths of the neighborhood
+  for (auto& ordering_planner : ordering_planners)
+  {
+    for (int it : overlay.destroyed_paths)
     {
-      continue;
+      ordering_planner->safe_interval_table.add_constraints(solution.paths[it]);
     }
-    known[current] = true;
+  }
+  orderings_pending = false;
+}
 
-    // check whether intersection vertex
-    auto agents_counts = constraint_table.get_agents_counts(current);
-    if (static_cast<int>(agents_counts.size()) >= 3)
+void LNS::discard_solution(const SolutionOverlay& sol_overlay) const
+{
+  const int num_destroyed = static_cast<int>(sol_overlay.destroyed_paths.size());
+  for (int i = 0; i < num_destroyed; i++)
+  {
+    // remove the new paths
+    if (!sol_overlay.new_paths[i].empty())
     {
-      // add agents that visit this vertex to the neighborhood
-      get_intersection_agents(neighborhood, current);
+      planner->safe_interval_table.remove_constraints(sol_overlay.new_paths[i]);
     }
+  }
 
-    // check whether enough agents selected
-    // std::cout << "Selected: " << static_cast<int>(neighborhood.size()) << std::endl;
-    if (settings.destroy_settings.size == static_cast<int>(neighborhood.size()))
+  // restore the old paths
+  const Solution& prev_sol = sol_overlay.get_base();
+  for (int it : sol_overlay.destroyed_paths)
+  {
+    planner->safe_interval_table.add_constraints(prev_sol.paths[it]);
+    already_planned.insert(it);
+  }
+}
+
+void LNS::commit_overlay()
+{
+  // the constraint table is not used by the repair, so it is updated only for the accepted paths
+  if (constraint_table_initialized)
+  {
+    for (int it : overlay.destroyed_paths)
     {
-      break;
+      constraint_table.remove_constraints(solution.paths[it], it);
+    }
+    for (int i = 0; i < static_cast<int>(overlay.destroyed_paths.size()); i++)
+    {
+      constraint_table.add_constraints(overlay.new_paths[i], overlay.destroyed_paths[i]);
     }
+  }
+  overlay.commit(solution, instance);
+}
 
-    // add neighbors to the queue
-    auto neighbors = instance.get_neighbor_locations(current);
-    for (auto it : neighbors)
+/**
+ * @brief Lists the unsafe steps of all humans as pairs.
+ *
+ * @param unsafe_steps The unsafe steps of each human.
+ *
+ * @return The (human, step) pairs ordered by the humans and the steps.
+ */
+static auto flatten_unsafe_steps(const std::vector<std::vector<int>>& unsafe_steps) -> std::vector<std::pair<int, int>>
+{
+  std::vector<std::pair<int, int>> flat;
+  for (int human = 0; human < static_cast<int>(unsafe_steps.size()); human++)
+  {
+    for (int step : unsafe_steps[human])
     {
-      openlist.push(it);
+      flat.emplace_back(human, step);
     }
   }
-  //assertm(static_cast<int>(neighborhood.size()) > 1, "Not enough agents selected for destroy.");
-  if (static_cast<int>(neighborhood.size()) <= 1)
+  return flat;
+}
+
+bool LNS::validate_safety(const SolutionOverlay& sol_overlay)
+{
+  if (!safety_aware_mode) return true; // Baseline mode = vždy bezpečné
+  if (!has_humans()) return true;
+
+  initialize_safety_checker();
+  safety_checker->stage(sol_overlay);
+
+  // Projít každý krok cest lidí (nebo do konce řešení, co je delší), všechny lidi i dveře vyhodnotí jeden průchod
+  const int check_duration = get_safety_duration(sol_overlay.get_makespan());
+  if (solution_unsafe_steps.empty())
   {
-      // std::cout << "Intersection destroy failed (not enough agents), switching to Random." << std::endl;
-      destroy_random(sol);
-      return;
+    return safety_checker->is_safe(human_paths, safety_exit_locations, check_duration);
   }
 
-  // convert to vector and shuffle
-  sol.destroyed_paths = std::vector(std::make_move_iterator(neighborhood.begin()), std::make_move_iterator(neighborhood.end()));
-  // shuffle the paths
-  std::shuffle(sol.destroyed_paths.begin(), sol.destroyed_paths.end(), rnd_generator);
-  assertm(sol.destroyed_paths.size() > 0, "No paths were destroyed.");
-  sol.feasible = false;
+  // an unsafe solution is restored gradually, the candidate has to have fewer unsafe steps
+  candidate_unsafe_steps = flatten_unsafe_steps(safety_checker->get_unsafe_steps(human_paths, safety_exit_locations, check_duration, false));
+  return candidate_unsafe_steps.size() < solution_unsafe_steps.size();
 }
 
-void LNS::get_intersection_agents(std::unordered_set<int>& neighborhood, int current) const
+void LNS::initialize_safety_checker()
 {
-  // find maximal T
-  int t_max = constraint_table.get_last_constraint_start(current);
+  // the reservations are built once and then updated only by the replaced paths
+  if (safety_checker != nullptr)
+  {
+    return;
+  }
+  safety_checker = std::make_unique<SafetyChecker>(instance, settings.safety_threads);
+  safety_checker->build(solution.paths);
+  solution_unsafe_steps = flatten_unsafe_steps(
+      safety_checker->get_unsafe_steps(human_paths, safety_exit_locations, get_safety_duration(solution.makespan), false));
+  update_escape_routes();
+  publish_safe_solution();
+}
 
-  // choose random time
-  std::uniform_int_distribution<int> dist(0, t_max);
-  int                                t     = dist(rnd_generator);
-  int                                delta = 0;
-  while (static_cast<int>(neighborhood.size()) < settings.destroy_settings.size && t + delta <= t_max && t - delta >= 0)
+void LNS::update_escape_routes()
+{
+  // the solution is safe again, so no route has to be kept free
+  if (solution_unsafe_steps.empty())
   {
-    // find the agent, that blocks the cell at time t + delta
-    auto [blocking_agent_1, blocking_agent_2] = constraint_table.get_blocking_agent(current, current, t + delta);
-    // find the agent, that blocks the cell at time t - delta
-    auto [blocking_agent_3, blocking_agent_4] = constraint_table.get_blocking_agent(current, current, t - delta);
+    escape_routes.clear();
+    return;
+  }
+
+  // the routes are found here, so the destroy and the repair do not share the distances of the checker, the routes of the safe steps are
+  // needed too, otherwise the replanned robots would block them instead
+  int duration = get_safety_duration(solution.makespan);
+  for (const auto& [human, step] : solution_unsafe_steps)
+  {
+    duration = std::max(duration, step + 1);
+  }
+  escape_routes.resize(human_paths.size());
+  std::vector<std::pair<int, int>> steps;  // (human, step)
+  for (int human = 0; human < static_cast<int>(human_paths.size()); human++)
+  {
+    const int known_steps = static_cast<int>(escape_routes[human].size());
+    if (human_paths[human].empty() || known_steps >= duration)
+    {
+      continue;
+    }
+    escape_routes[human].resize(duration);
+    for (int t = known_steps; t < duration; t++)
+    {
+      steps.emplace_back(human, t);
+    }
+  }
+  if (steps.empty())
+  {
+    return;
+  }
+
+  // the first route computes the distances to the exits, the other routes only read them
+  const auto [first_human, first_step] = steps[0];
+  escape_routes[first_human][first_step] =
+      safety_checker->get_escape_route(get_human_location(first_human, first_step), first_step, safety_exit_locations);
+  const int num_steps = static_cast<int>(steps.size());
+#pragma omp parallel for num_threads(settings.safety_threads) if (settings.safety_threads > 1) schedule(dynamic, 16)
+  for (int i = 1; i < num_steps; i++)
+  {
+    const auto [human, t]   = steps[i];
+    escape_routes[human][t] = safety_checker->get_escape_route(get_human_location(human, t), t, safety_exit_locations);
+  }
+}
+
+void LNS::sync_safety_checker(bool accepted)
+{
+  if (safety_checker == nullptr || !safety_checker->has_staged())
+  {
+    return;
+  }
+  if (accepted)
+  {
+    // the accepted overlay is safe, or it has fewer unsafe steps than the unsafe solution
+    safety_checker->commit();
+    if (!solution_unsafe_steps.empty())
+    {
+      solution_unsafe_steps.swap(candidate_unsafe_steps);
+      update_escape_routes();
+    }
+  }
+  else
+  {
+    safety_checker->rollback(overlay);
+  }
+}
 
-    // add the agents to the neighborhood
-    std::array<int, 4> blocking_agents = {blocking_agent_1, blocking_agent_2, blocking_agent_3, blocking_agent_4};
-    for (auto blocking_agent : blocking_agents)
+auto LNS::get_blocking_robots(const TimePointPath& route, const ConstraintTable& table) -> std::vector<int>
+{
+  std::vector<int> blocking_robots;
+
+  // the exit at the end of the route can be entered even if a robot is there, the human has to be able to stay in a cell until it moves on
+  int from = route.empty() ? -1 : route.front().location;
+  for (size_t i = 0; i + 1 < route.size(); i++)
+  {
+    const TimePoint& time_point = route[i];
+    const int time                  = time_point.interval.t_min;
+    auto [vertex_agent, edge_agent] = table.get_blocking_agent(from, time_point.location, time);
+    const int next_agent            = table.get_blocking_agent(time_point.location, time_point.location, time + 1).first;
+    for (int agent : {vertex_agent, edge_agent, next_agent})
     {
-      if (blocking_agent >= 0 && static_cast<int>(neighborhood.size()) < settings.destroy_settings.size)
+      if (agent != -1)
       {
-        neighborhood.insert(blocking_agent);
+        blocking_robots.push_back(agent);
       }
     }
-    delta++;
+    from = time_point.location;
   }
+  return blocking_robots;
 }
 
-void LNS::destroy_adaptive(Solution& sol) const
+void LNS::add_escape_reservations(SafeIntervalTable& table, std::vector<TimePoint>& reservations) const
 {
-  // choose strategy by roulette wheel selection
-  // calculate the sum of weights
-  auto sum_of_weights = std::reduce(destroy_weights.begin(), destroy_weights.end());
-  assertm(sum_of_weights > 0, "Invalid weights.");
-
-
-  // choose a random number in the range [0, sum_of_weights]
-  std::uniform_real_distribution<double> dist(0.0, sum_of_weights);
-  double                                 rand_value = dist(rnd_generator);
-
-  // spin the roulette
-  double       cummulative_sum = 0.0;
-  DESTROY_TYPE chosen_type     = DESTROY_TYPE::ADAPTIVE;
-  for (int i = 0; i < static_cast<int>(destroy_weights.size()); i++)
+  // the human stays in each cell of a route from its arrival until it can leave, the exit is never reserved
+  std::vector<std::pair<int, int>> route_cells;  // (location, time)
+  for (const auto& human_routes : escape_routes)
   {
-    cummulative_sum += destroy_weights[i];
-    if (rand_value <= cummulative_sum)
+    for (const auto& route : human_routes)
     {
-      auto chosen = magic_enum::enum_cast<DESTROY_TYPE>(i);
-      if (chosen.has_value())
+      for (size_t i = 0; i + 1 < route.size(); i++)
       {
-        chosen_type = chosen.value();
-        break;
+        route_cells.emplace_back(route[i].location, route[i].interval.t_min);
       }
-      throw std::runtime_error(std::string("Unknown DESTROY_TYPE ") + std::string(magic_enum::enum_name<DESTROY_TYPE>(chosen_type)) +
-                               std::string(" encountered in adaptive destroy."));
     }
   }
-  assertm(chosen_type != DESTROY_TYPE::ADAPTIVE && chosen_type != DESTROY_TYPE::RANDOM_CHOOSE, "Did not select any destroy strategy.");
+  std::sort(route_cells.begin(), route_cells.end());
 
-  // if sum of weights too small, increase it
-  if (sum_of_weights < 0.1)
+  // the robots are at their starts at time 0
+  std::vector<bool> is_start(instance.get_map_data().width * instance.get_map_data().height, false);
+  for (int start : instance.get_start_locations())
   {
-    for (double& destroy_weight : destroy_weights)
+    is_start[start] = true;
+  }
+
+  // merge the times of each cell and keep only the parts, which are not reserved by the remaining robots or the corridor
+  reservations.clear();
+  for (size_t i = 0; i < route_cells.size();)
+  {
+    const int    location = route_cells[i].first;
+    TimeInterval interval(route_cells[i].second, route_cells[i].second + 1);
+    for (i++; i < route_cells.size() && route_cells[i].first == location && route_cells[i].second <= interval.t_max + 1; i++)
     {
-      destroy_weight *= 10;
+      interval.t_max = std::max(interval.t_max, route_cells[i].second + 1);
+    }
+    if (is_start[location])
+    {
+      interval.t_min = std::max(interval.t_min, 1);
+    }
+    auto [first, last] = table.get_safe_intervals(location, interval);
+    for (auto it = first; it != last; it++)
+    {
+      reservations.emplace_back(location, TimeInterval(std::max(it->t_min, interval.t_min), std::min(it->t_max, interval.t_max)));
     }
   }
-  // std::cout << "Weights are: " << std::endl;
-  // for (auto it : destroy_weights)
-  // {
-  //   std::cout << it << ", ";
-  // }
-  // std::cout << std::endl;
-  // std::cout << "Chosen destroy: " << magic_enum::enum_name<DESTROY_TYPE>(chosen_type) << std::endl;
-
-  // apply the destroy operator
-  switch (chosen_type)
+  for (const auto& reservation : reservations)
   {
-    case DESTROY_TYPE::RANDOM:
-      destroy_random(sol);
-      break;
-    case DESTROY_TYPE::RANDOMWALK:
-      destroy_randomwalk(sol);
-      break;
-    case DESTROY_TYPE::INTERSECTION:
-      destroy_intersection(sol);
-      break;
-    default:
-      throw std::runtime_error(std::string("Unknown DESTROY_TYPE ") + std::string(magic_enum::enum_name<DESTROY_TYPE>(chosen_type)) +
-                               std::string(" encountered in adaptive destroy."));
+    table.add_constraint(reservation);
   }
 }
 
-void LNS::destroy_blocked(Solution& sol) const
+void LNS::destroy_safety(Solution& sol) const
 {
-  last_destroy_strategy = DESTROY_TYPE::BLOCKED;
+  last_destroy_strategy = DESTROY_TYPE::SAFETY;
 
-  // if a random value is higher, than the threshold, perform randomwalk instead
-  std::uniform_real_distribution<float> blocked_dist(0, 1);
-  if (blocked_dist(rnd_generator) >= threshold_blocked)
+  // a safe solution has no blocking robots
+  if (solution_unsafe_steps.empty() || escape_routes.empty())
   {
-    // std::cout << "Running randomwalk. Threshold: " << threshold_blocked << std::endl;
     destroy_randomwalk(sol);
     return;
   }
 
-  // find all agents whose end is blocked
-  std::vector<int> blocked_agents;
-  for (int i = 0; i < instance.get_num_of_agents(); i++)
+  // collect the robots blocking the unsafe steps, starting from a random one
+  assertm(constraint_table_initialized, "The blocking robots need the constraint table.");
+  std::unordered_set<int> neighborhood;
+  sol.destroyed_paths.clear();
+  const int                          num_unsafe = static_cast<int>(solution_unsafe_steps.size());
+  std::uniform_int_distribution<int> step_dist(0, num_unsafe - 1);
+  const int                          first_step = step_dist(*destroy_generator);
+  for (int i = 0; i < num_unsafe && static_cast<int>(sol.destroyed_paths.size()) < destroy_size; i++)
   {
-    const int loc        = instance.get_goal_locations()[i];
-    const int reach_time = sol.paths[i].back().interval.t_min;
-    assertm(sol.paths[i].back().location == loc, "The path does not end in the goal location");
-    // skip agents that dont have any delay
-    if (reach_time == instance.get_heuristic_distance(i, instance.get_start_locations()[i]) - 1)
-    {
-      continue;
-    }
-    assertm(reach_time >= instance.get_heuristic_distance(i, instance.get_start_locations()[i]), "Invalid reach time");
-    assertm(constraint_table_initialized, "Constraint table is not initialized.");
-    int from = loc;
-    if (static_cast<int>(sol.paths[i].size()) > 1)
-    {
-      from = std::prev(sol.paths[i].end(), 2)->location;
-    }
-    auto [blocking_agent_1, blocking_agent_2] = constraint_table.get_blocking_agent(from, loc, reach_time - 1);
-    if (blocking_agent_1 != -1 || blocking_agent_2 != -1)
+    const auto [human, step] = solution_unsafe_steps[(first_step + i) % num_unsafe];
+    for (int agent : get_blocking_robots(escape_routes[human][step], constraint_table))
     {
-      blocked_agents.push_back(i);
+      if (neighborhood.insert(agent).second)
+      {
+        sol.destroyed_paths.push_back(agent);
+      }
     }
   }
-
-  // if no agent is blocked, use the randomwalk
-  if (blocked_agents.empty())
+  if (sol.destroyed_paths.empty())
   {
     destroy_randomwalk(sol);
     return;
   }
-  // std::cout << "Number of blocked_agents: " << blocked_agents.size() << std::endl;
 
-  // choose a random agent from blocked agents
-  std::uniform_int_distribution<int> dist(0, blocked_agents.size() - 1);
-  int                                chosen_agent = -1;
+  // fill the rest of the neighborhood by random robots, which gives the repair more freedom
+  std::uniform_int_distribution<int> agent_dist(0, instance.get_num_of_agents() - 1);
+  const int max_size = std::min(destroy_size, instance.get_num_of_agents());
+  while (static_cast<int>(sol.destroyed_paths.size()) < max_size)
   {
-    int idx      = dist(rnd_generator);
-    chosen_agent = blocked_agents[idx];
+    const int agent = agent_dist(*destroy_generator);
+    if (neighborhood.insert(agent).second)
+    {
+      sol.destroyed_paths.push_back(agent);
+    }
   }
-  // std::cout << "Chosen agent: " << chosen_agent << std::endl;
+  if (static_cast<int>(sol.destroyed_paths.size()) > destroy_size)
+  {
+    sol.destroyed_paths.resize(destroy_size);
+  }
+}
 
-  // add the agent to the neighborhood
-  std::unordered_set<int> neighborhood = {chosen_agent};
-  int                     idx          = -1;
-  sol.destroyed_paths                  = {chosen_agent};
-  while (static_cast<int>(sol.destroyed_paths.size()) < settings.destroy_settings.size)
+void LNS::build_safety_reservations()
+{
+  safety_reservations.clear();
+  if (!safety_aware_mode || !settings.safety_corridor || human_paths.empty())
   {
-    const int        loc                 = instance.get_goal_locations()[chosen_agent];
-    const int        min_reach_time      = instance.get_heuristic_distance(chosen_agent, instance.get_start_locations()[chosen_agent]);
-    std::vector<int> blocking_agents_new = constraint_table.get_blocking_agents(loc, min_reach_time - 1);
+    return;
+  }
 
-    // add all new blocking agents to the neighborhood
-    for (auto it : blocking_agents_new)
+  // the cells of the corridor at each step of each human, until it leaves through an exit
+  const Map&                       map_data = instance.get_map_data();
+  const int                        margin   = settings.safety_corridor_margin;
+  std::vector<std::pair<int, int>> corridor;  // (location, time)
+  for (const auto& human_path : human_paths)
+  {
+    for (int t = 0; t < static_cast<int>(human_path.size()) && !is_safety_exit(human_path[t]); t++)
     {
-      if (neighborhood.find(it) == neighborhood.end())
+      const int x = human_path[t] % map_data.width;
+      const int y = human_path[t] / map_data.width;
+      for (int dy = -margin; dy <= margin; dy++)
       {
-        neighborhood.insert(it);
-        sol.destroyed_paths.push_back(it);
-        // make sure that the neighborhood size is not exceeded
-        // if (static_cast<int>(sol.destroyed_paths.size()) >= settings.destroy_settings.size)
-        // {
-        //   break;
-        // }
+        for (int dx = std::abs(dy) - margin; dx <= margin - std::abs(dy); dx++)
+        {
+          const int nx = x + dx;
+          const int ny = y + dy;
+          // the walls and the doors are not reserved
+          if (nx >= 0 && nx < map_data.width && ny >= 0 && ny < map_data.height && map_data.index(ny * map_data.width + nx) == 0)
+          {
+            corridor.emplace_back(ny * map_data.width + nx, t);
+          }
+        }
       }
     }
+  }
+  std::sort(corridor.begin(), corridor.end());
 
-    // update index
-    idx++;
-    if (idx >= static_cast<int>(sol.destroyed_paths.size()))
+  // the robots are at their starts at time 0
+  std::vector<bool> is_start(map_data.width * map_data.height, false);
+  for (int start : instance.get_start_locations())
+  {
+    is_start[start] = true;
+  }
+
+  // merge the times of each cell to intervals, a cell is kept reserved one timestep after the human moved away
+  for (size_t i = 0; i < corridor.size();)
+  {
+    const int location = corridor[i].first;
+    TimeInterval interval(corridor[i].second, corridor[i].second + 1);
+    for (i++; i < corridor.size() && corridor[i].first == location && corridor[i].second <= interval.t_max + 1; i++)
     {
-      break;
+      interval.t_max = std::max(interval.t_max, corridor[i].second + 1);
+    }
+    if (is_start[location])
+    {
+      interval.t_min = std::max(interval.t_min, 1);
     }
+    safety_reservations.emplace_back(location, interval);
+  }
+}
 
-    // update chosen agent
-    chosen_agent = sol.destroyed_paths[idx];
+void LNS::add_safety_reservations(SafeIntervalTable& table) const
+{
+  for (const auto& reservation : safety_reservations)
+  {
+    table.add_constraint(reservation);
   }
-  // shuffle randomly,  only when threshold is low (we need more variance)
-  if (blocked_dist(rnd_generator) >= threshold_blocked)
+}
+
+auto LNS::find_human_path(int location) const -> std::vector<int>
+{
+  // the robots are ignored, the human has the priority
+  std::vector<int> human_path;
+  for (int exit_location : safety_exit_locations)
   {
-    // std::cout << "Shuffle. Threshold: " << threshold_blocked << std::endl;
-    std::shuffle(sol.destroyed_paths.begin(), sol.destroyed_paths.end(), rnd_generator);
+    std::vector<int> path = planner->find_shortest_path(location, exit_location);
+    if (!path.empty() && (human_path.empty() || path.size() < human_path.size()))
+    {
+      human_path = std::move(path);
+    }
   }
-  // dont exceed the neighborhood size
-  if (settings.destroy_settings.size < static_cast<int>(sol.destroyed_paths.size()))
+  return human_path;
+}
+
+void LNS::push_human_update(int human, int location, int time)
+{
+  if (human < 0 || human >= static_cast<int>(human_start_locations.size()))
   {
-    sol.destroyed_paths.resize(settings.destroy_settings.size);
+    throw std::runtime_error("Invalid human index.");
   }
-  assertm(settings.destroy_settings.size == 1 || static_cast<int>(sol.destroyed_paths.size()) > 1,
-          "At least two paths should be destroyed.");
-  sol.feasible = false;
+  if (!instance.get_map_data().is_in(location) || instance.get_map_data().index(location) == 1)
+  {
+    throw std::runtime_error("Invalid human position.");
+  }
+  if (time < 0 || time > MAX_HUMAN_UPDATE_TIME)
+  {
+    throw std::runtime_error("Invalid human observation time.");
+  }
+  std::lock_guard<std::mutex> lock(human_update_mutex);
+  pending_human_updates.push_back({human, location, time});
 }
 
-void LNS::destroy_random_choose(Solution& sol) const
+void LNS::replan_human(const HumanUpdate& update)
 {
-  std::uniform_int_distribution<int> dist(0, 2);
-  int                                rand_value = dist(rnd_generator);
-  // apply the destroy operator
-  switch (rand_value)
+  // keep the steps before the observation, the human waits at the end of its path
+  std::vector<int> human_path;
+  human_path.reserve(update.time + 1);
+  for (int t = 0; t < update.time; t++)
   {
-    case 0:
-      destroy_random(sol);
-      break;
-    case 1:
-      destroy_randomwalk(sol);
-      break;
-    case 2:
-      destroy_intersection(sol);
-      break;
-    default:
-      throw std::runtime_error("Unknown DESTROY_TYPE encountered in adaptive destroy.");
+    human_path.push_back(human_paths[update.human].empty() ? human_start_locations[update.human] : get_human_location(update.human, t));
+  }
+
+  // the human continues to the nearest exit from the observed location, or it stays there if no exit can be reached
+  std::vector<int> escape_path = find_human_path(update.location);
+  if (escape_path.empty())
+  {
+    std::cout << "WARNING: Human " << update.human << " cannot reach any exit from location " << update.location << "!" << std::endl;
+    escape_path.push_back(update.location);
   }
+  human_path.insert(human_path.end(), escape_path.begin(), escape_path.end());
+  human_paths[update.human] = std::move(human_path);
 }
 
-void LNS::repair_default(Solution& sol) const
+auto LNS::process_human_updates() -> bool
 {
-  assertm(!sol.feasible, "Can not repair a feasible solution");
-  assertm((int)sol.destroyed_paths.size() > 0, "There are no destroyed paths in the solution to be repaired.");
+  std::vector<HumanUpdate> updates;
+  {
+    std::lock_guard<std::mutex> lock(human_update_mutex);
+    updates.swap(pending_human_updates);
+  }
+  if (updates.empty() || human_paths.empty())
+  {
+    return false;
+  }
 
-  if (settings.sipp_settings.info_type == INFO_type::visualisation)
+  Clock update_clock;
+  update_clock.start();
+  for (const auto& update : updates)
   {
-    sipp_info.clear();
-    sipp_info.resize(sol.destroyed_paths.size());
+    replan_human(update);
   }
 
-  // remove the destroyed paths
-  for (auto& it : sol.destroyed_paths)
+  // the safe solution was checked against the old human paths, it is kept but stale until it is checked against the new ones
+  safe_solution_current.store(false, std::memory_order_release);
+  if (!safety_aware_mode || !has_humans() || !solution.feasible)
   {
-    // std::cout << "Removing path: " << it << std::endl;
-    planner->safe_interval_table.remove_constraints(sol.paths[it]);
-    if (constraint_table_initialized)
-    {
-      constraint_table.remove_constraints(sol.paths[it], it);
-    }
-    sol.paths[it].clear();
-    already_planned.erase(it);
+    return true;
   }
-  sol.feasible = true;
 
-  // replan
-  for (int i = 0; i < static_cast<int>(sol.destroyed_paths.size()); i++)
+  // the corridor and the escape analysis follow the new human paths, the neighborhood chosen for the old paths is dropped
+  update_safety_reservations();
+  has_candidate = false;
+  if (!constraint_table_initialized)
   {
-    int           path_idx = sol.destroyed_paths[i];
-    TimePointPath tp_path  = planner->plan(path_idx, already_planned);
-    if (tp_path.empty())
+    initialize_constraint_table(solution.paths);
+  }
+  if (safety_checker == nullptr)
+  {
+    initialize_safety_checker();
+  }
+  else
+  {
+    solution_unsafe_steps = flatten_unsafe_steps(
+        safety_checker->get_unsafe_steps(human_paths, safety_exit_locations, get_safety_duration(solution.makespan), false));
+    escape_routes.clear();
+    update_escape_routes();
+  }
+
+  // only the robots blocking the new escape routes are replanned, an unsafe solution accepts any candidate with fewer unsafe steps
+  while (!solution_unsafe_steps.empty() && update_clock.get_current_time().first < settings.human_update_budget)
+  {
+    destroy_safety(solution);
+    if (solution.destroyed_paths.empty())
     {
-      sol.feasible = false;
-      return;
+      break;
     }
-
-    // get the visualization info
-    if (settings.sipp_settings.info_type == INFO_type::visualisation)
+    overlay.reset(solution.destroyed_paths);
+    solution.feasible = true;
+    repair_operator.apply(overlay);
+    const bool accepted = overlay.feasible && validate_safety(overlay);
+    if (accepted)
     {
-      sipp_info[i] = std::move(planner->iter_info);
-      planner->iter_info.clear();
+      commit_overlay();
     }
-
-    planner->safe_interval_table.add_constraints(tp_path);
-    if (constraint_table_initialized)
+    else
     {
-      constraint_table.add_constraints(tp_path, path_idx);
+      discard_solution(overlay);
     }
-    sol.paths[path_idx] = tp_path;
-    already_planned.insert(path_idx);
+    sync_ordering_planners();
+    sync_safety_checker(accepted);
   }
+  publish_safe_solution();
+  verify_safe_solution();
+  return true;
 }
 
-void LNS::discard_solution(const Solution& sol, const Solution& prev_sol) const
+void LNS::update_safety_reservations()
 {
-  for (int it : sol.destroyed_paths)
+  // the old corridor is removed from all planners, the planners of the orderings are rebuilt with the new one
+  for (const auto& reservation : safety_reservations)
   {
-    // remove the destroyed paths
-    if (!sol.paths[it].empty())
-    {
-      planner->safe_interval_table.remove_constraints(sol.paths[it]);
-      if (constraint_table_initialized)
-      {
-        constraint_table.remove_constraints(sol.paths[it], it);
-      }
-    }
+    planner->safe_interval_table.remove_constraint(reservation);
   }
+  ordering_planners.clear();
+  ordering_generators.clear();
+  build_safety_reservations();
 
-  // restore the old paths
-  for (int it : sol.destroyed_paths)
+  // the cells occupied by the robots are left out, they are freed by the repair of the unsafe steps
+  std::vector<TimePoint> free_reservations;
+  for (const auto& reservation : safety_reservations)
   {
-    planner->safe_interval_table.add_constraints(prev_sol.paths[it]);
-    if (constraint_table_initialized)
+    auto [first, last] = planner->safe_interval_table.get_safe_intervals(reservation.location, reservation.interval);
+    for (auto it = first; it != last; it++)
     {
-      constraint_table.add_constraints(prev_sol.paths[it], it);
+      free_reservations.emplace_back(reservation.location, TimeInterval(std::max(it->t_min, reservation.interval.t_min),
+                                                                       std::min(it->t_max, reservation.interval.t_max)));
     }
   }
+  safety_reservations.swap(free_reservations);
+  add_safety_reservations(planner->safe_interval_table);
 }
 
-bool LNS::validate_safety(const Solution& sol)
+void LNS::publish_safe_solution()
 {
-  if (!safety_aware_mode) return true; // Baseline mode = vždy bezpečné
-  if (human_path_locations.empty() || safety_exit_location == -1) return true;
-
-  auto safety_planner = std::make_unique<SIPP>(instance, rnd_generator, settings.sipp_settings);
-
-  // 1. Vyčistit tabulku intervalů v planneru (aby byla prázdná)
-  safety_planner->safe_interval_table.reset();
+  if (safety_checker == nullptr || !solution_unsafe_steps.empty() || !solution.feasible)
+  {
+    return;
+  }
+  std::atomic_store(&safe_solution, std::make_shared<const Solution>(solution));
+  safe_solution_current.store(true, std::memory_order_release);
+}
 
-  // 2. Naplnit tabulku cestami VŠECH robotů z nového řešení (sol)
-  // Roboti jsou nyní "statické/dynamické překážky" pro člověka
-  for (const auto& path : sol.paths) {
-      if (!path.empty()) {
-          safety_planner->safe_interval_table.add_constraints(path);
-      }
+void LNS::verify_safe_solution()
+{
+  auto safe = std::atomic_load(&safe_solution);
+  if (safe == nullptr || safe_solution_current.load(std::memory_order_acquire))
+  {
+    return;
   }
 
-  // 3. Projít každý krok cesty člověka a zkusit najít únik
-  int makespan = sol.makespan;
-  // Nebo délka cesty člověka, co je delší
-  int check_duration = std::max((int)makespan, (int)human_path_locations.size());
+  // the current solution was already checked, other solutions are checked by a separate checker
+  bool safe_for_humans = solution_unsafe_steps.empty();
+  if (safe->paths != solution.paths)
+  {
+    SafetyChecker checker(instance, settings.safety_threads);
+    checker.build(safe->paths);
+    safe_for_humans = checker.is_safe(human_paths, safety_exit_locations, get_safety_duration(safe->makespan));
+  }
+  safe_solution_current.store(safe_for_humans, std::memory_order_release);
+}
 
-  for (int t = 0; t < check_duration; t ++) // Optimalizace: Kontroluj třeba každých 5 kroků, ne každý (pro rychlost)
+auto LNS::get_safety_timeline() const -> std::vector<std::vector<SafetyStep>>
+{
+  if (!has_humans() || !solution.feasible)
   {
-      // Kde je člověk v čase t?
-      int current_human_loc;
-      if (t < (int)human_path_locations.size()) {
-          current_human_loc = human_path_locations[t];
-      } else {
-          current_human_loc = human_path_locations.back(); // Zůstává na konci
-      }
-      if (current_human_loc == safety_exit_location) continue;
+    return {};
+  }
 
-      bool safe = safety_planner->check_reachability(current_human_loc, safety_exit_location, t);
+  // the tables of the LNS may hold other paths, if the solution was replaced by another solver of the portfolio
+  SafetyChecker checker(instance, settings.safety_threads);
+  checker.build(solution.paths);
+  ConstraintTable table(instance);
+  table.build_sequential(solution.paths);
 
-      if (!safe) {
-          //planner->safe_interval_table.reset();
-          return false; 
-      }
+  auto timeline = checker.get_timeline(human_paths, safety_exit_locations, get_safety_duration(solution.makespan));
+  std::vector<std::pair<int, int>> steps;  // (human, step)
+  for (int human = 0; human < static_cast<int>(timeline.size()); human++)
+  {
+    for (int t = 0; t < static_cast<int>(timeline[human].size()); t++)
+    {
+      steps.emplace_back(human, t);
+    }
+  }
+  if (steps.empty())
+  {
+    return timeline;
   }
 
-  // 4. Úklid
-  //planner->safe_interval_table.reset();
-  return true; // SAFE
+  // the first route computes the distances to the exits, the other routes and the tables are only read
+  (void)checker.get_escape_route(timeline[steps[0].first][0].location, 0, safety_exit_locations);
+  const int num_steps = static_cast<int>(steps.size());
+#pragma omp parallel for num_threads(settings.safety_threads) if (settings.safety_threads > 1) schedule(dynamic, 16)
+  for (int i = 0; i < num_steps; i++)
+  {
+    const auto [human, t] = steps[i];
+    SafetyStep& step      = timeline[human][t];
+    step.blocking_robots  = get_blocking_robots(checker.get_escape_route(step.location, t, safety_exit_locations), table);
+    std::sort(step.blocking_robots.begin(), step.blocking_robots.end());
+    step.blocking_robots.erase(std::unique(step.blocking_robots.begin(), step.blocking_robots.end()), step.blocking_robots.end());
+  }
+  return timeline;
 }
 
-// Vlož na konec LNS.cpp
-void LNS::print_safety_report()
+void LNS::print_safety_report(const std::vector<std::vector<SafetyStep>>& timeline)
 {
-    // Pokud nemáme člověka nebo dveře, končíme
-    if (human_path_locations.empty() || safety_exit_location == -1) return;
+    // Pokud nemáme člověka nebo řešení, končíme
+    if (timeline.empty()) return;
 
     std::cout << "Running final safety report..." << std::endl;
 
-    auto safety_planner = std::make_unique<SIPP>(instance, rnd_generator, settings.sipp_settings);
-    safety_planner->safe_interval_table.reset();
-
-    // 1. Reset planneru a přidání finálních cest robotů jako překážek
-    for (const auto& path : solution.paths) {
-        if (!path.empty()) {
-            safety_planner->safe_interval_table.add_constraints(path);
+    // Výpis výsledku
+    for (size_t human = 0; human < timeline.size(); human++) {
+        std::vector<int> failed_steps;
+        for (int t = 0; t < static_cast<int>(timeline[human].size()); t++) {
+            if (!timeline[human][t].reachable) failed_steps.push_back(t);
         }
-    }
-
-    // 2. Příprava pro hledání
-    std::vector<int> failed_steps;
-    int check_duration = std::max((int)solution.makespan, (int)human_path_locations.size());
-
-    // 3. Kontrola každého kroku (t)
-    for (int t = 0; t < check_duration; t++) 
-    {
-        int current_human_loc;
-        if (t < (int)human_path_locations.size()) {
-            current_human_loc = human_path_locations[t];
+        const std::string human_label = timeline.size() > 1 ? "Human " + std::to_string(human) : std::string("Human");
+        if (failed_steps.empty()) {
+            std::cout << human_label << " has path to exit" << std::endl;
         } else {
-            current_human_loc = human_path_locations.back(); // Člověk čeká v cíli
-        }
-        if (current_human_loc == safety_exit_location) continue;
-
-        bool safe = safety_planner->check_reachability(current_human_loc, safety_exit_location, t);
-
-        if (!safe) {
-            failed_steps.push_back(t);
+            std::cout << human_label << " has no path to exit at: ";
+            for (size_t i = 0; i < failed_steps.size(); i++) {
+                std::cout << failed_steps[i] << (i < failed_steps.size() - 1 ? "," : "");
+            }
+            std::cout << " steps" << std::endl;
         }
     }
-
-    // 4. Výpis výsledku
-    if (failed_steps.empty()) {
-        std::cout << "Human has path to exit" << std::endl;
-    } else {
-        std::cout << "Human has no path to exit at: ";
-        for (size_t i = 0; i < failed_steps.size(); i++) {
-            std::cout << failed_steps[i] << (i < failed_steps.size() - 1 ? "," : "");
-        }
-        std::cout << " steps" << std::endl;
-    }
-
-    // Úklid
-    //planner->safe_interval_table.reset();
 }
@@ -13,7 +13,7 @@
 auto Map::find_neighbors(const int loc) const -> std::vector<int>
 {
   assertm(loaded, "Map not loaded.");
-  assertm(is_in(loc) && index(loc) == 0, "Invalid position.");
+  assertm(is_in(loc) && index(loc) != 1, "Invalid position.");
   const std::array<int, 4> neighbors_rel = {-width, -1, 1, width};
   std::vector<int>         ret;
   for (const auto& neigh_rel : neighbors_rel)
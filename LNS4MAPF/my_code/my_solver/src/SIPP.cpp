@@ -126,7 +126,7 @@ void NodePool::merge_extra()
   end = 0;
 }
 
-auto SIPP::plan(int agent_num, const std::unordered_set<int>& already_planned) -> TimePointPath
+auto SIPP::plan(int agent_num, const std::unordered_set<int>& already_planned, int max_arrival) -> TimePointPath
 {
   // reset vector of blocked counts
   // if (settings.generate_blocked)
@@ -137,37 +137,55 @@ auto SIPP::plan(int agent_num, const std::unordered_set<int>& already_planned) -
   if (settings.implementation == SIPP_implementation::SIPP_suboptimal)
   {
     // suboptimal sipp
-    return plan_suboptimal(agent_num, already_planned, settings.w, false);
+    return plan_suboptimal(agent_num, already_planned, settings.w, false, max_arrival);
   }
 
   if (settings.implementation == SIPP_implementation::SIPP_suboptimal_ap)
   {
     // suboptimal sipp
-    return plan_suboptimal(agent_num, already_planned, settings.w, true);
+    return plan_suboptimal(agent_num, already_planned, settings.w, true, max_arrival);
   }
 
   assertm(settings.w == 1.0, "Suboptimality factor must be 1 for optimal algorithms.");
   // optimal sipp
   if (settings.implementation == SIPP_implementation::SIPP_mine)
   {
-    return plan_sipp_mine(agent_num);
+    return plan_sipp_mine(agent_num, max_arrival);
   }
 
   if (settings.implementation == SIPP_implementation::SIPP_mine_ap)
   {
-    return plan_sipp_mine_ap(agent_num, already_planned);
+    return plan_sipp_mine_ap(agent_num, already_planned, max_arrival);
   }
 
   if (settings.implementation == SIPP_implementation::SIPP_mapf_lns)
   {
-    return plan_mapflns_heuristic(agent_num);
+    return plan_mapflns_heuristic(agent_num, max_arrival);
   }
 
   throw std::runtime_error("Unknown SIPP implementation");
 }
 
-auto SIPP::plan_sipp_mine(const int agent_num) -> TimePointPath
+auto SIPP::is_goal_reachable(int goal, int min_time, int max_time, int max_arrival) -> bool
 {
+  const int first_free_time = safe_interval_table.get_first_free_time(goal);
+  if (safe_interval_table.is_permanently_occupied(goal) || first_free_time > max_time)
+  {
+    return false;
+  }
+  if (first_free_time > max_arrival || min_time > max_arrival)
+  {
+    bound_pruned = true;
+    return false;
+  }
+  return true;
+}
+
+template <typename Intervals>
+auto SIPP::search_sipp_mine(const int agent_num, const int max_arrival, const Intervals& intervals) -> TimePointPath
+{
+  bound_pruned = false;
+
   if (settings.info_type != INFO_type::no_info)
   {
     initialize_iter_info();
@@ -187,11 +205,17 @@ auto SIPP::plan_sipp_mine(const int agent_num) -> TimePointPath
   const int max_time = safe_interval_table.get_max_path_len_estimate();
   assertm(min_time >= 0 && max_time >= 0, "Time can not be negative.");
 
+  // the goal can not be reached if another agent rests there, if it becomes free too late or after the arrival bound
+  if (!is_goal_reachable(goal, min_time, max_time, max_arrival))
+  {
+    return TimePointPath();
+  }
+
   // create openlist
   sipp::PriorityQueue open_list{SIPPNodeComparator(&rnd_generator)};
 
   // retrieve the first safe interval
-  auto time_interval_start = safe_interval_table.get_first_safe_interval(start);
+  auto time_interval_start = intervals.get_first_safe_interval(start);
 
   // calculate the heuristic of the start node
   {
@@ -278,7 +302,7 @@ auto SIPP::plan_sipp_mine(const int agent_num) -> TimePointPath
 
       // retrieve the safe intervals for the neighbor
 
-      auto [sf_start, sf_end] = safe_interval_table.get_safe_intervals(neighbor, neighbor_entry_time_interval);
+      auto [sf_start, sf_end] = intervals.get_safe_intervals(neighbor, neighbor_entry_time_interval);
 
       for (auto it = sf_start; it != sf_end; it++)
       {
@@ -296,6 +320,13 @@ auto SIPP::plan_sipp_mine(const int agent_num) -> TimePointPath
           continue;
         }
 
+        // skip intervals, from which the goal can not be reached within the arrival bound
+        if (neighbor_time_point.interval.t_min + instance.get_heuristic_distance(agent_num, neighbor) > max_arrival)
+        {
+          bound_pruned = true;
+          continue;
+        }
+
         // check edge collision
         if (safe_interval_table.edge_constraint_table.get(neighbor_time_point.location, current->time_point.location,
                                                           neighbor_time_point.interval.t_min))
@@ -352,9 +383,19 @@ auto SIPP::plan_sipp_mine(const int agent_num) -> TimePointPath
   return TimePointPath();
 }
 
+auto SIPP::plan_sipp_mine(const int agent_num, const int max_arrival) -> TimePointPath
+{
+  // the storage of the safe intervals is chosen once for the whole search
+  return safe_interval_table.visit([&](const auto& intervals) { return search_sipp_mine(agent_num, max_arrival, intervals); });
+}
 
-auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>& already_planned) -> TimePointPath
+
+template <typename Intervals>
+auto SIPP::search_sipp_mine_ap(const int agent_num, const std::unordered_set<int>& already_planned, const int max_arrival,
+                               const Intervals& intervals) -> TimePointPath
 {
+  bound_pruned = false;
+
   assertm(already_planned.find(agent_num) == already_planned.end(), "Planning agent that was already planned.");
 
   if (settings.info_type != INFO_type::no_info)
@@ -376,6 +417,12 @@ auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>&
   const int max_time = safe_interval_table.get_max_path_len_estimate();
   assertm(min_time >= 0 && max_time >= 0, "Time can not be negative.");
 
+  // the goal can not be reached if another agent rests there, if it becomes free too late or after the arrival bound
+  if (!is_goal_reachable(goal, min_time, max_time, max_arrival))
+  {
+    return TimePointPath();
+  }
+
   // std::cout << "Agent: " << agent_num << ", min time: " << min_time << std::endl;
   // std::cout << "Min time estimate is: " << min_time << std::endl;
   // std::cout << "Max time estimate is: " << max_time << std::endl;
@@ -385,7 +432,7 @@ auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>&
   sipp::PriorityQueue open_list{SIPPNodeComparator(&rnd_generator)};
 
   // retrieve the first safe interval
-  auto time_interval_start = safe_interval_table.get_first_safe_interval(start);
+  auto time_interval_start = intervals.get_first_safe_interval(start);
 
   // calculate the heuristic of the start node
   {
@@ -472,7 +519,7 @@ auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>&
 
       // retrieve the safe intervals for the neighbor
 
-      auto [sf_start, sf_end] = safe_interval_table.get_safe_intervals(neighbor, neighbor_entry_time_interval);
+      auto [sf_start, sf_end] = intervals.get_safe_intervals(neighbor, neighbor_entry_time_interval);
 
       for (auto it = sf_start; it != sf_end; it++)
       {
@@ -490,6 +537,13 @@ auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>&
           continue;
         }
 
+        // skip intervals, from which the goal can not be reached within the arrival bound
+        if (neighbor_time_point.interval.t_min + instance.get_heuristic_distance(agent_num, neighbor) > max_arrival)
+        {
+          bound_pruned = true;
+          continue;
+        }
+
         // check edge collision
         if (safe_interval_table.edge_constraint_table.get(neighbor_time_point.location, current->time_point.location,
                                                           neighbor_time_point.interval.t_min))
@@ -547,9 +601,20 @@ auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>&
   return TimePointPath();
 }
 
+auto SIPP::plan_sipp_mine_ap(const int agent_num, const std::unordered_set<int>& already_planned, const int max_arrival) -> TimePointPath
+{
+  // the storage of the safe intervals is chosen once for the whole search
+  return safe_interval_table.visit([&](const auto& intervals)
+                                   { return search_sipp_mine_ap(agent_num, already_planned, max_arrival, intervals); });
+}
 
-auto SIPP::plan_suboptimal(const int agent_num, const std::unordered_set<int>& already_planned, double w, bool ap) -> TimePointPath
+
+template <typename Intervals>
+auto SIPP::search_suboptimal(const int agent_num, const std::unordered_set<int>& already_planned, double w, bool ap, const int max_arrival,
+                             const Intervals& intervals) -> TimePointPath
 {
+  bound_pruned = false;
+
   assertm(w >= 1.0, "Suboptimality factor must be more than 1");
   assertm(already_planned.find(agent_num) == already_planned.end(), "Planning agent that was already planned.");
 
@@ -577,11 +642,17 @@ auto SIPP::plan_suboptimal(const int agent_num, const std::unordered_set<int>& a
   const int max_time = safe_interval_table.get_max_path_len_estimate();
   assertm(min_time >= 0 && max_time >= 0, "Time can not be negative.");
 
+  // the goal can not be reached if another agent rests there, if it becomes free too late or after the arrival bound
+  if (!is_goal_reachable(goal, min_time, max_time, max_arrival))
+  {
+    return TimePointPath();
+  }
+
   // create openlist
   sipp::PriorityQueueSuboptimal open_list{SIPPNodeComparatorSuboptimal(&rnd_generator, suboptimality_absolute)};
 
   // retrieve the first safe interval
-  auto time_interval_start = safe_interval_table.get_first_safe_interval(start);
+  auto time_interval_start = intervals.get_first_safe_interval(start);
 
   // calculate the heuristic of the start node
   {
@@ -677,7 +748,7 @@ auto SIPP::plan_suboptimal(const int agent_num, const std::unordered_set<int>& a
         }
       }
       // retrieve the safe intervals for the neighbor
-      auto [sf_start, sf_end] = safe_interval_table.get_safe_intervals(neighbor, neighbor_entry_time_interval);
+      auto [sf_start, sf_end] = intervals.get_safe_intervals(neighbor, neighbor_entry_time_interval);
 
       for (auto it = sf_start; it != sf_end; it++)
       {
@@ -695,6 +766,13 @@ auto SIPP::plan_suboptimal(const int agent_num, const std::unordered_set<int>& a
           continue;
         }
 
+        // skip intervals, from which the goal can not be reached within the arrival bound
+        if (neighbor_time_point.interval.t_min + instance.get_heuristic_distance(agent_num, neighbor) > max_arrival)
+        {
+          bound_pruned = true;
+          continue;
+        }
+
         // check edge collision
         if (safe_interval_table.edge_constraint_table.get(neighbor_time_point.location, current->time_point.location,
                                                           neighbor_time_point.interval.t_min))
@@ -748,9 +826,20 @@ auto SIPP::plan_suboptimal(const int agent_num, const std::unordered_set<int>& a
   return TimePointPath();
 }
 
+auto SIPP::plan_suboptimal(const int agent_num, const std::unordered_set<int>& already_planned, double w, bool ap, const int max_arrival)
+    -> TimePointPath
+{
+  // the storage of the safe intervals is chosen once for the whole search
+  return safe_interval_table.visit([&](const auto& intervals)
+                                   { return search_suboptimal(agent_num, already_planned, w, ap, max_arrival, intervals); });
+}
+
 
-auto SIPP::plan_mapflns_heuristic(int agent_num) -> TimePointPath
+template <typename Intervals>
+auto SIPP::search_mapflns_heuristic(int agent_num, int max_arrival, const Intervals& intervals) -> TimePointPath
 {
+  bound_pruned = false;
+
   if (settings.info_type != INFO_type::no_info)
   {
     initialize_iter_info();
@@ -769,11 +858,17 @@ auto SIPP::plan_mapflns_heuristic(int agent_num) -> TimePointPath
   const int max_time = safe_interval_table.get_max_path_len_estimate();
   assertm(min_time >= 0 && max_time >= 0, "Time can not be negative.");
 
+  // the goal can not be reached if another agent rests there, if it becomes free too late or after the arrival bound
+  if (!is_goal_reachable(goal, min_time, max_time, max_arrival))
+  {
+    return TimePointPath();
+  }
+
   // create openlist
   sipp::PriorityQueue open_list{SIPPNodeComparator(&rnd_generator)};
 
   // retrieve the first safe interval
-  auto time_interval_start = safe_interval_table.get_first_safe_interval(start);
+  auto time_interval_start = intervals.get_first_safe_interval(start);
 
   // calculate the heuristic of the start node
   {
@@ -853,8 +948,8 @@ auto SIPP::plan_mapflns_heuristic(int agent_num) -> TimePointPath
 
       // retrieve the safe intervals for the neighbor
 
-      std::list<TimeInterval>::const_iterator sf_start, sf_end;
-      std::tie(sf_start, sf_end) = safe_interval_table.get_safe_intervals(neighbor, neighbor_entry_time_interval);
+      typename Intervals::const_iterator sf_start, sf_end;
+      std::tie(sf_start, sf_end) = intervals.get_safe_intervals(neighbor, neighbor_entry_time_interval);
 
       for (auto it = sf_start; it != sf_end; it++)
       {
@@ -872,6 +967,13 @@ auto SIPP::plan_mapflns_heuristic(int agent_num) -> TimePointPath
           continue;
         }
 
+        // skip intervals, from which the goal can not be reached within the arrival bound
+        if (neighbor_time_point.interval.t_min + instance.get_heuristic_distance(agent_num, neighbor) > max_arrival)
+        {
+          bound_pruned = true;
+          continue;
+        }
+
         // check edge collision
         if (safe_interval_table.edge_constraint_table.get(neighbor_time_point.location, current->time_point.location,
                                                           neighbor_time_point.interval.t_min))
@@ -915,6 +1017,12 @@ auto SIPP::plan_mapflns_heuristic(int agent_num) -> TimePointPath
   return TimePointPath();
 }
 
+auto SIPP::plan_mapflns_heuristic(int agent_num, int max_arrival) -> TimePointPath
+{
+  // the storage of the safe intervals is chosen once for the whole search
+  return safe_interval_table.visit([&](const auto& intervals) { return search_mapflns_heuristic(agent_num, max_arrival, intervals); });
+}
+
 void SIPP::initialize_iter_info()
 {
   generated_this_iter = 0;
@@ -964,117 +1072,6 @@ auto sipp::extract_path(SIPPNode const* const final_node) -> TimePointPath
   return path;
 }
 
-bool SIPP::check_reachability(int start_loc, int goal_loc, int start_time)
-{
-  // 1. Reset pro nové hledání
-  if (settings.info_type != INFO_type::no_info) initialize_iter_info();
-  
-  // 2. Kontrola, zda start/cíl nejsou mimo mapu
-  // Pokud je start ve zdi (1), končíme. Ale pokud je ve dveřích (2), je to OK (to řeší volající funkce, ale pro jistotu)
-  if (!instance.get_map_data().is_in(start_loc) || instance.get_map_data().index(start_loc) == 1) return false;
-  if (!instance.get_map_data().is_in(goal_loc)) return false; // Cíl může být 2, takže nekontrolujeme index(goal) == 1
-
-  // 3. Získání startovního bezpečného intervalu v čase start_time
-  auto interval_pair = safe_interval_table.get_safe_intervals(start_loc, TimeInterval(start_time, start_time));
-      
-  auto interval_it = interval_pair.first;
-  if (interval_it == interval_pair.second) return false;
-  if (interval_it->t_max < start_time) return false;
-
-  // 4. Nastavení Open Listu
-  sipp::PriorityQueue open_list{sipp::SIPPNodeComparator(&rnd_generator)};
-  
-  // -- TOTO JSME PŘIDALI --
-  int map_width = instance.get_map_data().width;
-  int map_height = instance.get_map_data().height;
-  // ----------------------
-
-  // Heuristika
-  int start_y = start_loc / map_width;
-  int start_x = start_loc % map_width;
-  int goal_y = goal_loc / map_width;
-  int goal_x = goal_loc % map_width;
-  double h = std::abs(start_x - goal_x) + std::abs(start_y - goal_y);
-  
-  open_list.push(node_pool.add_node(sipp::SIPPNode(
-      start_loc, *interval_it, start_time, h, h, 0, nullptr)));
-
-  std::fill(known_min.begin(), known_min.end(), INT_MAX);
-  std::fill(known_max.begin(), known_max.end(), -1);
-
-  // 6. Main Loop
-  while (!open_list.empty())
-  {
-    auto current = open_list.top();
-    open_list.pop();
-
-    if (current->time_point.location == goal_loc) {
-        node_pool.merge_extra();
-        return true; 
-    }
-
-    if (current->time_point.interval.t_min >= known_min[current->time_point.location]) continue;
-    known_min[current->time_point.location] = current->time_point.interval.t_min;
-
-    int next_time_min = current->time_point.interval.t_min + 1;
-    int next_time_max = (current->time_point.interval.t_max == INT_MAX) ? INT_MAX : current->time_point.interval.t_max + 1;
-
-    // --- MANUÁLNÍ SOUSEDÉ (TOHLE JE TA KLÍČOVÁ ZMĚNA) ---
-    int curr_loc = current->time_point.location;
-    int cx = curr_loc % map_width;
-    int cy = curr_loc / map_width;
-    
-    int dx[] = {0, 0, 1, -1};
-    int dy[] = {1, -1, 0, 0};
-
-    for (int i = 0; i < 4; i++) {
-        int nx = cx + dx[i];
-        int ny = cy + dy[i];
-
-        if (nx >= 0 && nx < map_width && ny >= 0 && ny < map_height) {
-            int neighbor = ny * map_width + nx;
-
-            // Povolit vstup, pokud je to 0 NEBO pokud je to cíl (2)
-            if (instance.get_map_data().index(neighbor) == 0 || neighbor == goal_loc) 
-            {
-                if (neighbor == goal_loc)
-                {
-                    int n_y = neighbor / map_width;
-                    int n_x = neighbor % map_width;
-                    double h_n = std::abs(n_x - goal_x) + std::abs(n_y - goal_y);
-                    
-                    // Rovnou přidáme do open listu (interval nekonečno)
-                    open_list.push(node_pool.add_node(sipp::SIPPNode(
-                        neighbor, TimeInterval(0, INT_MAX), next_time_min, h_n, h_n, 0, current)));
-                    
-                    continue; 
-                }
-                auto interval_pair = safe_interval_table.get_safe_intervals(
-                    neighbor, TimeInterval(next_time_min, next_time_max));
-                    
-                for (auto it = interval_pair.first; it != interval_pair.second; ++it) {
-                    if (safe_interval_table.edge_constraint_table.get(
-                        current->time_point.location, neighbor, current->time_point.interval.t_min)) continue;
-
-                    int arrival_time = std::max(next_time_min, it->t_min);
-                    if (arrival_time > next_time_max) continue;
-
-                    int n_y = neighbor / map_width;
-                    int n_x = neighbor % map_width;
-                    double h_n = std::abs(n_x - goal_x) + std::abs(n_y - goal_y);
-                    
-                    open_list.push(node_pool.add_node(sipp::SIPPNode(
-                        neighbor, *it, arrival_time, h_n, h_n, 0, current)));
-                }
-            }
-        }
-    }
-  }
-  
-  node_pool.merge_extra();
-  return false;
-}
-
 std::vector<int> SIPP::find_shortest_path(int start_loc, int goal_loc)
 {
   std::vector<int> path_locations;
@@ -1082,26 +1079,18 @@ std::vector<int> SIPP::find_shortest_path(int start_loc, int goal_loc)
   // 1. Validace 
   if (!instance.get_map_data().is_in(start_loc) || !instance.get_map_data().is_in(goal_loc)) return {};
   
-  // Pokud je start ve zdi, vracíme prázdnou cestu (ale pokud je to "2" - dveře, tak to povolíme níže)
-  if (instance.get_map_data().index(start_loc) == 1) return {}; 
+  // Pokud je start nebo cíl ve zdi, vracíme prázdnou cestu (ale pokud je to "2" - dveře, tak to povolíme níže)
+  if (instance.get_map_data().index(start_loc) == 1 || instance.get_map_data().index(goal_loc) == 1) return {}; 
+
+  // Vzdálenosti k cíli bez robotů jsou přesná heuristika, nedosažitelný cíl se nehledá
+  const std::vector<int>& distance = instance.get_exit_distance(goal_loc, exit_distance_buffer);
+  if (distance[start_loc] == -1) return {};
 
   // 2. Setup - Lokální generátor pro determinismus
   std::mt19937 local_generator(0);
   sipp::PriorityQueue open_list{sipp::SIPPNodeComparator(&local_generator)};
 
-  int map_width = instance.get_map_data().width;
-  int map_height = instance.get_map_data().height;
-
-  // Heuristika (Manhattan)
-  auto get_h = [&](int loc) {
-      int y = loc / map_width;
-      int x = loc % map_width;
-      int gy = goal_loc / map_width;
-      int gx = goal_loc % map_width;
-      return (double)(std::abs(x - gx) + std::abs(y - gy));
-  };
-
-  double h = get_h(start_loc);
+  double h = distance[start_loc];
 
   // Vytvoření startovního uzlu
   open_list.push(node_pool.add_node(sipp::SIPPNode(
@@ -1132,33 +1121,19 @@ std::vector<int> SIPP::find_shortest_path(int start_loc, int goal_loc)
     if (current->time_point.interval.t_min >= known_min[current->time_point.location]) continue;
     known_min[current->time_point.location] = current->time_point.interval.t_min;
 
-    // Expanze sousedů - MANUÁLNÍ KONTROLA MÍSTO find_neighbors
+    // Expanze sousedů - předpočítaní sousedé instance, cíl ve dveřích je vedle právě tehdy, když je vzdálenost 1
     int next_time = current->time_point.interval.t_min + 1;
-    
-    int curr_loc = current->time_point.location;
-    int cx = curr_loc % map_width;
-    int cy = curr_loc / map_width;
-    
-    // 4 směry: dolů, nahoru, vpravo, vlevo
-    int dx[] = {0, 0, 1, -1};
-    int dy[] = {1, -1, 0, 0};
-
-    for (int i = 0; i < 4; i++) {
-        int nx = cx + dx[i];
-        int ny = cy + dy[i];
-
-        // Kontrola hranic mapy
-        if (nx >= 0 && nx < map_width && ny >= 0 && ny < map_height) {
-            int neighbor_loc = ny * map_width + nx;
-            
-            if (instance.get_map_data().index(neighbor_loc) == 0 || neighbor_loc == goal_loc) 
-            {
-                double hn = get_h(neighbor_loc);
-                open_list.push(node_pool.add_node(sipp::SIPPNode(
-                    neighbor_loc, TimeInterval(next_time, INT_MAX), next_time, hn, hn, 0, current)));
-            }
-        }
-      }
+    if (distance[current->time_point.location] == 1 && instance.get_map_data().index(goal_loc) != 0)
+    {
+        open_list.push(node_pool.add_node(sipp::SIPPNode(
+            goal_loc, TimeInterval(next_time, INT_MAX), next_time, 0, 0, 0, current)));
+    }
+    for (int neighbor_loc : instance.get_neighbor_locations(current->time_point.location)) {
+        if (distance[neighbor_loc] == -1) continue;
+        double hn = distance[neighbor_loc];
+        open_list.push(node_pool.add_node(sipp::SIPPNode(
+            neighbor_loc, TimeInterval(next_time, INT_MAX), next_time, hn, hn, 0, current)));
+    }
   }
   node_pool.merge_extra();
   return {}; // Cesta nenalezena
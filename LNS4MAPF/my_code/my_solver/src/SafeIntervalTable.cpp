@@ -7,105 +7,68 @@
 
 #include "SafeIntervalTable.h"
 
+#include <algorithm>
 #include <boost/functional/hash.hpp>
 #include <climits>
 #include <iostream>
 
 // TODO implement the parallelized functions
 
-auto EdgeConstraint::operator==(const EdgeConstraint& other) const -> bool
-{
-  return from == other.from && to == other.to && t == other.t;
-}
-
-SafeIntervalTable::SafeIntervalTable(const Instance& instance_)
-    : edge_constraint_table(instance_),
-      instance(instance_),
-      unlimited_safe_intervals(instance_.get_map_data().get_num_free_cells())
-#ifdef SIT_PARALLELIZATION
-      ,
-      locks(instance_.get_num_free_cells())
-#endif
+// removes the time of the constraint from the safe intervals, the constraint can not overlap the other constraints
+template <typename Interval>
+static void subtract_constraint(std::vector<Interval>& intervals, const TimeInterval& constraint)
 {
-  const int num_free_cells = instance.get_num_free_cells();
-
-  // initialize the safe interval vectors, cells with static obstacles dont need safe interval
-  safe_intervals = std::vector<std::list<TimeInterval>>(num_free_cells, std::list<TimeInterval>(1, TimeInterval(0, INT_MAX)));
-}
-
-void SafeIntervalTable::add_constraint(const TimePoint& timepoint)
-{
-  // check the location is valid
-  assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
-
-  // update unlimited safe interval number
-  if (timepoint.interval.t_max == INT_MAX)
-  {
-    unlimited_safe_intervals--;
-    assertm(unlimited_safe_intervals >= 0, "Invalid unlimited safe interval count.");
-  }
-  else
-  {
-    // update latest constraint end
-    latest_constraint_end = std::max(latest_constraint_end, timepoint.interval.t_max);
-  }
-
-  int                      free_location = instance.location_to_free_location(timepoint.location);
-  std::list<TimeInterval>& cur_TI_list   = safe_intervals[free_location];
-
   // modify intervals that have some intersections with the time range
-  auto it = cur_TI_list.begin();
-  while (it != cur_TI_list.end())
+  auto it = intervals.begin();
+  while (it != intervals.end())
   {
+    const int t_min = it->get_t_min();
+    const int t_max = it->get_t_max();
+
     // skip irrelevant time intervals
-    if (it->t_max < timepoint.interval.t_min)
+    if (t_max < constraint.t_min)
     {
       it++;
       continue;
     }
 
     // check that there are still intervals that could be reduced
-    assertm(it->t_min <= timepoint.interval.t_max, "Can not add an overlapping constraint.");
+    assertm(t_min <= constraint.t_max, "Can not add an overlapping constraint.");
 
     // shorten intervals starting before the range
-    if (it->t_min < timepoint.interval.t_min)
+    if (t_min < constraint.t_min)
     {
-      assertm(it->t_max >= timepoint.interval.t_max, "Can not add an overlapping constraint.");
-      const int new_tmax = timepoint.interval.t_min - 1;
+      assertm(t_max >= constraint.t_max, "Can not add an overlapping constraint.");
+      it->set_t_max(constraint.t_min - 1);
 
       // create new interval if there is still some time in the safe interval after the constraint
-      if (it->t_max > timepoint.interval.t_max)
+      if (t_max > constraint.t_max)
       {
-        cur_TI_list.insert(std::next(it, 1), TimeInterval(timepoint.interval.t_max + 1, it->t_max));
-        it->t_max = new_tmax;
+        intervals.insert(std::next(it, 1), Interval(TimeInterval(constraint.t_max + 1, t_max)));
         break;
       }
-      const int tmax = it->t_max;
-
-      it->t_max = new_tmax;
 
       // check whether there might be any other affected intervals
-      if (tmax == timepoint.interval.t_max)
+      if (t_max == constraint.t_max)
       {
         break;
       }
       it++;
     }
     // shorten intervals ending after the range
-    else if (it->t_max > timepoint.interval.t_max)
+    else if (t_max > constraint.t_max)
     {
-      assertm(it->t_min == timepoint.interval.t_min, "Can not add an overlapping constraint.");
-      it->t_min = timepoint.interval.t_max + 1;
+      assertm(t_min == constraint.t_min, "Can not add an overlapping constraint.");
+      it->set_t_min(constraint.t_max + 1);
       break;
     }
     // delete intervals that are fully overlapped by the constraint
     else
     {
-      const int tmax = it->t_max;
-      it             = cur_TI_list.erase(it);
+      it = intervals.erase(it);
 
       // check whether there can be any other affected ontervals
-      if (tmax == timepoint.interval.t_max)
+      if (t_max == constraint.t_max)
       {
         break;
       }
@@ -113,93 +76,212 @@ void SafeIntervalTable::add_constraint(const TimePoint& timepoint)
   }
 }
 
-
-void SafeIntervalTable::remove_constraint(const TimePoint& timepoint)
+// returns the time of the constraint to the safe intervals, the neighboring safe intervals are merged
+template <typename Interval>
+static void merge_constraint(std::vector<Interval>& intervals, const TimeInterval& constraint)
 {
-  // check the location is valid
-  assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
-
-  // update unlimited safe interval number
-  if (timepoint.interval.t_max == INT_MAX)
-  {
-    unlimited_safe_intervals++;
-    assertm(unlimited_safe_intervals <= instance.get_map_data().get_num_free_cells(), "Invalid unlimited safe interval count.");
-
-    // update latest constraint done in remove constraints
-  }
-
-  int                      free_location = instance.location_to_free_location(timepoint.location);
-  std::list<TimeInterval>& cur_TI_list   = safe_intervals[free_location];
-
   // check whether there are any safe intervals
-  if (cur_TI_list.empty())
+  if (intervals.empty())
   {
-    cur_TI_list.push_back(timepoint.interval);
+    intervals.emplace_back(constraint);
     return;
   }
 
   // firstly handle constraints after the last safe interval (there is no safe interval after the constraint)
-  assertm(timepoint.interval.t_min != cur_TI_list.back().t_max, "Constraint start overlaps with last safe interval end.");
+  assertm(constraint.t_min != intervals.back().get_t_max(), "Constraint start overlaps with last safe interval end.");
 
-  if (timepoint.interval.t_min > cur_TI_list.back().t_max)
+  if (constraint.t_min > intervals.back().get_t_max())
   {
     // if the last safe interval precedes directly, extend it
-    if (cur_TI_list.back().t_max == timepoint.interval.t_min - 1)
+    if (intervals.back().get_t_max() == constraint.t_min - 1)
     {
-      cur_TI_list.back().t_max = timepoint.interval.t_max;
+      intervals.back().set_t_max(constraint.t_max);
       return;
     }
     // otherwise add a new safe interval
-    cur_TI_list.push_back(timepoint.interval);
+    intervals.emplace_back(constraint);
     return;
   }
 
   // find interval after the constraint
-  auto it = cur_TI_list.begin();
-  while (it != cur_TI_list.end())
+  for (auto it = intervals.begin(); it != intervals.end(); it++)
   {
-    assertm(!overlap(*it, timepoint.interval), "Constraint interval can not have any overlap with safe interval.");
+    assertm(!overlap(it->get_interval(), constraint), "Constraint interval can not have any overlap with safe interval.");
 
     // find the interval after the constraint
-    if (it->t_min > timepoint.interval.t_max)
+    if (it->get_t_min() > constraint.t_max)
     {
       // check whether there was an interval before the constraint
-      if (it != cur_TI_list.begin())
+      if (it != intervals.begin())
       {
         // check whether the previous timeinterval can be extended
         const auto prev = std::prev(it, 1);
-        if (prev->t_max == timepoint.interval.t_min - 1)
+        if (prev->get_t_max() == constraint.t_min - 1)
         {
           // check whether prev should be merged with next interval
-          if (timepoint.interval.t_max != INT_MAX && it->t_min == timepoint.interval.t_max + 1)
+          if (constraint.t_max != INT_MAX && it->get_t_min() == constraint.t_max + 1)
           {
-            prev->t_max = it->t_max;
-            it          = cur_TI_list.erase(it);
+            prev->set_t_max(it->get_t_max());
+            intervals.erase(it);
           }
           else  // extend prev
           {
-            prev->t_max = timepoint.interval.t_max;
+            prev->set_t_max(constraint.t_max);
           }
           return;
         }
       }
 
       // previous can not be extended, check whether next can be extended
-      if (timepoint.interval.t_max != INT_MAX && it->t_min == timepoint.interval.t_max + 1)
+      if (constraint.t_max != INT_MAX && it->get_t_min() == constraint.t_max + 1)
       {
-        it->t_min = timepoint.interval.t_min;
+        it->set_t_min(constraint.t_min);
         return;
       }
 
       // no interval can be extended, therefore insert a new interval
-      cur_TI_list.insert(it, timepoint.interval);
+      intervals.emplace(it, constraint);
       return;
     }
-    it++;
   }
   throw std::runtime_error("Did not remove any constraint.");
 }
 
+auto EdgeConstraint::operator==(const EdgeConstraint& other) const -> bool
+{
+  return from == other.from && to == other.to && t == other.t;
+}
+
+SafeIntervalTable::SafeIntervalTable(const Instance& instance_)
+    : edge_constraint_table(instance_),
+      instance(instance_),
+      unlimited_safe_intervals(instance_.get_map_data().get_num_free_cells())
+#ifdef SIT_PARALLELIZATION
+      ,
+      locks(instance_.get_num_free_cells())
+#endif
+{
+  const int num_free_cells = instance.get_num_free_cells();
+
+  // initialize the safe interval vectors, cells with static obstacles dont need safe interval
+  init_safe_intervals();
+  resting_start = std::vector<int>(num_free_cells, INT_MAX);
+}
+
+void SafeIntervalTable::init_safe_intervals()
+{
+  const int num_free_cells = instance.get_num_free_cells();
+  narrow                   = true;
+  narrow_intervals =
+      std::vector<std::vector<NarrowInterval>>(num_free_cells, std::vector<NarrowInterval>(1, NarrowInterval(TimeInterval(0, INT_MAX))));
+  wide_intervals.clear();
+  wide_intervals.shrink_to_fit();
+}
+
+void SafeIntervalTable::widen_if_needed(const TimeInterval& interval)
+{
+  // the safe interval after the constraint starts one step after its end
+  if (!narrow ||
+      (NarrowInterval::fits(interval) && (interval.t_max == INT_MAX || NarrowInterval::fits_time(interval.t_max + 1))))
+  {
+    return;
+  }
+
+  // move all safe intervals to the 32-bit storage
+  wide_intervals = std::vector<std::vector<WideInterval>>(narrow_intervals.size());
+  for (int i = 0; i < static_cast<int>(narrow_intervals.size()); i++)
+  {
+    wide_intervals[i].reserve(narrow_intervals[i].size());
+    for (const auto& safe_interval : narrow_intervals[i])
+    {
+      wide_intervals[i].emplace_back(safe_interval.get_interval());
+    }
+  }
+  narrow_intervals.clear();
+  narrow_intervals.shrink_to_fit();
+  narrow = false;
+}
+
+void SafeIntervalTable::widen_if_needed(const TimePointPath& path)
+{
+  for (const auto& timepoint : path)
+  {
+    widen_if_needed(timepoint.interval);
+  }
+}
+
+void SafeIntervalTable::add_constraint(const TimePoint& timepoint)
+{
+  // check the location is valid
+  assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
+
+  // update unlimited safe interval number
+  if (timepoint.interval.t_max == INT_MAX)
+  {
+    unlimited_safe_intervals--;
+    assertm(unlimited_safe_intervals >= 0, "Invalid unlimited safe interval count.");
+  }
+  else
+  {
+    // update latest constraint end
+    latest_constraint_end = std::max(latest_constraint_end, timepoint.interval.t_max);
+  }
+
+  const int free_location = instance.location_to_free_location(timepoint.location);
+
+  // remember the agent resting at the location
+  if (timepoint.interval.t_max == INT_MAX)
+  {
+    assertm(resting_start[free_location] == INT_MAX, "Two agents can not rest at the same location.");
+    resting_start[free_location] = timepoint.interval.t_min;
+  }
+
+  widen_if_needed(timepoint.interval);
+  if (narrow)
+  {
+    subtract_constraint(narrow_intervals[free_location], timepoint.interval);
+  }
+  else
+  {
+    subtract_constraint(wide_intervals[free_location], timepoint.interval);
+  }
+}
+
+
+void SafeIntervalTable::remove_constraint(const TimePoint& timepoint)
+{
+  // check the location is valid
+  assertm(instance.get_map_data().is_in(timepoint.location), "Invalid location.");
+
+  // update unlimited safe interval number
+  if (timepoint.interval.t_max == INT_MAX)
+  {
+    unlimited_safe_intervals++;
+    assertm(unlimited_safe_intervals <= instance.get_map_data().get_num_free_cells(), "Invalid unlimited safe interval count.");
+
+    // update latest constraint done in remove constraints
+  }
+
+  const int free_location = instance.location_to_free_location(timepoint.location);
+
+  // the resting agent leaves the location
+  if (timepoint.interval.t_max == INT_MAX)
+  {
+    assertm(resting_start[free_location] == timepoint.interval.t_min, "Removing an agent, which is not resting at the location.");
+    resting_start[free_location] = INT_MAX;
+  }
+
+  widen_if_needed(timepoint.interval);
+  if (narrow)
+  {
+    merge_constraint(narrow_intervals[free_location], timepoint.interval);
+  }
+  else
+  {
+    merge_constraint(wide_intervals[free_location], timepoint.interval);
+  }
+}
+
 void SafeIntervalTable::add_constraints(const TimePointPath& path)
 {
   for (int i = 0; i < (int)path.size(); i++)
@@ -220,6 +302,7 @@ void SafeIntervalTable::add_constraints(const TimePointPath& path)
 #ifdef SIT_PARALLELIZATION
 void SafeIntervalTable::add_constraints_parallel(const TimePointPath& path)
 {
+  widen_if_needed(path);
 #pragma omp parallel for
   for (int i = 0; i < (int)path.size(); i++)
   {
@@ -266,6 +349,7 @@ void SafeIntervalTable::remove_constraints(const TimePointPath& path)
 #ifdef SIT_PARALLELIZATION
 void SafeIntervalTable::remove_constraints_parallel(const TimePointPath& path)
 {
+  widen_if_needed(path);
 #pragma omp parallel for
   for (int i = 0; i < (int)path.size(); i++)
   {
@@ -291,64 +375,54 @@ void SafeIntervalTable::remove_constraints_parallel(const TimePointPath& path)
 }
 #endif
 
-auto SafeIntervalTable::get_first_safe_interval(int location) const -> std::list<TimeInterval>::const_iterator
+auto SafeIntervalTable::get_first_safe_interval(int location) const -> const_iterator
 {
-  // check the location is valid
-  assertm(instance.get_map_data().is_in(location), "Invalid location.");
-
-  int                            free_location = instance.location_to_free_location(location);
-  const std::list<TimeInterval>& cur_TI_list   = safe_intervals[free_location];
-
-  // there is no safe interval
-  if (cur_TI_list.empty())
-  {
-    return cur_TI_list.cend();
-  }
-
-  return cur_TI_list.cbegin();
+  // the first iterator equals the end if there is no safe interval
+  return visit([location](const auto& view) { return const_iterator(view.get_first_safe_interval(location).base()); });
 }
 
 auto SafeIntervalTable::get_safe_intervals(int location, const TimeInterval& time_interval) const
-    -> std::pair<std::list<TimeInterval>::const_iterator, std::list<TimeInterval>::const_iterator>
+    -> std::pair<const_iterator, const_iterator>
 {
-  // this implementation does not check edge collisions, so they must be handled elsewhere.
-  assertm(instance.get_map_data().is_in(location), "Invalid location.");
-  int free_location = instance.location_to_free_location(location);
-  assertm(free_location < static_cast<int>(safe_intervals.size()), "Safe intervals not precomputed for this location.");
-
-  // iterate over the list to find the first and last safe interval
-  auto start = safe_intervals[free_location].cend();
-  auto end   = safe_intervals[free_location].cend();
-  for (auto it = safe_intervals[free_location].cbegin(); it != safe_intervals[free_location].cend(); it++)
-  {
-    // std::cout << "Interval: " << it->t_min << " " << it->t_max << std::endl;
-    // check whether the interval is inside the given time range
-    if (it->t_max >= time_interval.t_min && it->t_min <= time_interval.t_max)
-    {
-      // remember the first interval in the range
-      if (start == safe_intervals[free_location].end())
+  return visit(
+      [location, &time_interval](const auto& view)
       {
-        start = it;
-      }
-    }
-    // if the interval is not inside the time range, check whether already found some intervals
-    else if (start != safe_intervals[free_location].cend())
-    {
-      // if already found some intervals, return the found safe intervals
-      end = it;
-      return std::make_pair(start, end);
-    }
-  }
-  return std::make_pair(start, end);
+        auto [start, end] = view.get_safe_intervals(location, time_interval);
+        return std::make_pair(const_iterator(start.base()), const_iterator(end.base()));
+      });
+}
+
+auto SafeIntervalTable::is_path_free(const TimePointPath& path) const -> bool
+{
+  return visit(
+      [this, &path](const auto& view)
+      {
+        for (int i = 0; i < static_cast<int>(path.size()); i++)
+        {
+          // the whole interval of the time point must lie in a single safe interval
+          auto [sf_start, sf_end] = view.get_safe_intervals(path[i].location, path[i].interval);
+          if (sf_start == sf_end || sf_start->t_min > path[i].interval.t_min || sf_start->t_max < path[i].interval.t_max)
+          {
+            return false;
+          }
+
+          // the edge can not be used in the opposite direction at the same time
+          if (i > 0 && edge_constraint_table.get(path[i].location, path[i - 1].location, path[i].interval.t_min))
+          {
+            return false;
+          }
+        }
+        return true;
+      });
 }
 
 void SafeIntervalTable::update_latest_constraint_end_estimate()
 {
   latest_constraint_end = 0;
   // TODO iterate only for last intervals
-  for (const auto& safe_interval_list : safe_intervals)
+  for (int i = 0; i < instance.get_num_free_cells(); i++)
   {
-    const auto last = safe_interval_list.back();
+    const TimeInterval last = get_last_interval(i);
 
     // safe interval reaches the end
     if (last.t_max == INT_MAX)
@@ -0,0 +1,729 @@
+/*
+ * Description: Safety checker keeping the robot reservations of the human safety check between the LNS iterations.
+ */
+
+#include "SafetyChecker.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <fstream>
+#include <functional>
+#include <tuple>
+#include <unordered_map>
+
+SafetyChecker::SafetyChecker(const Instance& instance_, int num_threads_)
+    : instance(instance_), num_threads(std::max(num_threads_, 1)), safe_interval_table(instance_)
+{
+}
+
+void SafetyChecker::build(const std::vector<TimePointPath>& paths)
+{
+  safe_interval_table.reset();
+  for (const auto& path : paths)
+  {
+    if (!path.empty())
+    {
+      safe_interval_table.add_constraints(path);
+    }
+  }
+  staged             = false;
+  has_committed_safe = false;
+  has_staged_safe    = false;
+}
+
+void SafetyChecker::stage(const SolutionOverlay& overlay)
+{
+  assertm(!staged, "The previous delta has to be committed or rolled back first.");
+  assertm(overlay.feasible, "Can not stage an infeasible overlay.");
+
+  // the new paths may collide with the old ones, so all old paths are removed first
+  const Solution& base = overlay.get_base();
+  for (int agent : overlay.destroyed_paths)
+  {
+    safe_interval_table.remove_constraints(base.paths[agent]);
+  }
+  for (const auto& path : overlay.new_paths)
+  {
+    safe_interval_table.add_constraints(path);
+  }
+  staged = true;
+
+  // the changed regions decide, which kept results are still valid
+  staged_regions.clear();
+  for (int i = 0; i < static_cast<int>(overlay.destroyed_paths.size()); i++)
+  {
+    add_changed_region(base.paths[overlay.destroyed_paths[i]], overlay.new_paths[i]);
+  }
+  has_staged_safe = false;
+}
+
+void SafetyChecker::commit()
+{
+  assertm(staged, "No delta is staged.");
+  staged = false;
+
+  // the results of the staged reservations become the committed ones
+  committed_safe.swap(staged_safe);
+  has_committed_safe = has_staged_safe;
+  has_staged_safe    = false;
+}
+
+void SafetyChecker::rollback(const SolutionOverlay& overlay)
+{
+  assertm(staged, "No delta is staged.");
+  for (const auto& path : overlay.new_paths)
+  {
+    safe_interval_table.remove_constraints(path);
+  }
+  const Solution& base = overlay.get_base();
+  for (int agent : overlay.destroyed_paths)
+  {
+    safe_interval_table.add_constraints(base.paths[agent]);
+  }
+  staged          = false;
+  has_staged_safe = false;
+}
+
+auto SafetyChecker::get_unsafe_steps(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations,
+                                     int duration, bool stop_at_first) -> std::vector<std::vector<int>>
+{
+  std::vector<std::vector<int>> unsafe_steps(human_paths.size());
+  if (exit_locations.empty())
+  {
+    return unsafe_steps;
+  }
+
+  // all steps up to the first unsafe one are evaluated
+  const std::vector<std::vector<char>> safe = evaluate_steps(human_paths, exit_locations, duration, stop_at_first);
+  for (size_t human = 0; human < human_paths.size(); human++)
+  {
+    for (int t = 0; t < static_cast<int>(safe[human].size()); t++)
+    {
+      assertm(safe[human][t] != STEP_UNKNOWN, "A step before the first unsafe step was skipped.");
+      if (safe[human][t] == STEP_UNSAFE)
+      {
+        unsafe_steps[human].push_back(t);
+        if (stop_at_first)
+        {
+          return unsafe_steps;
+        }
+      }
+    }
+  }
+  return unsafe_steps;
+}
+
+auto SafetyChecker::is_safe(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration) -> bool
+{
+  const auto unsafe_steps = get_unsafe_steps(human_paths, exit_locations, duration, true);
+  return std::all_of(unsafe_steps.begin(), unsafe_steps.end(), [](const std::vector<int>& steps) { return steps.empty(); });
+}
+
+auto SafetyChecker::evaluate_steps(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration,
+                                   bool stop_at_first) -> std::vector<std::vector<char>>
+{
+  set_exits(exit_locations);
+
+  // the kept results are valid only for the same humans and exits, the extra steps of a longer duration are evaluated
+  const bool reusable = has_committed_safe && human_paths == cached_human_paths && exit_locations == cached_exits;
+  if (!reusable)
+  {
+    has_committed_safe = false;
+    cached_human_paths = human_paths;
+    cached_exits       = exit_locations;
+  }
+  std::vector<std::vector<char>>   safe(human_paths.size());
+  std::vector<std::pair<int, int>> influenced;  // (human, step)
+  int first_skipped = INT_MAX;  // the influenced steps from this index on follow an unsafe step, they are skipped if stop_at_first is set
+  for (size_t human = 0; human < human_paths.size(); human++)
+  {
+    const std::vector<int>& human_path = human_paths[human];
+    if (human_path.empty())
+    {
+      continue;
+    }
+    safe[human].resize(std::max(duration, 0), STEP_UNKNOWN);
+    for (int t = 0; t < duration; t++)
+    {
+      const int human_location = t < static_cast<int>(human_path.size()) ? human_path[t] : human_path.back();
+      if (reusable && t < static_cast<int>(committed_safe[human].size()) && committed_safe[human][t] != STEP_UNKNOWN &&
+          !(staged && is_influenced(human_location, t)))
+      {
+        safe[human][t] = committed_safe[human][t];
+        if (stop_at_first && safe[human][t] == STEP_UNSAFE)
+        {
+          first_skipped = std::min(first_skipped, static_cast<int>(influenced.size()));
+        }
+      }
+      else
+      {
+        influenced.emplace_back(human, t);
+      }
+    }
+  }
+  const int num_influenced = std::min(static_cast<int>(influenced.size()), first_skipped);
+
+  // a few influenced steps are searched one by one, otherwise a single sweep serves all of them
+  const bool use_sweep = num_influenced > MAX_SEARCHED_STEPS;
+  if (use_sweep)
+  {
+    compute_escape_times();
+  }
+  else if (num_influenced > 0)
+  {
+    compute_exit_distance();
+  }
+  auto location_at = [&human_paths](int human, int t)
+  {
+    const std::vector<int>& human_path = human_paths[human];
+    return t < static_cast<int>(human_path.size()) ? human_path[t] : human_path.back();
+  };
+  if (use_sweep)
+  {
+    // the lookups are cheap, so they are not split between threads
+    for (int i = 0; i < num_influenced; i++)
+    {
+      const auto [human, t]     = influenced[i];
+      const int  human_location = location_at(human, t);
+      if (is_exit[human_location])
+      {
+        safe[human][t] = STEP_SAFE;
+      }
+      else
+      {
+        // the step is safe, if it lies in a safe interval, which can be left towards the exit at the time or later
+        const int interval = find_interval(human_location, t);
+        safe[human][t]     = interval != -1 && escape_time[interval] >= t ? STEP_SAFE : STEP_UNSAFE;
+      }
+      if (stop_at_first && safe[human][t] == STEP_UNSAFE)
+      {
+        break;
+      }
+    }
+  }
+  else
+  {
+    // the searches only read the reservations and the distances, an unsafe step cancels the searches of the later steps
+    std::atomic<int> cancelled_from(num_influenced);
+    safe_interval_table.visit(
+        [&](const auto& intervals)
+        {
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1 && num_influenced > 1) schedule(dynamic, 1)
+          for (int i = 0; i < num_influenced; i++)
+          {
+            if (i >= cancelled_from.load(std::memory_order_relaxed))
+            {
+              continue;
+            }
+            const auto [human, t]     = influenced[i];
+            const int  human_location = location_at(human, t);
+            safe[human][t] = is_exit[human_location] || can_escape(intervals, human_location, t) ? STEP_SAFE : STEP_UNSAFE;
+            if (stop_at_first && safe[human][t] == STEP_UNSAFE)
+            {
+              int cancelled = cancelled_from.load(std::memory_order_relaxed);
+              while (i + 1 < cancelled && !cancelled_from.compare_exchange_weak(cancelled, i + 1, std::memory_order_relaxed))
+              {
+              }
+            }
+          }
+        });
+  }
+
+  // keep the results for the reservations they were computed for
+  if (staged)
+  {
+    staged_safe     = safe;
+    has_staged_safe = true;
+  }
+  else
+  {
+    committed_safe     = safe;
+    has_committed_safe = true;
+  }
+  return safe;
+}
+
+void SafetyChecker::add_changed_region(const TimePointPath& old_path, const TimePointPath& new_path)
+{
+  // the paths are compared step by step, the robots stay at the ends of their paths
+  const Path old_steps = timepointpath_to_path(old_path);
+  const Path new_steps = timepointpath_to_path(new_path);
+  const int  length    = static_cast<int>(std::max(old_steps.size(), new_steps.size()));
+  auto       at        = [](const Path& steps, int t) { return steps.empty() ? -1 : steps[std::min(t, static_cast<int>(steps.size()) - 1)]; };
+  int        first     = -1;
+  int        last      = -1;
+  for (int t = 0; t < length; t++)
+  {
+    if (at(old_steps, t) != at(new_steps, t))
+    {
+      first = first == -1 ? t : first;
+      last  = t;
+    }
+  }
+  if (first == -1)
+  {
+    return;
+  }
+
+  // the moves into the first and out of the last changed step change the edge constraints too
+  const Map&    map_data = instance.get_map_data();
+  ChangedRegion region{last + 1, map_data.width, -1, map_data.height, -1};
+  if (at(old_steps, length) != at(new_steps, length))
+  {
+    region.t_max = INT_MAX;
+  }
+  for (int t = std::max(first - 1, 0); t <= last + 1; t++)
+  {
+    for (int location : {at(old_steps, t), at(new_steps, t)})
+    {
+      if (location != -1)
+      {
+        region.x_min = std::min(region.x_min, location % map_data.width);
+        region.x_max = std::max(region.x_max, location % map_data.width);
+        region.y_min = std::min(region.y_min, location / map_data.width);
+        region.y_max = std::max(region.y_max, location / map_data.width);
+      }
+    }
+  }
+  staged_regions.push_back(region);
+}
+
+auto SafetyChecker::is_influenced(int location, int time) const -> bool
+{
+  // the human needs at least the Manhattan distance of timesteps to reach a changed cell, one more for the edges
+  const int x = location % instance.get_map_data().width;
+  const int y = location / instance.get_map_data().width;
+  for (const auto& region : staged_regions)
+  {
+    const int distance = std::max({0, region.x_min - x, x - region.x_max}) + std::max({0, region.y_min - y, y - region.y_max});
+    if (time - 1 <= region.t_max - distance)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Intervals>
+auto SafetyChecker::can_escape(const Intervals& intervals, int location, int time) const -> bool
+{
+  if (instance.get_map_data().index(location) != 0 || exit_distance[location] == INT_MAX)
+  {
+    return false;
+  }
+  auto [first, last] = intervals.get_safe_intervals(location, {time, time});
+  if (first == last || first->t_min > time || first->t_max < time)
+  {
+    return false;
+  }
+
+  // the safe intervals are identified by their locations and ends, the earliest arrival to each of them is kept
+  auto key = [](int cell, int t_max) { return (static_cast<long long>(cell) << 32) | static_cast<unsigned int>(t_max); };
+  std::unordered_map<long long, int> arrival_time;
+  using SearchNode = std::tuple<int, int, int, int>;  // (estimated arrival to the exit, arrival, location, end of the interval)
+  std::priority_queue<SearchNode, std::vector<SearchNode>, std::greater<>> open;
+  arrival_time[key(location, first->t_max)] = time;
+  open.emplace(time + exit_distance[location], time, location, first->t_max);
+  while (!open.empty())
+  {
+    auto [estimate, arrival, location_from, t_max] = open.top();
+    open.pop();
+    if (arrival > arrival_time[key(location_from, t_max)])
+    {
+      continue;
+    }
+    for (int neighbor : get_adjacent_locations(location_from))
+    {
+      if (is_exit[neighbor])
+      {
+        if (get_earliest_departure(location_from, neighbor, arrival, t_max) != UNREACHABLE)
+        {
+          return true;
+        }
+        continue;
+      }
+      if (exit_distance[neighbor] == INT_MAX)
+      {
+        continue;
+      }
+      const int arrival_max = t_max == INT_MAX ? INT_MAX : t_max + 1;
+      auto [next_first, next_last] = intervals.get_safe_intervals(neighbor, {arrival + 1, arrival_max});
+      for (auto it = next_first; it != next_last; it++)
+      {
+        const int earliest  = std::max(arrival + 1, it->t_min) - 1;
+        const int latest    = std::min(t_max, it->t_max == INT_MAX ? INT_MAX : it->t_max - 1);
+        const int departure = earliest <= latest ? get_earliest_departure(location_from, neighbor, earliest, latest) : UNREACHABLE;
+        if (departure == UNREACHABLE)
+        {
+          continue;
+        }
+        auto [known, inserted] = arrival_time.try_emplace(key(neighbor, it->t_max), departure + 1);
+        if (!inserted && known->second <= departure + 1)
+        {
+          continue;
+        }
+        known->second = departure + 1;
+        open.emplace(departure + 1 + exit_distance[neighbor], departure + 1, neighbor, it->t_max);
+      }
+    }
+  }
+  return false;
+}
+
+auto SafetyChecker::get_timeline(const std::vector<std::vector<int>>& human_paths, const std::vector<int>& exit_locations, int duration)
+    -> std::vector<std::vector<SafetyStep>>
+{
+  set_exits(exit_locations);
+  compute_escape_times();
+  std::vector<std::vector<SafetyStep>> timeline(human_paths.size());
+  std::vector<std::pair<int, int>>     steps;  // (human, step)
+  for (size_t human = 0; human < human_paths.size(); human++)
+  {
+    if (!human_paths[human].empty())
+    {
+      timeline[human].resize(std::max(duration, 0));
+      for (int t = 0; t < duration; t++)
+      {
+        steps.emplace_back(human, t);
+      }
+    }
+  }
+
+  // the sweep is only read by the searches, each thread has its own buffer of the arrival times
+  const int num_steps = static_cast<int>(steps.size());
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1)
+  {
+    std::vector<int> arrival_time;
+#pragma omp for schedule(dynamic, 16)
+    for (int i = 0; i < num_steps; i++)
+    {
+      const auto [human, t]              = steps[i];
+      const std::vector<int>& human_path = human_paths[human];
+      SafetyStep&             step       = timeline[human][t];
+      step.location         = t < static_cast<int>(human_path.size()) ? human_path[t] : human_path.back();
+      step.earliest_arrival = is_exit[step.location] ? t : get_earliest_arrival(step.location, t, arrival_time);
+      step.reachable        = step.earliest_arrival != UNREACHABLE;
+    }
+  }
+  return timeline;
+}
+
+auto SafetyChecker::find_interval(int location, int time) const -> int
+{
+  // a human standing in a door, which is not an exit, is not safe
+  if (instance.get_map_data().index(location) != 0)
+  {
+    return -1;
+  }
+  const int  free_location = instance.location_to_free_location(location);
+  const auto first         = interval_start.begin() + interval_offset[free_location];
+  const auto last          = interval_start.begin() + interval_offset[free_location + 1];
+  const auto it            = std::upper_bound(first, last, time);
+  if (it == first)
+  {
+    return -1;
+  }
+  const int interval = static_cast<int>(std::prev(it) - interval_start.begin());
+  return interval_end[interval] >= time ? interval : -1;
+}
+
+auto SafetyChecker::get_earliest_arrival(int location, int time, std::vector<int>& arrival_time) const -> int
+{
+  const int start = find_interval(location, time);
+  if (start == -1 || escape_time[start] < time)
+  {
+    return UNREACHABLE;
+  }
+
+  // the intervals are expanded from the earliest arrival, the arrival to an exit is queued with the interval -1
+  arrival_time.assign(interval_start.size(), INT_MAX);
+  std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>, std::greater<>> open;
+  arrival_time[start] = time;
+  open.emplace(time, start);
+  while (!open.empty())
+  {
+    auto [arrival, interval] = open.top();
+    open.pop();
+    if (interval == -1)
+    {
+      return arrival;
+    }
+    if (arrival > arrival_time[interval])
+    {
+      continue;
+    }
+
+    // no exit can be reached after the escape time of the interval
+    const int location_from = interval_location[interval];
+    const int latest        = escape_time[interval];
+    for (int neighbor : get_adjacent_locations(location_from))
+    {
+      if (is_exit[neighbor])
+      {
+        const int departure = get_earliest_departure(location_from, neighbor, arrival, latest);
+        if (departure != UNREACHABLE)
+        {
+          open.emplace(departure + 1, -1);
+        }
+        continue;
+      }
+      const int free_neighbor = instance.location_to_free_location(neighbor);
+      for (int next = interval_offset[free_neighbor]; next < interval_offset[free_neighbor + 1]; next++)
+      {
+        // the human has to arrive within the next interval and before its escape time
+        const int earliest    = std::max(arrival, interval_start[next] - 1);
+        const int next_latest = std::min({latest, interval_end[next] == INT_MAX ? INT_MAX : interval_end[next] - 1,
+                                          escape_time[next] == INT_MAX ? INT_MAX : escape_time[next] - 1});
+        if (earliest > next_latest)
+        {
+          continue;
+        }
+        const int departure = get_earliest_departure(location_from, neighbor, earliest, next_latest);
+        if (departure != UNREACHABLE && departure + 1 < arrival_time[next])
+        {
+          arrival_time[next] = departure + 1;
+          open.emplace(departure + 1, next);
+        }
+      }
+    }
+  }
+  return UNREACHABLE;
+}
+
+auto SafetyChecker::get_earliest_departure(int from, int to, int earliest, int latest) const -> int
+{
+  // the edge constraints are bounded in time, so the loop ends even for an unbounded departure
+  for (int departure = earliest; departure <= latest; departure++)
+  {
+    if (is_edge_free(from, to, departure + 1))
+    {
+      return departure;
+    }
+  }
+  return UNREACHABLE;
+}
+
+auto SafetyChecker::get_latest_departure(int from, int to, int earliest, int latest) const -> int
+{
+  // the edge constraints are bounded in time, so an unbounded departure is always possible
+  if (latest == INT_MAX)
+  {
+    return INT_MAX;
+  }
+  for (int departure = latest; departure >= earliest; departure--)
+  {
+    if (is_edge_free(from, to, departure + 1))
+    {
+      return departure;
+    }
+  }
+  return UNREACHABLE;
+}
+
+void SafetyChecker::set_exits(const std::vector<int>& exit_locations)
+{
+  if (exit_locations == exits)
+  {
+    return;
+  }
+  for (int exit_location : exits)
+  {
+    is_exit[exit_location] = false;
+  }
+  exits = exit_locations;
+  is_exit.resize(instance.get_map_data().width * instance.get_map_data().height, false);
+  for (int exit_location : exits)
+  {
+    is_exit[exit_location] = true;
+  }
+  exit_distance.clear();
+}
+
+auto SafetyChecker::get_adjacent_locations(int location) const -> std::vector<int>
+{
+  // the exits may be doors, which have no precomputed neighbors
+  const Map&       map_data = instance.get_map_data();
+  std::vector<int> adjacent;
+  const int        x = location % map_data.width;
+  const int        y = location / map_data.width;
+  for (auto [dx, dy] : {std::pair(0, -1), std::pair(-1, 0), std::pair(1, 0), std::pair(0, 1)})
+  {
+    const int nx = x + dx;
+    const int ny = y + dy;
+    if (nx >= 0 && nx < map_data.width && ny >= 0 && ny < map_data.height && can_enter(ny * map_data.width + nx))
+    {
+      adjacent.push_back(ny * map_data.width + nx);
+    }
+  }
+  return adjacent;
+}
+
+void SafetyChecker::compute_escape_times()
+{
+  const Map& map_data       = instance.get_map_data();
+  const int  num_free_cells = instance.get_num_free_cells();
+
+  // flatten the safe intervals, so each of them has an index
+  interval_offset.resize(num_free_cells + 1);
+  interval_location.clear();
+  interval_start.clear();
+  interval_end.clear();
+  safe_interval_table.visit(
+      [&](const auto& intervals)
+      {
+        for (int free_location = 0; free_location < num_free_cells; free_location++)
+        {
+          interval_offset[free_location] = static_cast<int>(interval_start.size());
+          const int location             = instance.free_location_to_location(free_location);
+          if (map_data.index(location) != 0)
+          {
+            continue;  // the doors have no safe intervals
+          }
+          auto [first, last] = intervals.get_safe_intervals(location, {0, INT_MAX});
+          for (auto it = first; it != last; it++)
+          {
+            interval_location.push_back(location);
+            interval_start.push_back(it->t_min);
+            interval_end.push_back(it->t_max);
+          }
+        }
+      });
+  interval_offset[num_free_cells] = static_cast<int>(interval_start.size());
+  escape_time.assign(interval_start.size(), UNREACHABLE);
+
+  // the human can enter only the free cells and the exit, but it can leave any cell (e.g. when it starts in a door)
+
+  // relaxes the intervals of a location, from which the human can move to the target location during the given arrival times
+  auto relax = [&](int location, int target, int arrival_min, int arrival_max)
+  {
+    const int free_location = instance.location_to_free_location(location);
+    for (int interval = interval_offset[free_location]; interval < interval_offset[free_location + 1]; interval++)
+    {
+      const int earliest = std::max(interval_start[interval], arrival_min - 1);
+      const int latest   = arrival_max == INT_MAX ? interval_end[interval] : std::min(interval_end[interval], arrival_max - 1);
+      if (earliest > latest || latest <= escape_time[interval])
+      {
+        continue;
+      }
+      const int departure = get_latest_departure(location, target, earliest, latest);
+      if (departure > escape_time[interval])
+      {
+        escape_time[interval] = departure;
+        if (map_data.index(location) == 0)
+        {
+          sweep_queue.emplace(departure, interval);
+        }
+      }
+    }
+  };
+
+  // the exits can be entered at any time, the sweep starts from all of them at once
+  for (int exit_location : exits)
+  {
+    for (int neighbor : get_adjacent_locations(exit_location))
+    {
+      if (!is_exit[neighbor])
+      {
+        relax(neighbor, exit_location, 0, INT_MAX);
+      }
+    }
+  }
+
+  // the interval with the latest escape time can not be improved anymore, the escape times decrease with each move
+  while (!sweep_queue.empty())
+  {
+    auto [time, interval] = sweep_queue.top();
+    sweep_queue.pop();
+    if (time < escape_time[interval])
+    {
+      continue;
+    }
+    const int location = interval_location[interval];
+    for (int neighbor : instance.get_neighbor_locations(location))
+    {
+      if (!is_exit[neighbor])
+      {
+        relax(neighbor, location, interval_start[interval], time);
+      }
+    }
+  }
+}
+
+void SafetyChecker::compute_exit_distance()
+{
+  if (!exit_distance.empty())
+  {
+    return;
+  }
+
+  // the distances to the nearest exit are the minimum over the distance fields of the instance
+  const Map& map_data = instance.get_map_data();
+  exit_distance.assign(map_data.width * map_data.height, INT_MAX);
+  for (int exit_location : exits)
+  {
+    const std::vector<int>& distance = instance.get_exit_distance(exit_location, distance_buffer);
+    for (size_t location = 0; location < distance.size(); location++)
+    {
+      if (distance[location] != -1)
+      {
+        exit_distance[location] = std::min(exit_distance[location], distance[location]);
+      }
+    }
+  }
+}
+
+auto SafetyChecker::get_escape_route(int location, int time, const std::vector<int>& exit_locations) -> TimePointPath
+{
+  set_exits(exit_locations);
+  compute_exit_distance();
+  TimePointPath route;
+  if (exit_distance[location] == INT_MAX)
+  {
+    return route;
+  }
+
+  // descend the distances to the nearest exit, one move per timestep
+  route.emplace_back(location, TimeInterval(time, time));
+  while (exit_distance[location] > 0)
+  {
+    for (int neighbor : get_adjacent_locations(location))
+    {
+      if (exit_distance[neighbor] == exit_distance[location] - 1)
+      {
+        location = neighbor;
+        break;
+      }
+    }
+    time++;
+    route.emplace_back(location, TimeInterval(time, time));
+  }
+  return route;
+}
+
+void save_safety_timeline(const std::string& filename, const std::vector<std::vector<SafetyStep>>& timeline, const Instance& instance)
+{
+  nlohmann::json humans = nlohmann::json::array();
+  for (size_t human = 0; human < timeline.size(); human++)
+  {
+    nlohmann::json steps = nlohmann::json::array();
+    for (size_t t = 0; t < timeline[human].size(); t++)
+    {
+      const SafetyStep& step = timeline[human][t];
+      const Point2d     pt   = instance.location_to_position(step.location);
+      steps.push_back({{"time", t},
+                       {"x", pt.x},
+                       {"y", pt.y},
+                       {"reachable", step.reachable},
+                       {"earliest_arrival", step.earliest_arrival},
+                       {"blocking_robots", step.blocking_robots}});
+    }
+    humans.push_back({{"human", human}, {"steps", steps}});
+  }
+
+  std::ofstream file(filename);
+  file << nlohmann::json({{"humans", humans}}).dump(4);  // Pretty print
+  file.close();
+}
@@ -8,6 +8,7 @@
 #include "Solver.h"
 
 #include <boost/algorithm/string_regex.hpp>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <unordered_set>
@@ -304,6 +305,7 @@ void Solution::calculate_cost(const Instance& instance)
     sum_of_delays = -1;
     sum_of_costs  = -1;
     makespan      = -1;
+    end_time_count.clear();
     return;
   }
   assertm(feasible, "Can not calculate cost of infeasible solution");
@@ -323,6 +325,44 @@ void Solution::calculate_cost(const Instance& instance)
     assertm(sum_of_costs >= delay && sum_of_costs >= makespan, "Sum of costs should be greater than delay and makespan.");
     delays[i] = delay;
   }
+
+  // histogram of the end times, the makespan is its highest non-empty bin
+  end_time_count.assign(makespan + 1, 0);
+  for (const auto& path : paths)
+  {
+    end_time_count[path.back().interval.t_min]++;
+  }
+}
+
+void Solution::replace_path(int agent, TimePointPath& path, const Instance& instance)
+{
+  assertm(feasible && !end_time_count.empty(), "The cost has to be calculated before the paths are replaced.");
+  assertm(!path.empty(), "Can not replace a path by an empty path.");
+  const int old_end = paths[agent].back().interval.t_min;
+  std::swap(paths[agent], path);
+  const int new_end = paths[agent].back().interval.t_min;
+
+  const int delay = new_end - instance.get_heuristic_distance(agent, instance.get_start_locations()[agent]);
+  assertm(delay >= 0, "Delay can not be negative.");
+  sum_of_costs += new_end - old_end;
+  sum_of_delays += delay - delays[agent];
+  delays[agent] = delay;
+
+  // move the agent to the new bin, the makespan only decreases to the next non-empty bin
+  end_time_count[old_end]--;
+  if (new_end >= static_cast<int>(end_time_count.size()))
+  {
+    end_time_count.resize(new_end + 1, 0);
+  }
+  end_time_count[new_end]++;
+  if (new_end > makespan)
+  {
+    makespan = new_end;
+  }
+  while (end_time_count[makespan] == 0)
+  {
+    makespan--;
+  }
 }
 
 void Solution::convert_paths() const
@@ -334,3 +374,101 @@ void Solution::convert_paths() const
     converted_paths[i] = timepointpath_to_path(paths[i]);
   }
 }
+
+void SolutionOverlay::reset(std::vector<int>& destroyed)
+{
+  destroyed_paths.swap(destroyed);
+  destroyed.clear();
+  new_paths.resize(destroyed_paths.size());
+  for (auto& path : new_paths)
+  {
+    path.clear();
+  }
+  feasible       = false;
+  bound_exceeded = false;
+}
+
+auto SolutionOverlay::get_improvement() const -> int
+{
+  assertm(feasible, "Can not evaluate an infeasible overlay.");
+  int improvement = 0;
+  for (int i = 0; i < static_cast<int>(destroyed_paths.size()); i++)
+  {
+    improvement += base.paths[destroyed_paths[i]].back().interval.t_min - new_paths[i].back().interval.t_min;
+  }
+  return improvement;
+}
+
+auto SolutionOverlay::get_makespan() const -> int
+{
+  assertm(feasible && !base.end_time_count.empty(), "Can not evaluate an infeasible overlay.");
+  int makespan = 0;
+  for (const auto& path : new_paths)
+  {
+    makespan = std::max(makespan, path.back().interval.t_min);
+  }
+
+  // the highest bin of the base solution, which holds an agent that is not replaced
+  for (int end_time = base.makespan; end_time > makespan; end_time--)
+  {
+    int replaced = 0;
+    for (int agent : destroyed_paths)
+    {
+      replaced += static_cast<int>(base.paths[agent].back().interval.t_min == end_time);
+    }
+    if (base.end_time_count[end_time] > replaced)
+    {
+      return end_time;
+    }
+  }
+  return makespan;
+}
+
+void SolutionOverlay::commit(Solution& sol, const Instance& instance)
+{
+  assertm(&sol == &base, "The overlay can be committed only to its base solution.");
+  assertm(feasible, "Can not commit an infeasible overlay.");
+  for (int i = 0; i < static_cast<int>(destroyed_paths.size()); i++)
+  {
+    sol.replace_path(destroyed_paths[i], new_paths[i], instance);
+  }
+}
+
+auto SolutionOverlay::to_solution(const Instance& instance) const -> Solution
+{
+  Solution sol = base;
+  for (int i = 0; i < static_cast<int>(destroyed_paths.size()); i++)
+  {
+    sol.paths[destroyed_paths[i]] = new_paths[i];
+  }
+  sol.destroyed_paths = destroyed_paths;
+  sol.feasible        = feasible;
+  sol.calculate_cost(instance);
+  return sol;
+}
+
+auto SharedSolution::publish(const Solution& sol) -> bool
+{
+  assertm(sol.feasible, "Can not publish an infeasible solution.");
+  if (sol.sum_of_costs >= get_best_cost())
+  {
+    return false;
+  }
+
+  // replace the shared solution, unless a better one was published in the meantime
+  auto candidate = std::make_shared<const Solution>(sol);
+  auto current   = std::atomic_load(&best);
+  while (current == nullptr || candidate->sum_of_costs < current->sum_of_costs)
+  {
+    if (std::atomic_compare_exchange_weak(&best, &current, std::shared_ptr<const Solution>(candidate)))
+    {
+      // lower the cost, a better solution might have been published and stored its cost in the meantime
+      int cost = best_cost.load(std::memory_order_acquire);
+      while (candidate->sum_of_costs < cost && !best_cost.compare_exchange_weak(cost, candidate->sum_of_costs, std::memory_order_acq_rel))
+      {
+      }
+      return true;
+    }
+  }
+  return false;
+}
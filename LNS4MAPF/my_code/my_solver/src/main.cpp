@@ -6,6 +6,7 @@
  */
 
 #include <boost/program_options.hpp>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <fstream> 
@@ -39,16 +40,41 @@ auto main(int argc, char** argv) -> int
       "timeLimit,t", po::value<double>()->default_value(DEFAULT_TIME_LIMIT), "time limit to find the solution, in seconds")(
       "safetyCheck", po::value<bool>()->default_value(false), "Enable safety-aware LNS mode")(
       "humanPath", po::value<std::string>()->default_value(""), "Path to human path file")(
-      "safetyDoor", po::value<int>()->default_value(-1), "Location ID of the safety door")(
+      "safetyDoor", po::value<int>()->default_value(-1), "Location ID of the safety door, all doors of the map are used if not set")(
       "sipp_implementation", po::value<std::string>()->default_value("SIPP_mine"),
       "implementation of SIPP (SIPP_mine, SIPP_mapf_lns, SIPP_suboptimal)")("Restarts,r", po::value<bool>()->default_value(true),
                                                                             "restart the search if no feasible initial solution was found")(
       "destroy_operator", po::value<std::string>()->default_value("ADAPTIVE"),
-      "Destroy operator to be used in LNS (RANDOM, RANDOMWALK, INTERSECTION, ADAPTIVE, RANDOM_CHOOSE, BLOCKED)")(
+      "Destroy operator to be used in LNS (RANDOM, RANDOMWALK, INTERSECTION, SAFETY, ADAPTIVE, RANDOM_CHOOSE, BLOCKED)")(
       "neighborhood_size,n", po::value<int>()->default_value(DEFAULT_NEIGHBORHOOD_SIZE),
       "Size of the neighborhood used by the destroy operator (number of paths to be destroyed)")(
       "humanStartX", po::value<int>()->default_value(-1), "Human Start X coordinate")(
       "humanStartY", po::value<int>()->default_value(-1), "Human Start Y coordinate")(
+      "humanStarts", po::value<std::vector<int>>()->multitoken()->default_value({}, ""),
+      "X Y coordinates of further humans, e.g. --humanStarts 3 4 10 12")(
+      "threads,j", po::value<int>()->default_value(1),
+      "number of LNS workers repairing disjoint neighborhoods in parallel, 1 runs the sequential LNS")(
+      "initial_planners", po::value<int>()->default_value(1),
+      "number of Prioritized Planning orderings racing in parallel for the initial solution")(
+      "bounded_repair", po::value<bool>()->default_value(true),
+      "abort the repair as soon as the replanned neighborhood can not improve the solution, enabled by default, "
+      "pass --bounded_repair=false for the unbounded repair")(
+      "adaptive_neighborhood", po::value<bool>()->default_value(false),
+      "adapt the neighborhood size online, starting from neighborhood_size")(
+      "min_neighborhood_size", po::value<int>()->default_value(2), "lower bound of the adapted neighborhood size")(
+      "max_neighborhood_size", po::value<int>()->default_value(64), "upper bound of the adapted neighborhood size")(
+      "pipelined_destroy", po::value<bool>()->default_value(false),
+      "compute the next neighborhood on a helper thread while the current one is repaired")(
+      "repair_orderings", po::value<int>()->default_value(1),
+      "number of random orderings of each neighborhood repaired in parallel, the best one is kept")(
+      "safety_corridor", po::value<bool>()->default_value(false),
+      "reserve the cells around the human path before the robots are planned, used with safetyCheck")(
+      "safety_corridor_margin", po::value<int>()->default_value(1),
+      "Manhattan distance from the human, up to which the cells of the escape corridor are reserved")(
+      "safety_threads", po::value<int>()->default_value(1),
+      "number of threads evaluating the human safety of the steps in parallel, shared by the solvers of the portfolio")(
+      "portfolio,p", po::value<int>()->default_value(1),
+      "number of LNS solvers with diversified settings run in parallel and sharing the best solution, 1 runs a single solver")(
       "seed,s", po::value<int>()->default_value(-1),
       "seed of the random generators for reproducability, to achieve non reproducible random behavior, use negative value")(
       "output_paths", po::value<std::string>()->default_value(""),
@@ -145,10 +171,50 @@ auto main(int argc, char** argv) -> int
 
   // create LNS settings
   LNS_settings lns_settings = LNS_settings(max_iter, time_limit, destroy_settings, sipp_settings, restarts);
+  lns_settings.threads      = vm["threads"].as<int>();
+  if (lns_settings.threads < 1)
+  {
+    throw std::runtime_error("Invalid number of threads");
+  }
+  lns_settings.initial_planners = vm["initial_planners"].as<int>();
+  if (lns_settings.initial_planners < 1)
+  {
+    throw std::runtime_error("Invalid number of initial planners");
+  }
+  lns_settings.bounded_repair = vm["bounded_repair"].as<bool>();
+  lns_settings.adaptive_neighborhood = vm["adaptive_neighborhood"].as<bool>();
+  lns_settings.min_neighborhood_size = vm["min_neighborhood_size"].as<int>();
+  lns_settings.max_neighborhood_size = vm["max_neighborhood_size"].as<int>();
+  lns_settings.pipelined_destroy     = vm["pipelined_destroy"].as<bool>();
+  lns_settings.repair_orderings      = vm["repair_orderings"].as<int>();
+  if (lns_settings.repair_orderings < 1)
+  {
+    throw std::runtime_error("Invalid number of repair orderings");
+  }
+  lns_settings.safety_corridor        = vm["safety_corridor"].as<bool>();
+  lns_settings.safety_corridor_margin = vm["safety_corridor_margin"].as<int>();
+  if (lns_settings.safety_corridor_margin < 0)
+  {
+    throw std::runtime_error("Invalid safety corridor margin");
+  }
+  lns_settings.safety_threads = vm["safety_threads"].as<int>();
+  if (lns_settings.safety_threads < 1)
+  {
+    throw std::runtime_error("Invalid number of safety threads");
+  }
+  if (lns_settings.min_neighborhood_size < 1 || lns_settings.min_neighborhood_size > lns_settings.max_neighborhood_size)
+  {
+    throw std::runtime_error("Invalid neighborhood size bounds");
+  }
 
 
   // create the computation object
-  Computation computation(*instance, shared_data.get(), lns_settings, seed);
+  const int portfolio_size = vm["portfolio"].as<int>();
+  if (portfolio_size < 1)
+  {
+    throw std::runtime_error("Invalid portfolio size");
+  }
+  Computation computation(*instance, shared_data.get(), lns_settings, seed, portfolio_size);
 
   bool safety_aware = vm["safetyCheck"].as<bool>();
   std::string human_file = vm["humanPath"].as<std::string>();
@@ -156,24 +222,42 @@ auto main(int argc, char** argv) -> int
 
   int h_start_x = vm["humanStartX"].as<int>();
   int h_start_y = vm["humanStartY"].as<int>();
-  int human_start_loc = -1;
+  std::vector<int> human_start_locs;
 
   if (h_start_x != -1 && h_start_y != -1) {
       if (instance->get_map_data().is_in({h_start_x, h_start_y})) {
-           human_start_loc = instance->position_to_location({h_start_x, h_start_y});
+           human_start_locs.push_back(instance->position_to_location({h_start_x, h_start_y}));
       }
   }
 
-  if (safety_door == -1)
+  // the further humans are given as pairs of coordinates
+  const auto& human_starts = vm["humanStarts"].as<std::vector<int>>();
+  if (human_starts.size() % 2 != 0)
+  {
+    throw std::runtime_error("Invalid human start coordinates");
+  }
+  for (size_t i = 0; i < human_starts.size(); i += 2)
+  {
+    if (!instance->get_map_data().is_in({human_starts[i], human_starts[i + 1]}))
+    {
+      throw std::runtime_error("Invalid human start coordinates");
+    }
+    human_start_locs.push_back(instance->position_to_location({human_starts[i], human_starts[i + 1]}));
+  }
+
+  std::vector<int> safety_doors;
+  if (safety_door != -1)
+  {
+    safety_doors.push_back(safety_door);
+  }
+  else
   {
     const auto& map_data = instance->get_map_data();
     for (int i = 0; i < (int)map_data.data.size(); i++)
     {
       if (map_data.data[i] == 2) // Hodnota 2 značí dveře v Map.cpp
       {
-          safety_door = i;
-          // std::cout << "Auto-detected safety door at location: " << i << std::endl;
-          break;
+          safety_doors.push_back(i);
       }
     }
   }
@@ -198,7 +282,7 @@ auto main(int argc, char** argv) -> int
           std::cout << "WARNING: Could not open human path file: " << human_file << std::endl;
       }
   }
-  computation.set_safety_params(safety_aware, human_start_loc, safety_door);
+  computation.set_safety_params(safety_aware, human_start_locs, safety_doors);
 
   // start the computation thread
   computation.start();
@@ -223,6 +307,14 @@ auto main(int argc, char** argv) -> int
   {
     const Solution& sol = computation.get_solution();
     sol.save(output_paths_file, *instance);
+
+    // the safety timeline is saved next to the paths
+    if (safety_aware)
+    {
+      std::filesystem::path timeline_file = output_paths_file;
+      timeline_file.replace_filename(timeline_file.stem().string() + "_safety.json");
+      save_safety_timeline(timeline_file.string(), computation.get_safety_timeline(), *instance);
+    }
   }
 
   return EXIT_SUCCESS;
@@ -4,9 +4,12 @@
  * Email: chlebja3@fel.cvut.cz
  * Description:
  */
-#include <list>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "ConstraintTable.h"
+#include "Instance.h"
 #include "SafeIntervalTable.h"
 #include "utils.h"
 
@@ -14,8 +17,24 @@ auto get_base_path_tests() -> std::string;
 
 auto generate_random_timepointpath(int len) -> TimePointPath;
 
-auto filter_time_intervals(std::pair<std::list<TimeInterval>::const_iterator, std::list<TimeInterval>::const_iterator> start_goal,
+auto filter_time_intervals(std::pair<SafeIntervalTable::const_iterator, SafeIntervalTable::const_iterator> start_goal,
                            TimeInterval interval, int from, int to, SafeIntervalTable& table) -> std::vector<TimeInterval>;
 
 
 auto find_path_distance_gradient(int agent_num, const Instance& instance) -> Path;
+
+/**
+ * @brief Checks that the safe interval table holds exactly the given paths, by comparing it with a table built from them.
+ */
+void expect_tables_match(const Instance& instance, const std::vector<TimePointPath>& paths, const SafeIntervalTable& table);
+
+/**
+ * @brief Checks that the constraint table holds exactly the given paths, by comparing it with a table built from them.
+ */
+void expect_tables_match(const Instance& instance, const std::vector<TimePointPath>& paths, const ConstraintTable& table);
+
+/**
+ * @brief Loads the starts and the goals of the given agents of the scenario, the tests use them as the human starts and the exits.
+ */
+auto load_human_locations(const std::string& map_path, const std::string& scen_path, const std::vector<int>& agents)
+    -> std::pair<std::vector<int>, std::vector<int>>;
@@ -0,0 +1,146 @@
+/*
+ * Description: Benchmarks of building and updating the Constraint Table.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "ConstraintTable.h"
+#include "Instance.h"
+#include "LNS.h"
+#include "test_utils.h"
+
+/**
+ * @brief Shared setup of the Constraint Table benchmarks, the instance and the paths are planned only once.
+ */
+struct ConstraintTableFixture
+{
+  std::unique_ptr<Instance>  instance;
+  std::vector<TimePointPath> paths;
+
+  ConstraintTableFixture(const std::string& map_name, const std::string& scen_name, int num_agents)
+  {
+    std::string base_path = get_base_path_tests();  // path to my_solver
+    instance =
+        std::make_unique<Instance>(base_path + "/tests/test_maps/" + map_name, base_path + "/tests/test_scen/" + scen_name, num_agents);
+
+    // plan the paths by Prioritized Planning
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(0, 5, {DESTROY_TYPE::RANDOM, 10}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+    paths = lns.PrioritizedPlanning().paths;
+  }
+};
+
+// helper function returning the fixture for the given number of agents on den520d
+static auto get_den520d_fixture(int num_agents) -> const ConstraintTableFixture&
+{
+  static std::vector<std::unique_ptr<ConstraintTableFixture>> fixtures;
+  for (const auto& fixture : fixtures)
+  {
+    if (static_cast<int>(fixture->paths.size()) == num_agents)
+    {
+      return *fixture;
+    }
+  }
+  fixtures.push_back(std::make_unique<ConstraintTableFixture>("den520d.map", "den520d-random-0.scen", num_agents));
+  return *fixtures.back();
+}
+
+// Benchmark of building the whole constraint table from a solution
+static void BM_CT_build_den520(benchmark::State& state)
+{
+  const ConstraintTableFixture& fixture = get_den520d_fixture(static_cast<int>(state.range(0)));
+  for (auto _ : state)
+  {
+    ConstraintTable table(*fixture.instance);
+    table.build_sequential(fixture.paths);
+    benchmark::DoNotOptimize(table);
+  }
+}
+BENCHMARK(BM_CT_build_den520)->Arg(100)->Arg(500);
+
+// Benchmark of the updates done in one LNS iteration, i.e. removing and adding back paths of a neighborhood
+static void BM_CT_update_den520(benchmark::State& state)
+{
+  const ConstraintTableFixture& fixture = get_den520d_fixture(static_cast<int>(state.range(0)));
+  const int                     num_agents = static_cast<int>(fixture.paths.size());
+  const int                     neighborhood_size = 8;
+
+  ConstraintTable table(*fixture.instance);
+  table.build_sequential(fixture.paths);
+
+  std::mt19937                       rnd_generator(0);
+  std::uniform_int_distribution<int> distribution(0, num_agents - 1);
+  std::vector<int>                   neighborhood(neighborhood_size);
+  for (auto _ : state)
+  {
+    std::generate(neighborhood.begin(), neighborhood.end(), [&]() { return distribution(rnd_generator); });
+    std::sort(neighborhood.begin(), neighborhood.end());
+    neighborhood.erase(std::unique(neighborhood.begin(), neighborhood.end()), neighborhood.end());
+
+    for (const int agent : neighborhood)
+    {
+      table.remove_constraints(fixture.paths[agent], agent);
+    }
+    for (const int agent : neighborhood)
+    {
+      table.add_constraints(fixture.paths[agent], agent);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * neighborhood_size);
+}
+BENCHMARK(BM_CT_update_den520)->Arg(100)->Arg(500);
+
+// Benchmark of the intersection lookup used by the intersection destroy operator
+static void BM_CT_intersections_den520(benchmark::State& state)
+{
+  const ConstraintTableFixture& fixture = get_den520d_fixture(static_cast<int>(state.range(0)));
+
+  ConstraintTable table(*fixture.instance);
+  table.build_sequential(fixture.paths);
+
+  for (auto _ : state)
+  {
+    int intersections = 0;
+    for (int i = 0; i < fixture.instance->get_num_free_cells(); i++)
+    {
+      if (static_cast<int>(table.get_agents_counts_free(i).size()) >= 3)
+      {
+        intersections++;
+      }
+    }
+    benchmark::DoNotOptimize(intersections);
+  }
+}
+BENCHMARK(BM_CT_intersections_den520)->Arg(100)->Arg(500);
+
+// Benchmark of the point and suffix queries used by the destroy operators
+static void BM_CT_queries_den520(benchmark::State& state)
+{
+  const ConstraintTableFixture& fixture = get_den520d_fixture(static_cast<int>(state.range(0)));
+  const int                     num_agents = static_cast<int>(fixture.paths.size());
+
+  ConstraintTable table(*fixture.instance);
+  table.build_sequential(fixture.paths);
+
+  std::mt19937                       rnd_generator(0);
+  std::uniform_int_distribution<int> agent_distribution(0, num_agents - 1);
+  for (auto _ : state)
+  {
+    // query the locations along a random path, as the random walk and blocked operators do
+    const TimePointPath& path = fixture.paths[agent_distribution(rnd_generator)];
+    for (const auto& timepoint : path)
+    {
+      benchmark::DoNotOptimize(table.get_blocking_agent(timepoint.location, timepoint.location, timepoint.interval.t_min));
+      benchmark::DoNotOptimize(table.get_blocking_agents(timepoint.location, timepoint.interval.t_min));
+    }
+  }
+}
+BENCHMARK(BM_CT_queries_den520)->Arg(100)->Arg(500);
+
+BENCHMARK_MAIN();
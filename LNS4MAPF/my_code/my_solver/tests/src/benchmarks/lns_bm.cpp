@@ -0,0 +1,118 @@
+/*
+ * Description: Benchmarks of the LNS iteration throughput.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+
+#include "Instance.h"
+#include "LNS.h"
+#include "test_utils.h"
+
+// number of heap allocations, counted by the replaced global operator new
+static std::atomic<long> allocation_count{0};
+
+auto operator new(std::size_t size) -> void*
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept
+{
+  std::free(ptr);
+}
+
+// Benchmark of the sequential LNS iterations, reports the number of heap allocations per iteration
+static void BM_LNS_iterations_den520(benchmark::State& state)
+{
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen",
+                                                                  static_cast<int>(state.range(0)));
+  const int                 max_iter  = 500;
+
+  long   allocations = 0;
+  double time        = 0.0;
+  for (auto _ : state)
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(0, 60, {DESTROY_TYPE::RANDOM, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.solve();
+
+    // measure only the iterations
+    lns_settings.max_iter    = max_iter;
+    const long allocs_before = allocation_count.load();
+    Clock      clock;
+    clock.start();
+    lns.solve();
+    time += clock.end().first;
+    allocations += allocation_count.load() - allocs_before;
+  }
+  state.counters["allocations_per_iteration"] =
+      benchmark::Counter(static_cast<double>(allocations) / max_iter, benchmark::Counter::kAvgIterations);
+  state.counters["iterations_per_second"] = benchmark::Counter(static_cast<double>(max_iter) * state.iterations() / time);
+}
+BENCHMARK(BM_LNS_iterations_den520)->Arg(100)->Arg(500)->Iterations(3)->UseRealTime()->Unit(benchmark::kSecond);
+
+// Benchmark of the number of LNS iterations per second for the given number of workers, the time limit is fixed
+static void BM_LNS_threads_den520(benchmark::State& state)
+{
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", 300);
+  const double              time_limit = 5.0;
+
+  const int workers     = static_cast<int>(state.range(0));
+  int       iterations  = 0;
+  int       commits     = 0;
+  int       conflicts   = 0;
+  double    busy_time   = 0.0;
+  double    locked_time = 0.0;
+  for (auto _ : state)
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(INT_MAX, time_limit, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    lns_settings.threads = workers;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.solve();
+    iterations += lns.get_iteration_num();
+    commits += lns.get_parallel_stats().commits;
+    conflicts += lns.get_parallel_stats().conflicts;
+    busy_time += lns.get_parallel_stats().busy_time;
+    locked_time += lns.get_parallel_stats().locked_time;
+  }
+  state.counters["iterations_per_second"] =
+      benchmark::Counter(static_cast<double>(iterations) / time_limit, benchmark::Counter::kAvgIterations);
+  state.counters["commits"]   = benchmark::Counter(commits, benchmark::Counter::kAvgIterations);
+  state.counters["conflicts"] = benchmark::Counter(conflicts, benchmark::Counter::kAvgIterations);
+  if (workers > 1 && iterations > 0)
+  {
+    // the CPU time of an iteration does not depend on the number of cores, the workers run in parallel outside of the mutex
+    const double iteration_cpu = busy_time / iterations;
+    const double locked_cpu    = locked_time / iterations;
+    state.counters["cpu_ms_per_iteration"] = 1000.0 * iteration_cpu;
+    state.counters["serialized_fraction"]  = locked_cpu / iteration_cpu;
+    state.counters["iterations_per_second_on_own_cores"] = std::min(workers / iteration_cpu, 1.0 / locked_cpu);
+  }
+}
+BENCHMARK(BM_LNS_threads_den520)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Iterations(1)->UseRealTime()->Unit(benchmark::kSecond);
+
+BENCHMARK_MAIN();
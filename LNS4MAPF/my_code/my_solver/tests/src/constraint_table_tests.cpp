@@ -250,3 +250,86 @@ TEST_F(ConstraintTableTest, EdgeConstraintTableAddInvalid)
   // expect assert death
   EXPECT_DEATH(table->edge_constraint_table.add(1, 1, 2, 0), "Invalid edge constraint.");
 }
+
+// agents blocking a location at a given time and later are returned from the latest to the earliest
+TEST_F(ConstraintTableTest, BlockingAgentsSuffix)
+{
+  table->add_constraint(TimePoint(7, {10, 15}), 3);
+  table->add_constraint(TimePoint(7, {2, 4}), 0);
+  table->add_constraint(TimePoint(7, {6, 7}), 2);
+  table->add_constraint(TimePoint(7, {5, 5}), 1);
+  table->add_constraint(TimePoint(7, {8, 9}), 2);
+  table->add_constraint(TimePoint(7, {20, INT_MAX}), 3);
+
+  // the point query finds the interval containing the time, including its borders
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 4).first, 0);
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 6).first, 2);
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 16).first, -1);
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 1000).first, 3);
+
+  // the last (infinite) interval is skipped, duplicates are removed
+  EXPECT_EQ(table->get_blocking_agents(7, 0), std::vector<int>({3, 2, 1, 0}));
+  EXPECT_EQ(table->get_blocking_agents(7, 5), std::vector<int>({3, 2, 1}));
+  EXPECT_EQ(table->get_blocking_agents(7, 9), std::vector<int>({3, 2}));
+  EXPECT_EQ(table->get_blocking_agents(7, 16), std::vector<int>());
+
+  // the queries stay correct after removing a constraint from the middle
+  table->remove_constraint(TimePoint(7, {6, 7}), 2);
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 6).first, -1);
+  EXPECT_EQ(table->get_blocking_agents(7, 5), std::vector<int>({3, 2, 1}));
+  EXPECT_EQ(table->get_blocking_agents(7, 10), std::vector<int>({3}));
+}
+
+// the 16-bit storage is used for small instances and is widened once a time does not fit into it
+TEST_F(ConstraintTableTest, WidenStorage)
+{
+  EXPECT_TRUE(table->uses_narrow_storage()) << "Small instance should use the 16-bit storage.";
+
+  table->add_constraint(TimePoint(7, {2, 4}), 0);
+  table->add_constraint(TimePoint(7, {5, INT_MAX}), 1);
+  table->add_constraint(TimePoint(4, {65534, 65534}), 2);
+  EXPECT_TRUE(table->uses_narrow_storage());
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 100000).first, 1) << "Infinite interval should be preserved.";
+
+  // a time, which does not fit into 16 bits
+  table->add_constraint(TimePoint(4, {70000, INT_MAX}), 3);
+  EXPECT_FALSE(table->uses_narrow_storage()) << "The storage should be widened.";
+
+  // the constraints added before are preserved
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 3).first, 0);
+  EXPECT_EQ(table->get_blocking_agent(7, 7, 100000).first, 1);
+  EXPECT_EQ(table->get_blocking_agent(4, 4, 65534).first, 2);
+  EXPECT_EQ(table->get_blocking_agent(4, 4, 69999).first, -1);
+  EXPECT_EQ(table->get_blocking_agent(4, 4, 70000).first, 3);
+  EXPECT_EQ(table->get_last_constraint_start(4), 70000);
+  EXPECT_EQ(table->get_blocking_agents(4, 0), std::vector<int>({2}));
+}
+
+// agent counts stay sorted and correct when they spill over the inline storage and shrink back
+TEST(AgentCountsTest, SpillAndShrink)
+{
+  AgentCounts counts;
+  const std::vector<int> agents = {7, 2, 9, 0, 5, 3, 8};
+  for (const int agent : agents)
+  {
+    counts.increment(agent);
+  }
+  counts.increment(5);
+
+  ASSERT_EQ(counts.size(), agents.size());
+  EXPECT_TRUE(std::is_sorted(counts.begin(), counts.end())) << "Entries should be sorted by the agent number.";
+  EXPECT_EQ(counts.count(5), 2);
+  EXPECT_EQ(counts.count(4), 0);
+
+  // remove all agents except two
+  for (const int agent : {7, 9, 0, 5, 3})
+  {
+    counts.decrement(agent);
+  }
+  counts.decrement(5);
+
+  ASSERT_EQ(counts.size(), 2);
+  EXPECT_EQ(counts.begin()->first, 2);
+  EXPECT_EQ(std::next(counts.begin())->first, 8);
+  EXPECT_EQ(counts.count(5), 0);
+}
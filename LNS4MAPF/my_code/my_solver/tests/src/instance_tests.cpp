@@ -269,3 +269,30 @@ TEST(InstanceTest, DistanceHeuristic)
   }
 }
 
+
+// Test exit distance of the humans
+TEST(InstanceTest, ExitDistance)
+{
+  // load instance, the doors are in the top left and bottom right corners, the wall has a gap at location 12
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance =
+      std::make_unique<Instance>(base_path + "/tests/test_maps/doors_5_5.map", base_path + "/tests/test_scen/wall_5_5_scen_1.scen", 1);
+
+  // the distances to the doors are kept, the other door can be left, but not passed through
+  std::vector<int> buffer;
+  const std::vector<int>& door_distance = instance->get_exit_distance(0, buffer);
+  EXPECT_TRUE(buffer.empty()) << "Door distance is not kept";
+  EXPECT_EQ(&instance->get_exit_distance(0, buffer), &door_distance) << "Door distance is calculated again";
+  EXPECT_EQ(door_distance[0], 0);
+  EXPECT_EQ(door_distance[7], 3);
+  EXPECT_EQ(door_distance[12], 4);
+  EXPECT_EQ(door_distance[10], -1);
+  EXPECT_EQ(door_distance[24], 8);
+
+  // the distances to a free cell are calculated to the buffer
+  const std::vector<int>& free_distance = instance->get_exit_distance(12, buffer);
+  EXPECT_EQ(&free_distance, &buffer);
+  EXPECT_EQ(free_distance[12], 0);
+  EXPECT_EQ(free_distance[0], 4);
+  EXPECT_EQ(free_distance[24], 4);
+}
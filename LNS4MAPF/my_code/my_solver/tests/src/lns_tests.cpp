@@ -8,8 +8,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <climits>
+#include <tuple>
 
+#include "Computation.h"
 #include "Instance.h"
 #include "LNS.h"
 #include "SafeIntervalTable.h"
@@ -82,3 +85,544 @@ TEST(LNSDestroyRandomWalk, TabuList)
   lns.destroy_operator.apply(lns.solution);
   ASSERT_EQ(lns.solution.destroyed_paths.size(), 1);
 }
+
+// test that the statistics of the operators cover all iterations of the adaptive destroy
+TEST(LNSAdaptive, OperatorStats)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  auto         rnd_generator = std::mt19937(0);
+  LNS_settings lns_settings(200, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+  lns.solve();
+  ASSERT_TRUE(lns.solution.feasible);
+
+  int  calls             = 0;
+  long total_improvement = 0;
+  for (auto type : magic_enum::enum_values<DESTROY_TYPE>())
+  {
+    const OperatorStats& stats = lns.log.operator_stats[magic_enum::enum_index(type).value()];
+    EXPECT_LE(stats.improvements, stats.calls);
+    EXPECT_GE(stats.get_improvement_per_second(), 0.0);
+    // only the operators chosen by the adaptive destroy are used
+    if (type != DESTROY_TYPE::RANDOM && type != DESTROY_TYPE::RANDOMWALK && type != DESTROY_TYPE::INTERSECTION)
+    {
+      EXPECT_EQ(stats.calls, 0);
+    }
+    calls += stats.calls;
+    total_improvement += stats.total_improvement;
+  }
+  EXPECT_EQ(calls, lns.get_iteration_num());
+
+  // the improvements of the operators sum up to the improvement of the solution
+  auto rnd_generator_initial = std::mt19937(0);
+  LNS  lns_initial(*instance, rnd_generator_initial, nullptr, lns_settings);
+  lns_initial.find_initial_solution();
+  EXPECT_EQ(total_improvement, lns_initial.solution.sum_of_delays - lns.solution.sum_of_delays);
+}
+
+// test that the adapted neighborhood size stays within the bounds and is logged for each iteration
+TEST(LNSAdaptive, NeighborhoodSize)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (auto destroy_type : {DESTROY_TYPE::RANDOM, DESTROY_TYPE::ADAPTIVE})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(300, 30, {destroy_type, 8}, {SIPP_implementation::SIPP_mine, INFO_type::experiment, 1.0});
+    lns_settings.adaptive_neighborhood = true;
+    lns_settings.min_neighborhood_size = 4;
+    lns_settings.max_neighborhood_size = 16;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.solve();
+    ASSERT_TRUE(lns.solution.feasible);
+    EXPECT_TRUE(lns.solution.is_valid(*instance));
+
+    // the first entry belongs to the initial solution
+    ASSERT_EQ(lns.log.neighborhood_size.size(), lns.log.bsf_solution_cost.size());
+    EXPECT_EQ(lns.log.neighborhood_size.front(), 8);
+    for (int size : lns.log.neighborhood_size)
+    {
+      EXPECT_GE(size, 4);
+      EXPECT_LE(size, 16);
+    }
+    // the size changes only after whole windows of iterations
+    EXPECT_EQ(lns.log.neighborhood_size[1], 8);
+  }
+}
+
+// test that the neighborhood shrinks, when its repairs fail
+TEST(LNSAdaptive, ShrinksOnRepairFailures)
+{
+  // load instance, the dense instance makes the repairs fail for some orderings of the agents
+  int                       agent_num = 11;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/empty_5_5.map",
+                                                                  base_path + "/tests/test_scen/empty_5_5_scen_dense.scen", agent_num);
+
+  auto         rnd_generator = std::mt19937(0);
+  LNS_settings lns_settings(100, 30, {DESTROY_TYPE::RANDOM, 8}, {SIPP_implementation::SIPP_mine, INFO_type::experiment, 1.0});
+  lns_settings.adaptive_neighborhood = true;
+  lns_settings.min_neighborhood_size = 2;
+  lns_settings.max_neighborhood_size = 10;
+  lns_settings.max_repair_time       = 1e9;  // only the failures shrink the neighborhood
+  ASSERT_TRUE(lns_settings.bounded_repair) << "The infeasible repairs have to be told apart from the bounded aborts";
+  LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+  lns.solve();
+  ASSERT_TRUE(lns.solution.feasible);
+  EXPECT_TRUE(lns.solution.is_valid(*instance));
+
+  ASSERT_EQ(lns.log.neighborhood_size.size(), lns.log.bsf_solution_cost.size());
+  EXPECT_EQ(lns.log.neighborhood_size.front(), 8);
+  EXPECT_LT(*std::min_element(lns.log.neighborhood_size.begin(), lns.log.neighborhood_size.end()), 8)
+      << "The neighborhood did not shrink after the failed repairs";
+}
+
+// test that the pipelined destroy keeps the solution valid and the constraint table in sync with the solution
+TEST(LNSPipelined, ValidAndTablesInSync)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (auto destroy_type : {DESTROY_TYPE::RANDOM, DESTROY_TYPE::ADAPTIVE, DESTROY_TYPE::BLOCKED})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(200, 30, {destroy_type, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    lns_settings.pipelined_destroy = true;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.solve();
+    ASSERT_TRUE(lns.solution.feasible) << "Pipelined LNS solution is not feasible";
+    EXPECT_TRUE(lns.solution.is_valid(*instance)) << "Pipelined LNS solution is not valid";
+    EXPECT_EQ(lns.get_iteration_num(), 200);
+    if (destroy_type == DESTROY_TYPE::RANDOM)
+    {
+      continue;
+    }
+
+    // the constraint table is updated only on commits, it has to match the final paths
+    expect_tables_match(*instance, lns.solution.paths, lns.get_constraint_table());
+  }
+}
+
+// test that repairing several orderings in parallel keeps the solution valid and the reservations in sync with the solution
+TEST(LNSRepairOrderings, ValidAndTablesInSync)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (bool bounded_repair : {true, false})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(150, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    lns_settings.repair_orderings = 4;
+    lns_settings.bounded_repair   = bounded_repair;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.solve();
+    ASSERT_TRUE(lns.solution.feasible) << "LNS solution with parallel orderings is not feasible";
+    EXPECT_TRUE(lns.solution.is_valid(*instance)) << "LNS solution with parallel orderings is not valid";
+
+    // the planner of the LNS holds exactly the paths of the solution
+    expect_tables_match(*instance, lns.solution.paths, lns.planner->safe_interval_table);
+  }
+}
+
+// test that the safety checker applies only the replaced paths and keeps the reservations in sync with the solution
+TEST(LNSSafety, CheckerInSync)
+{
+  // load instance, the human uses the start and the goal of an agent, which is not part of the instance and has a safe path
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  auto         rnd_generator = std::mt19937(0);
+  LNS_settings lns_settings(200, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+  lns.safety_aware_mode = true;
+  std::tie(lns.human_start_locations, lns.safety_exit_locations) = load_human_locations(
+      base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num + 1});
+  lns.solve();
+  ASSERT_TRUE(lns.solution.feasible) << "Safety-aware LNS solution is not feasible";
+  EXPECT_TRUE(lns.solution.is_valid(*instance)) << "Safety-aware LNS solution is not valid";
+  ASSERT_NE(lns.safety_checker, nullptr);
+  EXPECT_FALSE(lns.safety_checker->has_staged());
+  const int duration = std::max(lns.solution.makespan, static_cast<int>(lns.human_paths[0].size()));
+  EXPECT_TRUE(lns.safety_checker->is_safe(lns.human_paths, lns.safety_exit_locations, duration));
+
+  // the checker holds exactly the paths of the solution
+  expect_tables_match(*instance, lns.solution.paths, lns.safety_checker->get_safe_interval_table());
+}
+
+// test that the robots planned around the reserved escape corridor do not come close to the human
+TEST(LNSSafety, CorridorReservations)
+{
+  // load instance, the human uses the start and the goal of an agent, which is not part of the instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (int initial_planners : {1, 2})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(100, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    lns_settings.safety_corridor        = true;
+    lns_settings.safety_corridor_margin = 1;
+    lns_settings.initial_planners       = initial_planners;
+    lns_settings.repair_orderings       = 2;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.safety_aware_mode = true;
+    std::tie(lns.human_start_locations, lns.safety_exit_locations) = load_human_locations(
+        base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num});
+    lns.solve();
+    ASSERT_TRUE(lns.solution.feasible) << "LNS solution with the escape corridor is not feasible";
+    EXPECT_TRUE(lns.solution.is_valid(*instance)) << "LNS solution with the escape corridor is not valid";
+    ASSERT_FALSE(lns.safety_reservations.empty());
+
+    // no robot is within the margin from the human, except at its start at time 0
+    const int width = instance->get_map_data().width;
+    for (int agent = 0; agent < agent_num; agent++)
+    {
+      Path path = timepointpath_to_path(lns.solution.paths[agent]);
+      for (int t = 1; t < static_cast<int>(lns.human_paths[0].size()); t++)
+      {
+        const int human = lns.human_paths[0][t];
+        if (human == lns.safety_exit_locations[0])
+        {
+          break;
+        }
+        const int robot    = path[std::min(t, static_cast<int>(path.size()) - 1)];
+        const int distance = std::abs(robot % width - human % width) + std::abs(robot / width - human / width);
+        EXPECT_GT(distance, 1) << "Agent " << agent << " is next to the human at time " << t;
+      }
+    }
+  }
+}
+
+// test that targeting the robots blocking the human makes an unsafe initial solution safe
+TEST(LNSSafety, SafetyDestroyRestoresSafety)
+{
+  // load instance, the human uses the start and the goal of an agent, which is not part of the instance and is unsafe initially
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (auto destroy_type : {DESTROY_TYPE::SAFETY, DESTROY_TYPE::ADAPTIVE})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(100, 30, {destroy_type, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+    lns.safety_aware_mode = true;
+    std::tie(lns.human_start_locations, lns.safety_exit_locations) = load_human_locations(
+        base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num});
+    lns.solve();
+    ASSERT_TRUE(lns.solution.feasible) << "Safety-aware LNS solution is not feasible";
+    EXPECT_TRUE(lns.solution.is_valid(*instance)) << "Safety-aware LNS solution is not valid";
+    EXPECT_TRUE(lns.solution_unsafe_steps.empty()) << "The solution is still unsafe with " << magic_enum::enum_name(destroy_type);
+
+    // the recorded safety matches the final solution
+    const int duration = std::max(lns.solution.makespan, static_cast<int>(lns.human_paths[0].size()));
+    EXPECT_TRUE(lns.safety_checker->is_safe(lns.human_paths, lns.safety_exit_locations, duration));
+
+    // the incremental checks agree with a checker built from the final solution
+    SafetyChecker fresh(*instance);
+    fresh.build(lns.solution.paths);
+    EXPECT_TRUE(fresh.is_safe(lns.human_paths, lns.safety_exit_locations, duration));
+  }
+}
+
+// test that several humans with several exits are kept safe together
+TEST(LNSSafety, MultipleHumansAndExits)
+{
+  // load instance, the humans use the starts and the goals of agents, which are not part of the instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  auto         rnd_generator = std::mt19937(0);
+  LNS_settings lns_settings(100, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+  lns.safety_aware_mode = true;
+  std::tie(lns.human_start_locations, lns.safety_exit_locations) = load_human_locations(
+      base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num, agent_num + 1});
+  lns.solve();
+  ASSERT_TRUE(lns.solution.feasible) << "Safety-aware LNS solution is not feasible";
+  EXPECT_TRUE(lns.solution.is_valid(*instance)) << "Safety-aware LNS solution is not valid";
+  ASSERT_EQ(lns.human_paths.size(), 2);
+  EXPECT_TRUE(lns.solution_unsafe_steps.empty());
+
+  // each human goes to the nearest exit
+  for (const auto& human_path : lns.human_paths)
+  {
+    ASSERT_FALSE(human_path.empty());
+    EXPECT_TRUE(human_path.back() == lns.safety_exit_locations[0] || human_path.back() == lns.safety_exit_locations[1]);
+  }
+  int duration = lns.solution.makespan;
+  for (const auto& human_path : lns.human_paths)
+  {
+    duration = std::max(duration, static_cast<int>(human_path.size()));
+  }
+  EXPECT_TRUE(lns.safety_checker->is_safe(lns.human_paths, lns.safety_exit_locations, duration));
+
+  // the timeline of the final solution agrees with the check
+  const auto timeline = lns.get_safety_timeline();
+  ASSERT_EQ(timeline.size(), 2);
+  for (size_t human = 0; human < timeline.size(); human++)
+  {
+    ASSERT_EQ(timeline[human].size(), duration);
+    for (int t = 0; t < duration; t++)
+    {
+      const SafetyStep& step = timeline[human][t];
+      EXPECT_EQ(step.location, t < static_cast<int>(lns.human_paths[human].size()) ? lns.human_paths[human][t] : lns.human_paths[human].back());
+      EXPECT_TRUE(step.reachable);
+      EXPECT_GE(step.earliest_arrival, t);
+      for (int robot : step.blocking_robots)
+      {
+        EXPECT_TRUE(robot >= 0 && robot < agent_num);
+      }
+    }
+  }
+}
+
+// test that an observed human position replans the human and keeps the solution safe
+TEST(LNSSafety, HumanUpdate)
+{
+  // load instance, the human uses the start and the goal of an agent, which is not part of the instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  auto         rnd_generator = std::mt19937(0);
+  LNS_settings lns_settings(100, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  lns_settings.human_update_budget = 10.0;
+  LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+  lns.safety_aware_mode = true;
+  std::tie(lns.human_start_locations, lns.safety_exit_locations) = load_human_locations(
+      base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num + 1});
+  lns.solve();
+  ASSERT_TRUE(lns.solution.feasible) << "Safety-aware LNS solution is not feasible";
+  ASSERT_TRUE(lns.solution_unsafe_steps.empty());
+  ASSERT_NE(lns.get_safe_solution(), nullptr);
+  EXPECT_EQ(lns.get_safe_solution()->paths, lns.solution.paths);
+
+  // invalid updates are rejected
+  EXPECT_THROW(lns.push_human_update(1, lns.human_start_locations[0], 0), std::runtime_error);
+  EXPECT_THROW(lns.push_human_update(0, lns.human_start_locations[0], -1), std::runtime_error);
+  EXPECT_THROW(lns.push_human_update(0, lns.human_start_locations[0], INT_MAX), std::runtime_error);
+
+  // the human is observed at the start of another agent, the steps before the observation are kept
+  const std::vector<int> old_path = lns.human_paths[0];
+  const int              time     = 5;
+  const int              location = load_human_locations(
+      base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num}).first[0];
+  EXPECT_FALSE(lns.process_human_updates());
+  lns.push_human_update(0, location, time);
+  EXPECT_TRUE(lns.process_human_updates());
+  ASSERT_GT(lns.human_paths[0].size(), time);
+  EXPECT_TRUE(std::equal(old_path.begin(), old_path.begin() + time, lns.human_paths[0].begin()));
+  EXPECT_EQ(lns.human_paths[0][time], location);
+  EXPECT_EQ(lns.human_paths[0].back(), lns.safety_exit_locations[0]);
+
+  // the repaired solution is valid, safe for the new path and available as the safe solution
+  EXPECT_TRUE(lns.solution.is_valid(*instance)) << "LNS solution after the human update is not valid";
+  EXPECT_TRUE(lns.solution_unsafe_steps.empty());
+  const int duration = std::max(lns.solution.makespan, static_cast<int>(lns.human_paths[0].size()));
+  EXPECT_TRUE(lns.safety_checker->is_safe(lns.human_paths, lns.safety_exit_locations, duration));
+  ASSERT_NE(lns.get_safe_solution(), nullptr);
+  EXPECT_EQ(lns.get_safe_solution()->paths, lns.solution.paths);
+  EXPECT_TRUE(lns.is_safe_solution_current());
+}
+
+// test that the safe solution is kept but marked stale, when the update budget runs out before the solution is safe for the new human path
+TEST(LNSSafety, HumanUpdateBudgetExhausted)
+{
+  // load instance, the human uses the start and the goal of an agent, which is not part of the instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  auto         rnd_generator = std::mt19937(0);
+  LNS_settings lns_settings(100, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  LNS          lns(*instance, rnd_generator, nullptr, lns_settings);
+  lns.safety_aware_mode = true;
+  std::tie(lns.human_start_locations, lns.safety_exit_locations) = load_human_locations(
+      base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num + 1});
+  lns.solve();
+  ASSERT_TRUE(lns.solution_unsafe_steps.empty());
+  ASSERT_NE(lns.get_safe_solution(), nullptr);
+
+  // the human is observed on the path of a robot, no time is left for the repair and the solution stays unsafe for the new path
+  const int time     = 3;
+  const int location = lns.solution.paths[0][time].location;
+  lns_settings.human_update_budget = 0.0;
+  lns.push_human_update(0, location, time);
+  EXPECT_TRUE(lns.process_human_updates());
+  ASSERT_FALSE(lns.solution_unsafe_steps.empty());
+  ASSERT_NE(lns.get_safe_solution(), nullptr) << "The last safe solution should stay available";
+  EXPECT_FALSE(lns.is_safe_solution_current()) << "The safe solution is unsafe for the new human path";
+
+  // the solution is published again, once it is repaired for the new path
+  lns_settings.human_update_budget = 10.0;
+  lns.push_human_update(0, location, time);
+  EXPECT_TRUE(lns.process_human_updates());
+  ASSERT_TRUE(lns.solution_unsafe_steps.empty());
+  ASSERT_NE(lns.get_safe_solution(), nullptr);
+  EXPECT_EQ(lns.get_safe_solution()->paths, lns.solution.paths);
+  EXPECT_TRUE(lns.is_safe_solution_current());
+}
+
+// test that the parallel workers keep the solution valid and never make it worse
+TEST(LNSParallel, ValidAndNotWorse)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (auto destroy_type : {DESTROY_TYPE::RANDOM, DESTROY_TYPE::ADAPTIVE})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(200, 30, {destroy_type, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+    lns_settings.threads = 4;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+
+    // the initial solution is found by the same generator
+    auto rnd_generator_initial = std::mt19937(0);
+    LNS  lns_initial(*instance, rnd_generator_initial, nullptr, lns_settings);
+    lns_initial.find_initial_solution();
+
+    lns.solve();
+    ASSERT_TRUE(lns.solution.feasible) << "Parallel LNS solution is not feasible";
+    EXPECT_TRUE(lns.solution.is_valid(*instance)) << "Parallel LNS solution is not valid";
+    EXPECT_LE(lns.solution.sum_of_costs, lns_initial.solution.sum_of_costs) << "Parallel LNS made the solution worse";
+    EXPECT_EQ(lns.get_iteration_num(), 200);
+
+    // the serialized part of the work is a part of the work of the iterations
+    const ParallelLNSStats& stats = lns.get_parallel_stats();
+    EXPECT_GT(stats.busy_time, 0.0);
+    EXPECT_GE(stats.locked_time, 0.0);
+    EXPECT_LE(stats.locked_time, stats.busy_time);
+  }
+}
+
+// test that adopting a foreign solution leaves the tables in the same state as building them from scratch
+TEST(LNSPortfolio, AdoptSolution)
+{
+  // load instance
+  int                       agent_num = 50;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  LNS_settings lns_settings(0, 5, {DESTROY_TYPE::RANDOMWALK, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  auto         rnd_generator_1 = std::mt19937(1);
+  auto         rnd_generator_2 = std::mt19937(2);
+  LNS          lns_1(*instance, rnd_generator_1, nullptr, lns_settings);
+  LNS          lns_2(*instance, rnd_generator_2, nullptr, lns_settings);
+  ASSERT_TRUE(lns_1.find_initial_solution());
+  ASSERT_TRUE(lns_2.find_initial_solution());
+  lns_2.initialize_constraint_table(lns_2.solution.paths);
+
+  // share the solution
+  SharedSolution shared;
+  EXPECT_EQ(shared.get_best(), nullptr);
+  EXPECT_TRUE(shared.publish(lns_1.solution));
+  EXPECT_EQ(shared.get_best_cost(), lns_1.solution.sum_of_costs);
+  EXPECT_FALSE(shared.publish(lns_1.solution)) << "Only better solutions should be published";
+
+  lns_2.adopt_solution(*shared.get_best());
+  EXPECT_EQ(lns_2.solution.sum_of_costs, lns_1.solution.sum_of_costs);
+
+  // compare the tables with tables built from the adopted paths
+  expect_tables_match(*instance, lns_1.solution.paths, lns_2.planner->safe_interval_table);
+  expect_tables_match(*instance, lns_1.solution.paths, lns_2.get_constraint_table());
+}
+
+// test that the portfolio returns a valid solution
+TEST(LNSPortfolio, ComputationPortfolio)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  LNS_settings lns_settings(100, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  Computation  computation(*instance, nullptr, lns_settings, 0, 4);
+  computation.run();
+  const Solution& sol = computation.get_solution();
+  ASSERT_TRUE(sol.feasible) << "Portfolio solution is not feasible";
+  EXPECT_TRUE(sol.is_valid(*instance)) << "Portfolio solution is not valid";
+}
+
+// test that the safety-aware portfolio returns a safe solution, when the initial solutions are unsafe
+TEST(LNSPortfolio, SafetyPortfolio)
+{
+  // load instance, the human uses the start and the goal of an agent, which is not part of the instance and is unsafe initially
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  LNS_settings lns_settings(100, 30, {DESTROY_TYPE::ADAPTIVE, 8}, {SIPP_implementation::SIPP_mine, INFO_type::no_info, 1.0});
+  Computation  computation(*instance, nullptr, lns_settings, 0, 4);
+  const auto [human_start_locations, exit_locations] =
+      load_human_locations(base_path + "/tests/test_maps/den520d.map", base_path + "/tests/test_scen/den520d-random-0.scen", {agent_num});
+  computation.set_safety_params(true, human_start_locations, exit_locations);
+  computation.run();
+  const Solution& sol = computation.get_solution();
+  ASSERT_TRUE(sol.feasible) << "Portfolio solution is not feasible";
+  EXPECT_TRUE(sol.is_valid(*instance)) << "Portfolio solution is not valid";
+
+  // the human can escape from every step of its path
+  auto timeline = computation.get_safety_timeline();
+  ASSERT_EQ(timeline.size(), 1);
+  ASSERT_FALSE(timeline[0].empty());
+  for (const auto& step : timeline[0])
+  {
+    EXPECT_TRUE(step.reachable) << "The portfolio solution is unsafe at " << step.location;
+  }
+}
+
+// test that the racing orderings load the winning solution to the planner
+TEST(LNSInitialRace, WinnerLoadedToPlanner)
+{
+  // load instance
+  int                       agent_num = 100;
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance  = std::make_unique<Instance>(base_path + "/tests/test_maps/den520d.map",
+                                                                  base_path + "/tests/test_scen/den520d-random-0.scen", agent_num);
+
+  for (int initial_planners : {2, 4})
+  {
+    auto         rnd_generator = std::mt19937(0);
+    LNS_settings lns_settings(50, 30, {DESTROY_TYPE::RANDOMWALK, 8}, {SIPP_implementation::SIPP_mine_ap, INFO_type::no_info, 1.0});
+    lns_settings.initial_planners = initial_planners;
+    LNS lns(*instance, rnd_generator, nullptr, lns_settings);
+    ASSERT_TRUE(lns.find_initial_solution()) << "Initial solution not found";
+    ASSERT_TRUE(lns.solution.is_valid(*instance)) << "Initial solution is not valid";
+
+    // the safe interval table must contain exactly the paths of the solution
+    expect_tables_match(*instance, lns.solution.paths, lns.planner->safe_interval_table);
+    EXPECT_EQ(static_cast<int>(lns.already_planned.size()), agent_num);
+  }
+}
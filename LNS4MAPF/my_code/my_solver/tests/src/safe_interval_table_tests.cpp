@@ -54,7 +54,7 @@ TEST_F(SafeIntervalTableTest, SingleConstraint)
   EXPECT_EQ(*first_si, TimeInterval(0, 2));
 
   // test that both the interval before and after the constraint are retrieved
-  std::list<TimeInterval>::const_iterator start, end;
+  SafeIntervalTable::const_iterator start, end;
   std::tie(start, end) = table->get_safe_intervals(7, {0, 6});
   ASSERT_EQ(std::distance(start, end), 2) << "Expected two safe intervals after adding a constraint!";
   EXPECT_EQ(*start, TimeInterval(0, 2));
@@ -78,7 +78,7 @@ TEST_F(SafeIntervalTableTest, MultipleSingleConstraints)
   // test the estimate of the maximal path len
   EXPECT_EQ(table->get_max_path_len_estimate(), 23);
 
-  std::list<TimeInterval>::const_iterator start, end;
+  SafeIntervalTable::const_iterator start, end;
   std::tie(start, end) = table->get_safe_intervals(7, {0, 20});
   ASSERT_EQ(std::distance(start, end), 3) << "Expected three safe intervals after adding multiple constraints!";
   EXPECT_EQ(*start, TimeInterval(0, 1));
@@ -100,7 +100,7 @@ TEST_F(SafeIntervalTableTest, RemoveConstraint)
   auto first_si = table->get_first_safe_interval(7);
   EXPECT_TRUE(first_si->t_min == 0 && first_si->t_max == INT_MAX);
 
-  std::list<TimeInterval>::const_iterator start, end;
+  SafeIntervalTable::const_iterator start, end;
   std::tie(start, end) = table->get_safe_intervals(7, {0, INT_MAX});
   ASSERT_EQ(std::distance(start, end), 1) << "Expected one safe interval after removing a constraint!";
   EXPECT_EQ(*start, TimeInterval(0, INT_MAX));
@@ -130,7 +130,7 @@ TEST_F(SafeIntervalTableTest, DynamicAddRemove)
   // test the estimate of the maximal path len
   EXPECT_EQ(table->get_max_path_len_estimate(), 16);
 
-  std::list<TimeInterval>::const_iterator start, end;
+  SafeIntervalTable::const_iterator start, end;
   std::tie(start, end) = table->get_safe_intervals(2, {0, 10});
   ASSERT_EQ(std::distance(start, end), 2) << "Expected two safe intervals after removal.";
   EXPECT_EQ(*start, TimeInterval(0, 5));
@@ -268,3 +268,68 @@ TEST_F(SafeIntervalTableTest, EdgeConstraintTableAddInvalid)
   EXPECT_DEATH(table->edge_constraint_table.add(1, 1, 2), "Invalid edge constraint.");
 }
 
+
+// Checking paths against the stored constraints
+TEST_F(SafeIntervalTableTest, PathFree)
+{
+  // agent moving from (0,0) to (1,0) at time 1 and resting there
+  TimePointPath path = {TimePoint(0, {0, 0}), TimePoint(1, {1, INT_MAX})};
+  EXPECT_TRUE(table->is_path_free(path));
+  table->add_constraints(path);
+
+  // the same path, a vertex collision and a swap collide
+  EXPECT_FALSE(table->is_path_free(path));
+  EXPECT_FALSE(table->is_path_free({TimePoint(2, {0, 0}), TimePoint(1, {1, 3})}));
+  EXPECT_FALSE(table->is_path_free({TimePoint(1, {0, 0}), TimePoint(0, {1, 3})}));
+
+  // passing the cell before it is occupied is free
+  EXPECT_TRUE(table->is_path_free({TimePoint(1, {0, 0}), TimePoint(2, {1, INT_MAX})}));
+
+  table->remove_constraints(path);
+  EXPECT_TRUE(table->is_path_free(path));
+}
+
+// the 16-bit storage is used first and is widened once a safe interval does not fit into it
+TEST_F(SafeIntervalTableTest, WidenStorage)
+{
+  EXPECT_TRUE(table->uses_narrow_storage()) << "The table should start with the 16-bit storage.";
+
+  table->add_constraint(TimePoint(7, {2, 4}));
+  table->add_constraint(TimePoint(7, {100, 65533}));
+  table->add_constraint(TimePoint(5, {5, INT_MAX}));
+  EXPECT_TRUE(table->uses_narrow_storage());
+  EXPECT_EQ(table->get_last_safe_interval(7), TimeInterval(65534, INT_MAX)) << "Infinite interval should be preserved.";
+
+  // the searches read the intervals through the view of the storage chosen once
+  auto viewed_intervals = [this](int location)
+  {
+    return table->visit(
+        [location](const auto& view)
+        {
+          auto [first, last] = view.get_safe_intervals(location, {0, INT_MAX});
+          return std::vector<TimeInterval>(first, last);
+        });
+  };
+  EXPECT_EQ(viewed_intervals(7), std::vector<TimeInterval>({{0, 1}, {5, 99}, {65534, INT_MAX}}));
+
+  // the safe interval after the constraint would start at the time, which stores the infinity
+  table->add_constraint(TimePoint(7, {65534, 65534}));
+  EXPECT_FALSE(table->uses_narrow_storage()) << "The storage should be widened.";
+
+  // the intervals added before are preserved
+  auto [start, end] = table->get_safe_intervals(7, {0, INT_MAX});
+  std::vector<TimeInterval> intervals(start, end);
+  EXPECT_EQ(intervals, std::vector<TimeInterval>({{0, 1}, {5, 99}, {65535, INT_MAX}}));
+  EXPECT_EQ(viewed_intervals(7), intervals);
+  EXPECT_EQ(table->get_first_free_time(5), INT_MAX);
+
+  // removing the constraints restores the unlimited interval
+  table->remove_constraint(TimePoint(7, {65534, 65534}));
+  table->remove_constraint(TimePoint(7, {100, 65533}));
+  table->remove_constraint(TimePoint(7, {2, 4}));
+  std::tie(start, end) = table->get_safe_intervals(7, {0, INT_MAX});
+  EXPECT_EQ(std::vector<TimeInterval>(start, end), std::vector<TimeInterval>({{0, INT_MAX}}));
+
+  table->reset();
+  EXPECT_TRUE(table->uses_narrow_storage()) << "The reset table should use the 16-bit storage again.";
+}
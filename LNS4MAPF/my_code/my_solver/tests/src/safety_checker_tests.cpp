@@ -0,0 +1,245 @@
+/*
+ * Description: Tests of the human safety checker.
+ */
+#include <gtest/gtest.h>
+
+#include "Instance.h"
+#include "SafetyChecker.h"
+#include "test_utils.h"
+#include "utils.h"
+
+/**
+ * @brief Class for testing the SafetyChecker class, the map has a wall with a single gap at location 12 between the rows 1 and 3.
+ */
+class SafetyCheckerTest : public ::testing::Test
+{
+protected:
+  std::unique_ptr<Instance>      instance;
+  std::unique_ptr<SafetyChecker> checker;
+  const int                      exit_location = 20; /**< The bottom left corner. */
+
+  void SetUp() override
+  {
+    // load instance
+    std::string base_path = get_base_path_tests();  // path to my_solver
+
+    instance =
+        std::make_unique<Instance>(base_path + "/tests/test_maps/wall_5_5.map", base_path + "/tests/test_scen/wall_5_5_scen_1.scen", 1);
+    checker = std::make_unique<SafetyChecker>(*instance);
+  }
+
+  /**
+   * @brief Finds the unsafe steps of a single human escaping to the exit.
+   */
+  auto get_unsafe_steps(const std::vector<int>& human_path, int duration, bool stop_at_first) -> std::vector<int>
+  {
+    return checker->get_unsafe_steps({human_path}, {exit_location}, duration, stop_at_first).front();
+  }
+
+  /**
+   * @brief Checks whether a single human can escape to the exit.
+   */
+  auto is_safe(const std::vector<int>& human_path, int duration) -> bool
+  {
+    return checker->is_safe({human_path}, {exit_location}, duration);
+  }
+};
+
+// the robot leaves the gap, so the human can wait and escape later
+TEST_F(SafetyCheckerTest, OpenGap)
+{
+  checker->build({path_to_timepointpath({12, 12, 12, 12, 12, 12, 17, 22})});
+  EXPECT_TRUE(get_unsafe_steps({0}, 20, false).empty());
+  EXPECT_TRUE(get_unsafe_steps({0, 1, 2, 7}, 20, false).empty());
+}
+
+// the robot rests in the gap, the human can escape only from below the wall
+TEST_F(SafetyCheckerTest, BlockedGap)
+{
+  checker->build({path_to_timepointpath({12})});
+  EXPECT_EQ(get_unsafe_steps({0}, 5, false), std::vector<int>({0, 1, 2, 3, 4}));
+  EXPECT_EQ(get_unsafe_steps({0}, 5, true), std::vector<int>({0}));
+  EXPECT_TRUE(is_safe({19, 18, 17, 16, 15}, 10));
+}
+
+// the robot closes the gap at time 2, the only escape through the gap would swap the cells with the robot
+TEST_F(SafetyCheckerTest, SwapWithRobot)
+{
+  checker->build({path_to_timepointpath({22, 17, 12})});
+  EXPECT_EQ(get_unsafe_steps({7}, 3, false), std::vector<int>({0, 1, 2}));
+
+  // the human below the wall has to leave the cell before the robot enters it
+  EXPECT_TRUE(is_safe({17}, 1));
+  EXPECT_EQ(get_unsafe_steps({17}, 2, false), std::vector<int>({1}));
+  EXPECT_TRUE(is_safe({17, 16}, 5));
+}
+
+// the escape route ignores the robots and goes through the gap, one move per timestep
+TEST_F(SafetyCheckerTest, EscapeRoute)
+{
+  checker->build({path_to_timepointpath({12})});
+  TimePointPath route = checker->get_escape_route(0, 3, {exit_location});
+  ASSERT_EQ(route.size(), 9);
+  EXPECT_EQ(route.front(), TimePoint(0, {3, 3}));
+  EXPECT_EQ(route[4], TimePoint(12, {7, 7}));
+  EXPECT_EQ(route.back(), TimePoint(exit_location, {11, 11}));
+}
+
+// the timeline holds the earliest arrival to the exit of each step
+TEST_F(SafetyCheckerTest, Timeline)
+{
+  checker->build({path_to_timepointpath({12})});
+  auto timeline = checker->get_timeline({{0}, {19, 18}}, {exit_location}, 3);
+  ASSERT_EQ(timeline.size(), 2);
+  ASSERT_EQ(timeline[0].size(), 3);
+  ASSERT_EQ(timeline[1].size(), 3);
+  for (const auto& step : timeline[0])
+  {
+    EXPECT_EQ(step.location, 0);
+    EXPECT_FALSE(step.reachable);
+    EXPECT_EQ(step.earliest_arrival, -1);
+  }
+  EXPECT_TRUE(timeline[1][0].reachable);
+  EXPECT_EQ(timeline[1][0].earliest_arrival, 5);
+  EXPECT_EQ(timeline[1][1].location, 18);
+  EXPECT_EQ(timeline[1][1].earliest_arrival, 5);
+  EXPECT_EQ(timeline[1][2].earliest_arrival, 6);
+
+  // the human waits until the robot leaves the gap and then follows it, the robot rests below the gap
+  checker->build({path_to_timepointpath({12, 12, 12, 12, 12, 12, 17, 22})});
+  timeline = checker->get_timeline({{7}}, {exit_location}, 1);
+  EXPECT_EQ(timeline[0][0].earliest_arrival, 10);
+}
+
+// the staged paths are used by the check until they are rolled back
+TEST_F(SafetyCheckerTest, StageAndRollback)
+{
+  Solution sol;
+  sol.paths    = {path_to_timepointpath({22, 17, 16, 15})};
+  sol.feasible = true;
+  checker->build(sol.paths);
+  EXPECT_TRUE(is_safe({0}, 10));
+
+  // the robot is moved to the gap
+  SolutionOverlay  overlay(sol);
+  std::vector<int> destroyed = {0};
+  overlay.reset(destroyed);
+  overlay.new_paths[0] = path_to_timepointpath({22, 17, 12});
+  overlay.feasible     = true;
+  checker->stage(overlay);
+  EXPECT_TRUE(checker->has_staged());
+  EXPECT_FALSE(is_safe({0}, 10));
+
+  checker->rollback(overlay);
+  EXPECT_FALSE(checker->has_staged());
+  EXPECT_TRUE(is_safe({0}, 10));
+}
+
+// the results kept from the previous checks agree with a checker built from scratch, both with the searches and with the sweep
+TEST_F(SafetyCheckerTest, IncrementalCheck)
+{
+  const std::vector<std::vector<int>> human_paths = {{0}, {19, 18}};
+  auto check_from_scratch = [&](const TimePointPath& path, int duration)
+  {
+    SafetyChecker fresh(*instance);
+    fresh.build({path});
+    return fresh.get_unsafe_steps(human_paths, {exit_location}, duration, false);
+  };
+
+  for (int duration : {10, 100})
+  {
+    // the robot waits below the wall, then it moves to the gap and back
+    Solution sol;
+    sol.paths    = {path_to_timepointpath({22})};
+    sol.feasible = true;
+    checker->build(sol.paths);
+    EXPECT_EQ(checker->get_unsafe_steps(human_paths, {exit_location}, duration, false), check_from_scratch(sol.paths[0], duration));
+
+    for (const auto& new_path : {path_to_timepointpath({22, 17, 12}), path_to_timepointpath({22, 17, 12, 12, 12, 17, 22})})
+    {
+      SolutionOverlay  overlay(sol);
+      std::vector<int> destroyed = {0};
+      overlay.reset(destroyed);
+      overlay.new_paths[0] = new_path;
+      overlay.feasible     = true;
+      checker->stage(overlay);
+      const auto expected = check_from_scratch(new_path, duration);
+      EXPECT_EQ(checker->get_unsafe_steps(human_paths, {exit_location}, duration, false), expected);
+
+      // the committed results are kept, the human below the wall is not influenced by the robot
+      checker->commit();
+      EXPECT_EQ(checker->get_unsafe_steps(human_paths, {exit_location}, duration, false), expected);
+      EXPECT_TRUE(expected[1].empty());
+      sol.paths[0] = new_path;
+    }
+  }
+}
+
+// the checkers evaluating the steps by several threads agree with the serial one, also when they stop at the first unsafe step
+TEST_F(SafetyCheckerTest, ParallelMatchesSerial)
+{
+  const std::vector<std::vector<int>> human_paths = {{19, 18}, {7, 2, 1}, {0}, {17, 16}};
+  const std::vector<TimePointPath>    paths       = {path_to_timepointpath({22, 17, 12}), path_to_timepointpath({3, 8})};
+  checker->build(paths);
+
+  // the searches are used for the short duration, the sweep for the long one
+  for (int duration : {10, 100})
+  {
+    const auto expected       = checker->get_unsafe_steps(human_paths, {exit_location}, duration, false);
+    const auto expected_first = checker->get_unsafe_steps(human_paths, {exit_location}, duration, true);
+    const auto expected_steps = checker->get_timeline(human_paths, {exit_location}, duration);
+    ASSERT_FALSE(expected[2].empty()) << "The human above the wall should be unsafe.";
+    for (int num_threads : {2, 4})
+    {
+      SafetyChecker parallel(*instance, num_threads);
+      parallel.build(paths);
+      EXPECT_EQ(parallel.get_unsafe_steps(human_paths, {exit_location}, duration, true), expected_first);
+      EXPECT_EQ(parallel.get_unsafe_steps(human_paths, {exit_location}, duration, false), expected);
+      EXPECT_EQ(parallel.is_safe(human_paths, {exit_location}, duration), false);
+      const auto timeline = parallel.get_timeline(human_paths, {exit_location}, duration);
+      ASSERT_EQ(timeline.size(), expected_steps.size());
+      for (size_t human = 0; human < timeline.size(); human++)
+      {
+        ASSERT_EQ(timeline[human].size(), expected_steps[human].size());
+        for (size_t t = 0; t < timeline[human].size(); t++)
+        {
+          EXPECT_EQ(timeline[human][t].location, expected_steps[human][t].location);
+          EXPECT_EQ(timeline[human][t].earliest_arrival, expected_steps[human][t].earliest_arrival);
+        }
+      }
+    }
+  }
+}
+
+// all humans and exits are evaluated together, each human escapes to the nearest reachable exit
+TEST_F(SafetyCheckerTest, MultipleHumansAndExits)
+{
+  checker->build({path_to_timepointpath({12})});
+  const std::vector<std::vector<int>> human_paths = {{0}, {19}};
+  EXPECT_EQ(checker->get_unsafe_steps(human_paths, {exit_location}, 5, false), std::vector<std::vector<int>>({{0, 1, 2, 3, 4}, {}}));
+  EXPECT_FALSE(checker->is_safe(human_paths, {exit_location}, 5));
+
+  // the human above the wall can leave through the top right corner
+  EXPECT_EQ(checker->get_unsafe_steps(human_paths, {exit_location, 4}, 5, false), std::vector<std::vector<int>>({{}, {}}));
+  EXPECT_TRUE(checker->is_safe(human_paths, {exit_location, 4}, 5));
+  TimePointPath route = checker->get_escape_route(0, 0, {exit_location, 4});
+  ASSERT_EQ(route.size(), 5);
+  EXPECT_EQ(route.back().location, 4);
+}
+
+// the human can escape through the doors, which can not be passed through otherwise
+TEST(SafetyChecker, DoorExits)
+{
+  std::string base_path = get_base_path_tests();  // path to my_solver
+  Instance    instance(base_path + "/tests/test_maps/doors_5_5.map", base_path + "/tests/test_scen/wall_5_5_scen_1.scen", 1);
+  SafetyChecker checker(instance);
+  checker.build({path_to_timepointpath({12})});
+
+  // the door at the top left corner is reachable from above the wall, the one at the bottom right is not
+  EXPECT_TRUE(checker.is_safe({{7}}, {0}, 5));
+  EXPECT_FALSE(checker.is_safe({{7}}, {24}, 5));
+  EXPECT_TRUE(checker.is_safe({{7}}, {0, 24}, 5));
+  TimePointPath route = checker.get_escape_route(7, 0, {0, 24});
+  ASSERT_EQ(route.size(), 4);
+  EXPECT_EQ(route.back().location, 0);
+}
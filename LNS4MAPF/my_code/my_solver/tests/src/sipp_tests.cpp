@@ -219,6 +219,75 @@ TEST(SIPPTest, DynamicObstacleAtGoal)
   }
 }
 
+// Goal occupied forever by a resting agent, the planning has to fail without search
+TEST(SIPPTest, GoalPermanentlyOccupied)
+{
+  // load instance
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance =
+      std::make_unique<Instance>(base_path + "/tests/test_maps/empty_5_5.map", base_path + "/tests/test_scen/empty_5_5_scen_1.scen", 1);
+
+  // create SIPP
+  for (auto algo : magic_enum::enum_values<SIPP_implementation>())
+  {
+    std::mt19937  rnd_generator(0);
+    SIPP_settings sipp_settings(algo, INFO_type::experiment, 1.0);
+    SIPP          sipp(*instance, rnd_generator, sipp_settings);
+
+    // another agent rests at the goal from time 20
+    const TimePoint resting(instance->get_goal_locations()[0], {20, INT_MAX});
+    sipp.safe_interval_table.add_constraint(resting);
+    EXPECT_TRUE(sipp.safe_interval_table.is_permanently_occupied(resting.location));
+    EXPECT_EQ(sipp.safe_interval_table.get_first_free_time(resting.location), INT_MAX);
+
+    // no path and no node expanded
+    EXPECT_TRUE(sipp.plan(0, {}).empty()) << "SIPP should not find a path to a permanently occupied goal!";
+    EXPECT_EQ(sipp.generated_this_iter, 0) << "SIPP should not search when the goal is permanently occupied!";
+
+    // the failure is not caused by the arrival bound
+    EXPECT_TRUE(sipp.plan(0, {}, 100).empty());
+    EXPECT_FALSE(sipp.bound_pruned) << "The arrival bound did not cut the search!";
+
+    // the goal is free again after the agent leaves
+    sipp.safe_interval_table.remove_constraint(resting);
+    EXPECT_FALSE(sipp.safe_interval_table.is_permanently_occupied(resting.location));
+    EXPECT_EQ(sipp.safe_interval_table.get_first_free_time(resting.location), 0);
+    EXPECT_EQ(sipp.plan(0, {}).size(), 9);
+  }
+}
+
+TEST(SIPPTest, ArrivalBound)
+{
+  // load instance
+  std::string               base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr<Instance> instance =
+      std::make_unique<Instance>(base_path + "/tests/test_maps/empty_5_5.map", base_path + "/tests/test_scen/empty_5_5_scen_1.scen", 1);
+
+  // create SIPP
+  for (auto algo : magic_enum::enum_values<SIPP_implementation>())
+  {
+    std::mt19937  rnd_generator(0);
+    SIPP_settings sipp_settings(algo, INFO_type::experiment, 1.0);
+    SIPP          sipp(*instance, rnd_generator, sipp_settings);
+
+    // the shortest path reaches the goal at time 8
+    EXPECT_TRUE(sipp.plan(0, {}, 7).empty()) << "SIPP should not find a path arriving after the bound!";
+    EXPECT_TRUE(sipp.bound_pruned) << "The arrival bound cut the search!";
+    TimePointPath path = sipp.plan(0, {}, 8);
+    ASSERT_FALSE(path.empty());
+    EXPECT_EQ(path.back().interval.t_min, 8);
+
+    // another agent passes the goal at time 8, the agent has to wait
+    const TimePoint passing(instance->get_goal_locations()[0], {8, 8});
+    sipp.safe_interval_table.add_constraint(passing);
+    EXPECT_TRUE(sipp.plan(0, {}, 8).empty()) << "SIPP should not find a path arriving after the bound!";
+    EXPECT_TRUE(sipp.bound_pruned) << "The arrival bound cut the search!";
+    path = sipp.plan(0, {}, 9);
+    ASSERT_FALSE(path.empty());
+    EXPECT_EQ(path.back().interval.t_min, 9);
+  }
+}
+
 // test that SIPP takes into account the edge constraints
 // Edge constraints at the goal
 TEST(SIPPTest, EdgeConstraintsAtGoal)
@@ -297,3 +297,76 @@ TEST(SolutionTest, LargeInstanceValid)
   EXPECT_TRUE(sol.is_valid(*instance));
 }
 
+
+// Test Case 14: The overlay replaces the paths only on commit
+TEST(SolutionTest, OverlayCommit)
+{
+  // load instance
+  std::string     base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr instance =
+      std::make_unique<Instance>(base_path + "/tests/test_maps/dummy_3_3.map", base_path + "/tests/test_scen/dummy_3_3_scen_1.scen", 2);
+
+  Solution sol;
+  sol.paths = {
+      path_to_timepointpath({0, 1, 2, 5, 8}),    // Agent 1
+      path_to_timepointpath({8, 8, 7, 6, 3, 0})  // Agent 2 waits at the start
+  };
+  sol.calculate_cost(*instance);
+  const int old_cost = sol.sum_of_costs;
+
+  // replan the second agent without the wait
+  SolutionOverlay  overlay(sol);
+  std::vector<int> destroyed = {1};
+  overlay.reset(destroyed);
+  EXPECT_TRUE(destroyed.empty());
+  EXPECT_FALSE(overlay.feasible);
+  overlay.new_paths[0] = path_to_timepointpath({8, 7, 6, 3, 0});
+  overlay.feasible     = true;
+  EXPECT_EQ(overlay.get_improvement(), 1);
+
+  // the base solution is not modified before the commit
+  Solution materialized = overlay.to_solution(*instance);
+  EXPECT_TRUE(materialized.is_valid(*instance));
+  EXPECT_EQ(materialized.sum_of_costs, old_cost - 1);
+  EXPECT_EQ(overlay.get_makespan(), materialized.makespan);
+  EXPECT_EQ(sol.sum_of_costs, old_cost);
+  EXPECT_EQ(timepointpath_to_path(sol.paths[1]).size(), 6);
+
+  // the commit swaps the paths
+  overlay.commit(sol, *instance);
+  EXPECT_EQ(sol.sum_of_costs, old_cost - 1);
+  EXPECT_EQ(timepointpath_to_path(sol.paths[1]).size(), 5);
+  EXPECT_EQ(timepointpath_to_path(overlay.new_paths[0]).size(), 6);
+  EXPECT_TRUE(sol.is_valid(*instance));
+}
+
+// Test Case 15: The incrementally updated cost matches the recalculated cost
+TEST(SolutionTest, IncrementalCost)
+{
+  // load instance
+  std::string     base_path = get_base_path_tests();  // path to my_solver
+  std::unique_ptr instance =
+      std::make_unique<Instance>(base_path + "/tests/test_maps/dummy_3_3.map", base_path + "/tests/test_scen/dummy_3_3_scen_1.scen", 2);
+
+  Solution sol;
+  sol.paths = {
+      path_to_timepointpath({0, 1, 2, 5, 8}),  // Agent 1
+      path_to_timepointpath({8, 7, 6, 3, 0})   // Agent 2
+  };
+  sol.calculate_cost(*instance);
+
+  // the replaced paths increase and then decrease the makespan
+  std::vector<TimePointPath> new_paths = {path_to_timepointpath({8, 8, 8, 7, 6, 3, 0}), path_to_timepointpath({8, 7, 6, 3, 0})};
+  for (auto& path : new_paths)
+  {
+    sol.replace_path(1, path, *instance);
+    Solution recalculated = sol;
+    recalculated.calculate_cost(*instance);
+    EXPECT_EQ(sol.sum_of_costs, recalculated.sum_of_costs);
+    EXPECT_EQ(sol.sum_of_delays, recalculated.sum_of_delays);
+    EXPECT_EQ(sol.makespan, recalculated.makespan);
+    EXPECT_EQ(sol.delays, recalculated.delays);
+  }
+  EXPECT_EQ(sol.makespan, 4);
+  EXPECT_EQ(timepointpath_to_path(new_paths[0]).size(), 5);
+}
@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <climits>
 #include <filesystem>
 
@@ -54,11 +55,11 @@ TimePointPath generate_random_timepointpath(int len_wanted)
   return tp_path;
 }
 
-auto filter_time_intervals(std::pair<std::list<TimeInterval>::const_iterator, std::list<TimeInterval>::const_iterator> start_goal,
+auto filter_time_intervals(std::pair<SafeIntervalTable::const_iterator, SafeIntervalTable::const_iterator> start_goal,
                            TimeInterval interval, int from, int to, SafeIntervalTable& table) -> std::vector<TimeInterval>
 {
-  std::list<TimeInterval>::const_iterator start;
-  std::list<TimeInterval>::const_iterator end;
+  SafeIntervalTable::const_iterator start;
+  SafeIntervalTable::const_iterator end;
   std::tie(start, end) = start_goal;
   std::vector<TimeInterval> ret;
 
@@ -114,3 +115,43 @@ auto find_path_distance_gradient(int agent_num, const Instance& instance) -> Pat
   return ret;
 }
 
+void expect_tables_match(const Instance& instance, const std::vector<TimePointPath>& paths, const SafeIntervalTable& table)
+{
+  SafeIntervalTable expected_sit(instance);
+  expected_sit.build_sequential(paths);
+  for (int i = 0; i < instance.get_num_free_cells(); i++)
+  {
+    const int location                  = instance.free_location_to_location(i);
+    auto [expected_start, expected_end] = expected_sit.get_safe_intervals(location, {0, INT_MAX});
+    auto [start, end]                   = table.get_safe_intervals(location, {0, INT_MAX});
+    ASSERT_TRUE(std::equal(expected_start, expected_end, start, end)) << "Different safe intervals at " << location;
+  }
+}
+
+void expect_tables_match(const Instance& instance, const std::vector<TimePointPath>& paths, const ConstraintTable& table)
+{
+  ConstraintTable expected_ct(instance);
+  expected_ct.build_sequential(paths);
+  for (int i = 0; i < instance.get_num_free_cells(); i++)
+  {
+    const auto& expected_counts = expected_ct.get_agents_counts_free(i);
+    const auto& counts          = table.get_agents_counts_free(i);
+    ASSERT_TRUE(std::equal(expected_counts.begin(), expected_counts.end(), counts.begin(), counts.end()))
+        << "Different agent counts at " << instance.free_location_to_location(i);
+  }
+}
+
+auto load_human_locations(const std::string& map_path, const std::string& scen_path, const std::vector<int>& agents)
+    -> std::pair<std::vector<int>, std::vector<int>>
+{
+  // the instance has to load all agents up to the last used one
+  const int max_agent = *std::max_element(agents.begin(), agents.end());
+  Instance  human_instance(map_path, scen_path, max_agent + 1);
+  std::pair<std::vector<int>, std::vector<int>> locations;
+  for (int agent : agents)
+  {
+    locations.first.push_back(human_instance.get_start_locations()[agent]);
+    locations.second.push_back(human_instance.get_goal_locations()[agent]);
+  }
+  return locations;
+}